@@ -0,0 +1,18 @@
+#version 430 core
+
+//2 vertex line
+layout(std430) readonly buffer block1
+{
+    vec4 data[];
+    //[0] = (x, y, z, w)
+    //[1] = color
+};
+
+flat in int idx;
+
+out vec4 frag_color;
+
+void main()
+{
+    frag_color = data[idx+1];
+}
@@ -0,0 +1,15 @@
+#version 430 core
+
+layout(std430) readonly buffer block1
+{
+    vec4 data[];
+};
+
+flat in int idx;
+
+out vec4 frag_color;
+
+void main()
+{   
+    frag_color = data[idx+1];
+}
@@ -0,0 +1,701 @@
+#include "geo2/benchmark.h"
+#include "geo2/game.h"
+#include "geo2/collision_engine1.h"
+#include "geo2/ceng1_grid_broadphase.h"
+#include "geo2/ceng1_sweep_and_prune.h"
+#include "geo2/ceng1_contact_table.h"
+#include "geo2/map_obj_slot_map.h"
+#include "geo2/map_obj/wall_type1/monochromatic_wall_1.h"
+#include "geo2/render_op.h"
+#include "geo2/timer.h"
+#include "geo2/rng.h"
+#include "geo2/multithread/thread_pool.h"
+#include "geo2/multithread/fork_join_phases.h"
+
+#include "kx/io.h"
+#include "kx/log.h"
+#include "kx/util.h"
+#include "kx/atomic/queue.h"
+#include "kx/atomic/stack.h"
+#include "kx/atomic/lock_free_queue.h"
+#include "kx/atomic/lock_free_stack.h"
+
+#include <SDL2/SDL_scancode.h>
+#include <SDL2/SDL_mouse.h>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <future>
+#include <thread>
+#include <memory>
+#include <array>
+#include <stdexcept>
+#include <cstdint>
+
+namespace geo2 {
+
+struct BroadphaseBackend
+{
+    const char *name;
+    std::function<std::unique_ptr<CEng1Broadphase>()> make;
+};
+const BroadphaseBackend BROADPHASE_BACKENDS[]
+{
+    {"RebuildEachTick", []{return std::make_unique<CEng1GridBroadphase>(
+                                  CEng1GridBroadphase::GridMode::RebuildEachTick);}},
+    {"Persistent", []{return std::make_unique<CEng1GridBroadphase>(
+                             CEng1GridBroadphase::GridMode::Persistent);}},
+    {"SweepAndPrune", []{return std::make_unique<CEng1SweepAndPrune>();}}
+};
+
+///the ThreadPool we had before the work-stealing one, kept here to compare against
+class FutureThreadPool final
+{
+    struct Task
+    {
+        std::promise<void> ret;
+        std::function<void()> task_fn;
+    };
+    std::vector<std::thread> threads;
+    kx::AtomicQueue<Task> tasks;
+
+    void run_thread()
+    {
+        while(true) {
+            ///a null function is the quit signal
+            auto task = tasks.poll_blocking();
+            if(!task.task_fn)
+                break;
+            task.task_fn();
+            task.ret.set_value();
+        }
+    }
+public:
+    FutureThreadPool(int n):
+        threads(n)
+    {
+        for(auto &thread: threads)
+            thread = std::thread([this]{run_thread();});
+    }
+    ~FutureThreadPool()
+    {
+        for(size_t i=0; i<threads.size(); i++)
+            tasks.push({{}, {}});
+        for(auto &thread: threads)
+            thread.join();
+    }
+    std::future<void> add_task(const std::function<void()> &to_add)
+    {
+        std::promise<void> ret;
+        auto fut = ret.get_future();
+        tasks.push({std::move(ret), to_add});
+        return fut;
+    }
+};
+
+///GameBenchmark is a friend of Game, so it can run a Game without a window
+class GameBenchmark final
+{
+    static constexpr double TICK_LEN = 1.0 / 1440.0;
+    static constexpr int WARMUP_TICKS = 100;
+
+    struct RecordedTickConfig
+    {
+        const char *name;
+        LevelName level_name;
+        int num_shooting_ticks;
+        int num_runs;
+    };
+    static constexpr RecordedTickConfig RECORDED_TICK_CONFIGS[]{{"Test2(40, 40)", LevelName::Test2, 300, 50},
+                                                                {"Test3", LevelName::Test3, 3000, 500}};
+
+    static void tick(Game *game, kx::gfx::mouse_state_t mouse_state, bool run_rest);
+    ///the player shoots for a while first so that projectiles are spread out over the level
+    static void record_tick(Game *game, const RecordedTickConfig &config);
+    ///returns the average time per call in us
+    static double time_find_collisions(Game *game, int num_runs,
+                                       std::vector<CEng1Collision> *collisions);
+public:
+    ///returns the average time per tick in us
+    static double time_ticks(LevelName level_name,
+                             const BroadphaseBackend &backend,
+                             int num_ticks);
+    static void collision_grid();
+    ///runs every backend on the same (recorded) tick
+    static void broadphase();
+    ///compares collision layers to calling collision_could_matter() for every pair
+    static void collision_filter();
+    ///how long it takes to hand every thread an empty task and wait for all of them
+    static void thread_pool();
+    ///how long each phase of a tick takes, with the workers kept awake like in Game::run,
+    ///and how many polygons there are at the end
+    static void tick_phases();
+    ///every thread pushes and pops as fast as it can, for 1 to hardware_concurrency() threads
+    static void atomic_containers();
+    ///Polygon::has_edge_crossing() vs has_collision_sat() on regular polygons whose AABBs
+    ///overlap, for each pair of sizes, and has_collision() vs has_collision_many() for one
+    ///polygon against a crowded cell
+    static void narrowphase();
+    ///adding a screen's worth of render ops to the arena, then sorting and batching them;
+    ///this is the CPU side of RenderSceneGraph::render_and_clear(), so it needs no window
+    static void render_ops();
+    ///recording the contacts of a crowd every tick, and whether contacts are remembered
+    ///for as long as both objects are in the level, however long ago they were
+    static void contact_table();
+};
+
+void GameBenchmark::tick(Game *game, kx::gfx::mouse_state_t mouse_state, bool run_rest)
+{
+    static std::array<uint8_t, SDL_NUM_SCANCODES> keyboard_state{};
+
+    auto cursor_pos = game->player->get_position() + MapVec(1, 0);
+    if(run_rest) {
+        game->advance_one_tick(TICK_LEN, cursor_pos, mouse_state, keyboard_state.data());
+    } else {
+        //everything up to the collision engine
+        game->run_player(TICK_LEN, cursor_pos, mouse_state, keyboard_state.data());
+        game->run1(TICK_LEN);
+        game->prepare_collision_engine();
+    }
+}
+double GameBenchmark::time_ticks(LevelName level_name,
+                                 const BroadphaseBackend &backend,
+                                 int num_ticks)
+{
+    Game game({});
+    game.collision_engine->set_broadphase(backend.make());
+    game.generate_and_start_level(level_name);
+
+    for(int i=0; i<WARMUP_TICKS; i++)
+        tick(&game, 0, true);
+
+    Timer timer;
+    timer.start();
+    for(int i=0; i<num_ticks; i++)
+        tick(&game, 0, true);
+    return timer.elapsed_ns() / (1000.0 * num_ticks);
+}
+void GameBenchmark::collision_grid()
+{
+    struct Config
+    {
+        const char *name;
+        LevelName level_name;
+        int num_ticks;
+    };
+    const Config configs[]{{"Test2(40, 40)", LevelName::Test2, 500},
+                           {"Test3", LevelName::Test3, 5000}};
+
+    for(const auto &config: configs) {
+        std::string line = std::string(config.name) + ": ";
+        for(const auto &backend: BROADPHASE_BACKENDS) {
+            if(&backend != BROADPHASE_BACKENDS)
+                line += ", ";
+            auto us = time_ticks(config.level_name, backend, config.num_ticks);
+            line += kx::to_str(us) + "us/tick (" + backend.name + ")";
+        }
+        kx::io::println(line);
+    }
+}
+void GameBenchmark::record_tick(Game *game, const RecordedTickConfig &config)
+{
+    const kx::gfx::mouse_state_t shooting = SDL_BUTTON(SDL_BUTTON_LEFT);
+
+    game->generate_and_start_level(config.level_name);
+    for(int i=0; i<config.num_shooting_ticks; i++)
+        tick(game, shooting, true);
+    //stop right before the collision engine
+    tick(game, shooting, false);
+}
+double GameBenchmark::time_find_collisions(Game *game, int num_runs,
+                                           std::vector<CEng1Collision> *collisions)
+{
+    //find_collisions() doesn't modify ceng_data, so every call sees the same tick
+    Timer timer;
+    timer.start();
+    *collisions = game->collision_engine->find_collisions();
+    for(int i=1; i<num_runs; i++)
+        game->collision_engine->find_collisions();
+    return timer.elapsed_ns() / (1000.0 * num_runs);
+}
+void GameBenchmark::broadphase()
+{
+    for(const auto &config: RECORDED_TICK_CONFIGS) {
+        Game game({});
+        record_tick(&game, config);
+
+        std::vector<CEng1Collision> expected;
+        kx::io::println(std::string(config.name) + " (" + kx::to_str(game.ceng_data.size()) +
+                        " objects):");
+        for(const auto &backend: BROADPHASE_BACKENDS) {
+            game.collision_engine->set_broadphase(backend.make());
+
+            std::vector<CEng1Collision> collisions;
+            double first_us = time_find_collisions(&game, 1, &collisions);
+            double avg_us = time_find_collisions(&game, config.num_runs, &collisions);
+
+            if(expected.empty())
+                expected = collisions;
+            bool same = collisions.size() == expected.size() &&
+                        std::equal(collisions.begin(), collisions.end(), expected.begin(),
+                                   [](const CEng1Collision &a, const CEng1Collision &b) -> bool
+                                   {
+                                       return a.idx1 == b.idx1 && a.idx2 == b.idx2;
+                                   });
+            if(!same)
+                kx::log_error(std::string(backend.name) + " found different collisions");
+
+            kx::io::println(std::string("    ") + backend.name + ": " +
+                            kx::to_str(first_us) + "us (first tick), " +
+                            kx::to_str(avg_us) + "us (same tick again), " +
+                            kx::to_str(collisions.size()) + " collisions");
+        }
+    }
+}
+void GameBenchmark::collision_filter()
+{
+    for(const auto &config: RECORDED_TICK_CONFIGS) {
+        Game game({});
+        record_tick(&game, config);
+
+        std::vector<CEng1Collision> collisions;
+        time_find_collisions(&game, 1, &collisions);
+        double layers_us = time_find_collisions(&game, config.num_runs, &collisions);
+        size_t layers_num_collisions = collisions.size();
+
+        //this is what happened before there were layers: every pair whose AABBs overlap
+        //calls MapObject::collision_could_matter() through map_objs
+        CEng1CollisionFilter everything(CEng1CollisionFilter::ALL_LAYERS | CEng1CollisionFilter::CUSTOM_CHECK,
+                                        CEng1CollisionFilter::ALL_LAYERS);
+        for(auto &data: game.ceng_data)
+            data.set_collision_filter(everything);
+        //the static grid has copies of the filters; setting a broadphase rebuilds it
+        game.collision_engine->set_broadphase(std::make_unique<CEng1GridBroadphase>(
+                                              CEng1GridBroadphase::GridMode::Persistent));
+        time_find_collisions(&game, 1, &collisions);
+        double custom_us = time_find_collisions(&game, config.num_runs, &collisions);
+
+        kx::io::println(std::string(config.name) + ": " +
+                        kx::to_str(layers_us) + "us (layers, " +
+                        kx::to_str(layers_num_collisions) + " collisions), " +
+                        kx::to_str(custom_us) + "us (collision_could_matter() for every pair, " +
+                        kx::to_str(collisions.size()) + " collisions)");
+    }
+}
+
+void GameBenchmark::thread_pool()
+{
+    //what run1, find_collisions and run3 do every tick: one part per thread
+    constexpr int NUM_DISPATCHES = 100000;
+    int num_threads = std::thread::hardware_concurrency();
+    std::vector<int> touched(num_threads);
+
+    {
+        FutureThreadPool pool(num_threads - 1);
+        std::vector<std::future<void>> is_done(num_threads);
+        Timer timer;
+        timer.start();
+        for(int i=0; i<NUM_DISPATCHES; i++) {
+            for(int t=1; t<num_threads; t++)
+                is_done[t] = pool.add_task([&touched, t]{touched[t]++;});
+            touched[0]++;
+            for(int t=1; t<num_threads; t++)
+                is_done[t].get();
+        }
+        kx::io::println("futures: " + kx::to_str(timer.elapsed_ns() / (1000.0 * NUM_DISPATCHES)) +
+                        "us/dispatch (" + kx::to_str(num_threads) + " parts)");
+    }
+    {
+        ThreadPool pool(num_threads - 1);
+        Timer timer;
+        timer.start();
+        for(int i=0; i<NUM_DISPATCHES; i++)
+            pool.parallel_for(0, num_threads, 1, [&touched](int t){touched[t]++;});
+        kx::io::println("work stealing: " + kx::to_str(timer.elapsed_ns() / (1000.0 * NUM_DISPATCHES)) +
+                        "us/dispatch (" + kx::to_str(num_threads) + " parts)");
+    }
+    {
+        //a range that isn't a multiple of any of the grains, so the last chunk is short
+        constexpr int NUM_ITEMS = 100003;
+        constexpr int NUM_RUNS = 100;
+        ThreadPool pool(num_threads - 1);
+        std::vector<int> num_visits(NUM_ITEMS);
+        for(int grain: {1, 7, 64, 1000, NUM_ITEMS + 1}) {
+            std::fill(num_visits.begin(), num_visits.end(), 0);
+            Timer timer;
+            timer.start();
+            for(int i=0; i<NUM_RUNS; i++)
+                pool.parallel_for(0, NUM_ITEMS, grain, [&num_visits](int j){num_visits[j]++;});
+            kx::io::println("work stealing, grain " + kx::to_str(grain) + ": " +
+                            kx::to_str(timer.elapsed_ns() / (1000.0 * NUM_RUNS)) + "us/dispatch (" +
+                            kx::to_str(NUM_ITEMS) + " items)");
+            if(std::any_of(num_visits.begin(), num_visits.end(), [](int n){return n != NUM_RUNS;}))
+                kx::log_error("grain " + kx::to_str(grain) + " didn't visit every item exactly once per run");
+        }
+
+        //the pool has to be usable afterwards, so no worker can still be in the old job
+        bool caught = false;
+        try {
+            pool.parallel_for(0, NUM_ITEMS, 64, [](int j)
+            {
+                if(j == NUM_ITEMS / 2)
+                    throw std::runtime_error("test");
+            });
+        } catch(const std::runtime_error&) {
+            caught = true;
+        }
+        if(!caught)
+            kx::log_error("parallel_for() didn't rethrow an exception from fn");
+        pool.parallel_for(0, NUM_ITEMS, 64, [&num_visits](int j){num_visits[j] = -1;});
+        if(std::any_of(num_visits.begin(), num_visits.end(), [](int n){return n != -1;}))
+            kx::log_error("parallel_for() doesn't work after an exception");
+    }
+}
+void GameBenchmark::tick_phases()
+{
+    //the player shoots the whole time, so there are a lot of cheap projectiles next to
+    //the expensive units
+    const kx::gfx::mouse_state_t shooting = SDL_BUTTON(SDL_BUTTON_LEFT);
+
+    for(const auto &config: RECORDED_TICK_CONFIGS) {
+        Game game({});
+        game.generate_and_start_level(config.level_name);
+        auto hot_section = game.tick_phases->keep_hot();
+        for(int i=0; i<config.num_shooting_ticks; i++)
+            tick(&game, shooting, true);
+
+        game.tick_phases->reset_phase_stats();
+        for(int i=0; i<config.num_runs; i++)
+            tick(&game, shooting, true);
+
+        kx::io::println(std::string(config.name) + " (" + kx::to_str(game.map_objs.size()) +
+                        " objects at the end):");
+        for(const auto &stats: game.tick_phases->get_phase_stats()) {
+            kx::io::println(std::string("    ") + stats.name + ": " +
+                            kx::to_str(stats.get_avg_us()) + "us (average), " +
+                            kx::to_str(stats.max_ns / 1000.0) + "us (max)");
+        }
+        auto alloc_stats = get_polygon_allocator_stats();
+        for(const auto &c: alloc_stats.classes) {
+            kx::io::println(std::string("    polygons with up to ") + kx::to_str(c.max_n) + " vertices: " +
+                            kx::to_str(c.num_live) + " live, " + kx::to_str(c.num_blocks) + " blocks of " +
+                            kx::to_str(c.block_size) + " bytes");
+        }
+        kx::io::println("    bigger polygons: " + kx::to_str(alloc_stats.num_large_live) + " live");
+    }
+}
+template<class Container, class PushPopFunc>
+static double time_push_pop(int num_threads, int num_pairs, const PushPopFunc &push_pop)
+{
+    Container container;
+    std::vector<std::thread> threads(num_threads);
+    Timer timer;
+    timer.start();
+    for(int t=0; t<num_threads; t++) {
+        threads[t] = std::thread([&container, &push_pop, num_pairs, t]
+                                 {
+                                     for(int i=0; i<num_pairs; i++)
+                                         push_pop(&container, t);
+                                 });
+    }
+    for(auto &thread: threads)
+        thread.join();
+    return timer.elapsed_ns() / (2.0 * num_threads * num_pairs);
+}
+void GameBenchmark::atomic_containers()
+{
+    constexpr int NUM_PAIRS = 1 << 18;
+
+    //every thread pops only after it has pushed, so the containers are never empty when
+    //popping and never have more than num_threads elements
+    auto queue_push_pop = [](auto *queue, int val)
+    {
+        queue->push(val);
+        queue->poll_blocking();
+    };
+    auto stack_push_pop = [](auto *stack, int val)
+    {
+        stack->push(val);
+        stack->pop();
+    };
+
+    int max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for(int num_threads=1; num_threads<=max_threads; num_threads++) {
+        double queue_ns = time_push_pop<kx::AtomicQueue<int>>(num_threads, NUM_PAIRS, queue_push_pop);
+        double lf_queue_ns = time_push_pop<kx::LockFreeQueue<int>>(num_threads, NUM_PAIRS, queue_push_pop);
+        double stack_ns = time_push_pop<kx::AtomicStack<int>>(num_threads, NUM_PAIRS, stack_push_pop);
+        double lf_stack_ns = time_push_pop<kx::LockFreeStack<int>>(num_threads, NUM_PAIRS, stack_push_pop);
+        kx::io::println(kx::to_str(num_threads) + " threads: " +
+                        kx::to_str(queue_ns) + "ns/op (AtomicQueue), " +
+                        kx::to_str(lf_queue_ns) + "ns/op (LockFreeQueue), " +
+                        kx::to_str(stack_ns) + "ns/op (AtomicStack), " +
+                        kx::to_str(lf_stack_ns) + "ns/op (LockFreeStack)");
+    }
+}
+
+void GameBenchmark::narrowphase()
+{
+    constexpr int NUM_PAIRS = 1 << 12;
+    constexpr int NUM_RUNS = 50;
+    constexpr std::pair<int, int> SIZES[]{{3, 3}, {3, 4}, {4, 4}, {3, 6}, {4, 6}, {6, 6},
+                                          {4, 8}, {8, 8}, {6, 12}, {16, 16}};
+
+    StandardRNG rng;
+    std::uniform_real_distribution<float> dist(0, 1);
+    auto make_regular = [&rng, &dist](int n) -> std::unique_ptr<Polygon>
+    {
+        float cx = dist(rng) * 2;
+        float cy = dist(rng) * 2;
+        float r = 0.25 + dist(rng);
+        float rot = dist(rng) * 2 * M_PI;
+        std::vector<MapCoord> verts;
+        for(int i=0; i<n; i++)
+            verts.emplace_back(cx + r * std::cos(rot + 2 * M_PI * i / n), cy + r * std::sin(rot + 2 * M_PI * i / n));
+        return Polygon::make(kx::kx_span<MapCoord>(verts.begin(), verts.end()));
+    };
+
+    for(auto [n, m]: SIZES) {
+        //only pairs that get past the AABB check, like the ones the broadphase gives us
+        std::vector<std::pair<std::unique_ptr<Polygon>, std::unique_ptr<Polygon>>> pairs;
+        while(pairs.size() < NUM_PAIRS) {
+            auto a = make_regular(n);
+            auto b = make_regular(m);
+            if(a->get_AABB().overlaps(b->get_AABB()))
+                pairs.emplace_back(std::move(a), std::move(b));
+        }
+
+        auto time_ns = [&pairs](const auto &test, int *num_collisions) -> double
+        {
+            *num_collisions = 0;
+            Timer timer;
+            timer.start();
+            for(int run=0; run<NUM_RUNS; run++) {
+                for(const auto &[a, b]: pairs)
+                    *num_collisions += test(*a, *b);
+            }
+            *num_collisions /= NUM_RUNS;
+            return timer.elapsed_ns() / (double)(NUM_RUNS * pairs.size());
+        };
+
+        int edge_collisions, overlap_collisions, sat_collisions;
+        double edge_ns = time_ns([](const Polygon &a, const Polygon &b){return a.has_edge_crossing(b);},
+                                 &edge_collisions);
+        //what it takes to also find containment without SAT
+        double overlap_ns = time_ns([](const Polygon &a, const Polygon &b)
+                                    {
+                                        return a.has_edge_crossing(b) ||
+                                               a.contains_point(b.get_vertex(0)) ||
+                                               b.contains_point(a.get_vertex(0));
+                                    }, &overlap_collisions);
+        double sat_ns = time_ns([](const Polygon &a, const Polygon &b){return a.has_collision_sat(b);},
+                                &sat_collisions);
+
+        kx::io::println(kx::to_str(n) + " vs " + kx::to_str(m) + " vertices: " +
+                        kx::to_str(edge_ns) + "ns (edge crossing, " +
+                        kx::to_str(edge_collisions) + " collisions), " +
+                        kx::to_str(overlap_ns) + "ns (edge crossing + containment, " +
+                        kx::to_str(overlap_collisions) + " collisions), " +
+                        kx::to_str(sat_ns) + "ns (SAT, " +
+                        kx::to_str(sat_collisions) + " collisions)");
+
+        //the first a against all the bs, like a cell of the grid
+        constexpr size_t CELL_SIZE = 64;
+        const auto &query = *pairs[0].first;
+        std::vector<const Polygon*> cell;
+        for(const auto &[a, b]: pairs) {
+            if(cell.size() < CELL_SIZE && query.get_AABB().overlaps(b->get_AABB()))
+                cell.push_back(b.get());
+        }
+        int one_collisions = 0, many_collisions = 0;
+        Timer timer;
+        timer.start();
+        for(int run=0; run<NUM_RUNS; run++) {
+            for(auto other: cell)
+                one_collisions += query.has_collision(*other);
+        }
+        double one_ns = timer.elapsed_ns() / (double)(NUM_RUNS * cell.size());
+        timer.start();
+        for(int run=0; run<NUM_RUNS; run++) {
+            auto hits = query.has_collision_many(kx::kx_span<const Polygon* const>(cell.data(), cell.data() + cell.size()));
+            many_collisions += __builtin_popcountll(hits);
+        }
+        double many_ns = timer.elapsed_ns() / (double)(NUM_RUNS * cell.size());
+
+        kx::io::println(std::string("    one vs ") + kx::to_str(cell.size()) + ": " +
+                        kx::to_str(one_ns) + "ns/pair (has_collision, " +
+                        kx::to_str(one_collisions / NUM_RUNS) + " collisions), " +
+                        kx::to_str(many_ns) + "ns/pair (has_collision_many, " +
+                        kx::to_str(many_collisions / NUM_RUNS) + " collisions)");
+    }
+}
+
+void GameBenchmark::render_ops()
+{
+    constexpr int NUM_FRAMES = 200;
+
+    //roughly what's on screen in a big level while the player shoots; the sizes and
+    //max instances are the same as the real shaders'
+    struct Config
+    {
+        const char *name;
+        int max_instances;
+        int num_vec4s;
+        float priority;
+        int num_objs;
+        int ops_per_obj;
+    };
+    const Config configs[]{{"floor", 512, 2, 1000, 10000, 1},
+                           {"wall", 512, 2, 2000, 2000, 1},
+                           {"pig", 204, 5, 3000, 300, 5},
+                           {"hexfly", 170, 6, 3000, 200, 8},
+                           {"player", 204, 5, 4000, 1, 2},
+                           {"laser_proj", 256, 4, 5000, 1, 3000}};
+
+    std::vector<std::unique_ptr<IShader>> shaders;
+    struct Obj
+    {
+        const IShader *shader;
+        float priority;
+        int num_ops;
+        uint64_t seq;
+    };
+    std::vector<Obj> objs;
+    for(const auto &config: configs) {
+        auto shader = std::make_unique<IShader>(nullptr, shaders.size(), config.max_instances,
+                                                kx::gfx::DrawMode::TriangleStrip, 4);
+        shader->add_UB("block1", 0, config.num_vec4s * 4 * sizeof(float));
+        for(int i=0; i<config.num_objs; i++)
+            objs.push_back(Obj{shader.get(), config.priority, config.ops_per_obj, objs.size()});
+        shaders.push_back(std::move(shader));
+    }
+    //map objects are rendered in the order of map_objs, which isn't sorted in any way
+    StandardRNG rng;
+    std::shuffle(objs.begin(), objs.end(), rng);
+
+    RenderSceneGraph scene_graph;
+    auto arena = scene_graph.get_op_arena();
+    double add_ns = 0;
+    double batch_ns = 0;
+    size_t num_ops = 0;
+    size_t num_batches = 0;
+    for(int frame=0; frame<NUM_FRAMES; frame++) {
+        Timer timer;
+        timer.start();
+        for(const auto &obj: objs) {
+            arena->begin_group(obj.priority, obj.seq);
+            for(int i=0; i<obj.num_ops; i++) {
+                auto iu = arena->add_shader_op(*obj.shader);
+                auto iu_f = (float*)iu.begin();
+                for(size_t j=0; j<iu.size()/sizeof(float); j++)
+                    iu_f[j] = j;
+            }
+        }
+        add_ns += timer.elapsed_ns();
+
+        timer.start();
+        scene_graph.make_batches();
+        batch_ns += timer.elapsed_ns();
+
+        num_ops = scene_graph.sorted_records.size();
+        num_batches = scene_graph.batches.size();
+        arena->clear();
+    }
+
+    kx::io::println(kx::to_str(num_ops) + " ops in " + kx::to_str(num_batches) + " batches: " +
+                    kx::to_str(add_ns / (1000.0 * NUM_FRAMES)) + "us/frame (adding ops), " +
+                    kx::to_str(batch_ns / (1000.0 * NUM_FRAMES)) + "us/frame (sorting and batching)");
+}
+void GameBenchmark::contact_table()
+{
+    //every unit touches a few neighbors every tick, like in a crowd
+    constexpr int NUM_OBJS = 2000;
+    constexpr int NUM_NEIGHBORS = 4;
+    constexpr int NUM_TICKS = 1000;
+
+    MapObjSlotMap map_objs;
+    std::vector<map_obj::MapObjHandle> handles;
+    for(int i=0; i<NUM_OBJS; i++) {
+        auto obj = std::make_shared<map_obj::MonochromaticWall_1>(MapRect(i, 0, 1, 1),
+                                                                  kx::gfx::LinearColor(1, 1, 1));
+        handles.push_back(map_objs.insert(std::move(obj)));
+    }
+
+    CEng1ContactTable table;
+    double prev_time;
+    Timer timer;
+    timer.start();
+    for(int t=0; t<NUM_TICKS; t++) {
+        for(int i=0; i<NUM_OBJS; i++) {
+            for(int j=1; j<=NUM_NEIGHBORS; j++)
+                table.record_contact(handles[i], handles[(i + j) % NUM_OBJS], t * TICK_LEN, &prev_time);
+        }
+    }
+    kx::io::println(kx::to_str(timer.elapsed_ns() / (1000.0 * NUM_TICKS)) + "us/tick (" +
+                    kx::to_str(NUM_OBJS * NUM_NEIGHBORS) + " contacts)");
+
+    //units die one at a time, which should cost about as much as their own contacts
+    constexpr int NUM_DELETED = 1000;
+    std::vector<int> deleted_idx;
+    std::vector<CEng1IdxMove> moves;
+    timer.start();
+    for(int i=0; i<NUM_DELETED; i++) {
+        deleted_idx.assign(1, map_objs.size() - 1);
+        moves.clear();
+        get_swap_and_pop_moves(deleted_idx, map_objs.size(), &moves);
+        table.remove_objs(deleted_idx, map_objs);
+        map_objs.erase(deleted_idx, moves);
+    }
+    kx::io::println(kx::to_str(timer.elapsed_ns() / (1000.0 * NUM_DELETED)) + "us/deleted object (" +
+                    kx::to_str(table.size()) + " contacts left)");
+    //the last NUM_NEIGHBORS objects that are left lose the contacts that wrapped around
+    constexpr int NUM_LEFT = (NUM_OBJS - NUM_DELETED) * NUM_NEIGHBORS - NUM_NEIGHBORS * (NUM_NEIGHBORS + 1) / 2;
+    if(table.size() != NUM_LEFT)
+        kx::log_error("deleting objects didn't remove exactly their contacts");
+
+    //a contact that comes back after a long time still isn't a first contact, so units
+    //keep doing capped damage to each other
+    table.clear();
+    if(table.record_contact(handles[0], handles[1], 0.0, &prev_time))
+        kx::log_error("the first contact of two objects was already in the table");
+    if(!table.record_contact(handles[0], handles[1], 5.0, &prev_time) || prev_time != 0.0)
+        kx::log_error("a contact that came back after 5s wasn't remembered");
+
+    deleted_idx.assign(1, 0);
+    moves.clear();
+    get_swap_and_pop_moves(deleted_idx, map_objs.size(), &moves);
+    table.remove_objs(deleted_idx, map_objs);
+    map_objs.erase(deleted_idx, moves);
+    if(table.size() != 0)
+        kx::log_error("the contact of a deleted object wasn't removed");
+}
+
+struct Benchmark
+{
+    const char *name;
+    void (*func)();
+};
+const Benchmark BENCHMARKS[]{{"collision_grid", GameBenchmark::collision_grid},
+                             {"broadphase", GameBenchmark::broadphase},
+                             {"collision_filter", GameBenchmark::collision_filter},
+                             {"thread_pool", GameBenchmark::thread_pool},
+                             {"tick_phases", GameBenchmark::tick_phases},
+                             {"atomic_containers", GameBenchmark::atomic_containers},
+                             {"narrowphase", GameBenchmark::narrowphase},
+                             {"render_ops", GameBenchmark::render_ops},
+                             {"contact_table", GameBenchmark::contact_table}};
+
+bool run_benchmark(const std::string &name)
+{
+    bool found = false;
+    for(const auto &benchmark: BENCHMARKS) {
+        if(name == "all" || name == benchmark.name) {
+            kx::io::println(std::string("running benchmark ") + benchmark.name);
+            benchmark.func();
+            found = true;
+        }
+    }
+    return found;
+}
+
+}
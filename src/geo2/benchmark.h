@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+namespace geo2 {
+
+/** Benchmarks run without a window or any input and print their results. They're run
+ *  with "geo2 --bench <name>"; "geo2 --bench all" runs all of them.
+ *  Returns false if there's no benchmark with the given name.
+ */
+bool run_benchmark(const std::string &name);
+
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "geo2/geometry.h"
+
+#include <immintrin.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <cstdint>
+
+namespace geo2 {
+
+/** The AABBs and owner indices of a bunch of shapes, stored as a structure of arrays in
+ *  blocks of 8 so a whole block can be checked against an AABB with a few AVX2 compares.
+ *  This lets the broadphase cull a grid cell without touching any Polygons, which are
+ *  scattered all over the heap.
+ */
+class CEng1AABBStore final
+{
+    static constexpr int BLOCK_LEN = 8;
+
+    struct Block
+    {
+        float x1[BLOCK_LEN];
+        float y1[BLOCK_LEN];
+        float x2[BLOCK_LEN];
+        float y2[BLOCK_LEN];
+        int idx[BLOCK_LEN];
+    };
+
+    std::vector<Block> blocks;
+    size_t num_aabbs = 0;
+
+    ///bit i is set iff lane i overlaps aabb (same as AABB::overlaps) and its owner isn't idx
+    static inline uint32_t get_overlap_mask(const Block &block, const AABB &aabb, int idx)
+    {
+        auto x1 = _mm256_loadu_ps(block.x1);
+        auto y1 = _mm256_loadu_ps(block.y1);
+        auto x2 = _mm256_loadu_ps(block.x2);
+        auto y2 = _mm256_loadu_ps(block.y2);
+        auto a_x1 = _mm256_set1_ps(aabb.x1);
+        auto a_y1 = _mm256_set1_ps(aabb.y1);
+        auto a_x2 = _mm256_set1_ps(aabb.x2);
+        auto a_y2 = _mm256_set1_ps(aabb.y2);
+
+        auto x_overlap = _mm256_or_ps(_mm256_and_ps(_mm256_cmp_ps(a_x1, x1, _CMP_GE_OQ),
+                                                    _mm256_cmp_ps(a_x1, x2, _CMP_LT_OQ)),
+                                      _mm256_and_ps(_mm256_cmp_ps(x1, a_x1, _CMP_GE_OQ),
+                                                    _mm256_cmp_ps(x1, a_x2, _CMP_LT_OQ)));
+        auto y_overlap = _mm256_or_ps(_mm256_and_ps(_mm256_cmp_ps(a_y1, y1, _CMP_GE_OQ),
+                                                    _mm256_cmp_ps(a_y1, y2, _CMP_LT_OQ)),
+                                      _mm256_and_ps(_mm256_cmp_ps(y1, a_y1, _CMP_GE_OQ),
+                                                    _mm256_cmp_ps(y1, a_y2, _CMP_LT_OQ)));
+        auto same_owner = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)block.idx),
+                                             _mm256_set1_epi32(idx));
+
+        auto overlap = _mm256_and_ps(x_overlap, y_overlap);
+        return _mm256_movemask_ps(_mm256_andnot_ps(_mm256_castsi256_ps(same_owner), overlap));
+    }
+public:
+    inline size_t size() const
+    {
+        return num_aabbs;
+    }
+    inline void clear()
+    {
+        blocks.clear();
+        num_aabbs = 0;
+    }
+    inline void reserve(size_t n)
+    {
+        blocks.reserve((n + BLOCK_LEN - 1) / BLOCK_LEN);
+    }
+    inline AABB get_AABB(size_t i) const
+    {
+        const auto &block = blocks[i / BLOCK_LEN];
+        int lane = i % BLOCK_LEN;
+        return AABB(block.x1[lane], block.y1[lane], block.x2[lane], block.y2[lane]);
+    }
+    inline int get_idx(size_t i) const
+    {
+        return blocks[i / BLOCK_LEN].idx[i % BLOCK_LEN];
+    }
+    inline void set(size_t i, const AABB &aabb, int idx)
+    {
+        auto &block = blocks[i / BLOCK_LEN];
+        int lane = i % BLOCK_LEN;
+        block.x1[lane] = aabb.x1;
+        block.y1[lane] = aabb.y1;
+        block.x2[lane] = aabb.x2;
+        block.y2[lane] = aabb.y2;
+        block.idx[lane] = idx;
+    }
+    inline void set_idx(size_t i, int idx)
+    {
+        blocks[i / BLOCK_LEN].idx[i % BLOCK_LEN] = idx;
+    }
+    inline void push_back(const AABB &aabb, int idx)
+    {
+        if(num_aabbs % BLOCK_LEN == 0)
+            blocks.emplace_back();
+        set(num_aabbs++, aabb, idx);
+    }
+    ///doesn't preserve the order, just like removing from a grid cell
+    inline void remove_by_swapping_with_back(size_t i)
+    {
+        size_t last = num_aabbs - 1;
+        set(i, get_AABB(last), get_idx(last));
+        num_aabbs--;
+        if(num_aabbs % BLOCK_LEN == 0)
+            blocks.pop_back();
+    }
+    ///returns the position of the first AABB owned by idx, or size() if there is none
+    inline size_t find_idx(int idx) const
+    {
+        for(size_t i=0; i<num_aabbs; i++) {
+            if(get_idx(i) == idx)
+                return i;
+        }
+        return num_aabbs;
+    }
+    /** Calls func(i) for every i in [begin, end) where the i-th AABB overlaps aabb and
+     *  isn't owned by idx, in increasing order of i.
+     */
+    template<class Func> inline void for_each_overlap(size_t begin, size_t end, const AABB &aabb,
+                                                      int idx, const Func &func) const
+    {
+        if(begin >= end)
+            return;
+
+        size_t first_block = begin / BLOCK_LEN;
+        size_t last_block = (end - 1) / BLOCK_LEN;
+        for(size_t b=first_block; b<=last_block; b++) {
+            uint32_t mask = get_overlap_mask(blocks[b], aabb, idx);
+            //lanes outside of [begin, end) can hold anything
+            if(b == first_block)
+                mask &= 0xffu << (begin % BLOCK_LEN);
+            if(b == last_block)
+                mask &= 0xffu >> (BLOCK_LEN - 1 - (end - 1) % BLOCK_LEN);
+
+            while(mask != 0) {
+                int lane = __builtin_ctz(mask);
+                mask &= mask - 1;
+                func(b*BLOCK_LEN + lane);
+            }
+        }
+    }
+    template<class Func> inline void for_each_overlap(const AABB &aabb, int idx, const Func &func) const
+    {
+        for_each_overlap(0, num_aabbs, aabb, idx, func);
+    }
+    ///bounding box of the top left corners and the largest width and height of the AABBs
+    inline void get_bounds(AABB *top_left_bounds, float *max_w, float *max_h) const
+    {
+        auto mm_x1_min = _mm256_set1_ps(std::numeric_limits<float>::max());
+        auto mm_y1_min = _mm256_set1_ps(std::numeric_limits<float>::max());
+        auto mm_x1_max = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+        auto mm_y1_max = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+        auto mm_max_w = _mm256_set1_ps(0);
+        auto mm_max_h = _mm256_set1_ps(0);
+
+        size_t num_full_blocks = num_aabbs / BLOCK_LEN;
+        for(size_t b=0; b<num_full_blocks; b++) {
+            auto x1 = _mm256_loadu_ps(blocks[b].x1);
+            auto y1 = _mm256_loadu_ps(blocks[b].y1);
+            mm_x1_min = _mm256_min_ps(mm_x1_min, x1);
+            mm_y1_min = _mm256_min_ps(mm_y1_min, y1);
+            mm_x1_max = _mm256_max_ps(mm_x1_max, x1);
+            mm_y1_max = _mm256_max_ps(mm_y1_max, y1);
+            mm_max_w = _mm256_max_ps(mm_max_w, _mm256_loadu_ps(blocks[b].x2) - x1);
+            mm_max_h = _mm256_max_ps(mm_max_h, _mm256_loadu_ps(blocks[b].y2) - y1);
+        }
+
+        float vals[6][BLOCK_LEN];
+        _mm256_storeu_ps(vals[0], mm_x1_min);
+        _mm256_storeu_ps(vals[1], mm_y1_min);
+        _mm256_storeu_ps(vals[2], mm_x1_max);
+        _mm256_storeu_ps(vals[3], mm_y1_max);
+        _mm256_storeu_ps(vals[4], mm_max_w);
+        _mm256_storeu_ps(vals[5], mm_max_h);
+
+        *top_left_bounds = AABB::make_maxbad_AABB();
+        top_left_bounds->x1 = std::min(top_left_bounds->x1, *std::min_element(vals[0], vals[0] + BLOCK_LEN));
+        top_left_bounds->y1 = std::min(top_left_bounds->y1, *std::min_element(vals[1], vals[1] + BLOCK_LEN));
+        top_left_bounds->x2 = std::max(top_left_bounds->x2, *std::max_element(vals[2], vals[2] + BLOCK_LEN));
+        top_left_bounds->y2 = std::max(top_left_bounds->y2, *std::max_element(vals[3], vals[3] + BLOCK_LEN));
+        *max_w = *std::max_element(vals[4], vals[4] + BLOCK_LEN);
+        *max_h = *std::max_element(vals[5], vals[5] + BLOCK_LEN);
+
+        for(size_t i=num_full_blocks*BLOCK_LEN; i<num_aabbs; i++) {
+            auto aabb = get_AABB(i);
+            *max_w = std::max(*max_w, aabb.x2 - aabb.x1);
+            *max_h = std::max(*max_h, aabb.y2 - aabb.y1);
+            top_left_bounds->x1 = std::min(top_left_bounds->x1, aabb.x1);
+            top_left_bounds->y1 = std::min(top_left_bounds->y1, aabb.y1);
+            top_left_bounds->x2 = std::max(top_left_bounds->x2, aabb.x1);
+            top_left_bounds->y2 = std::max(top_left_bounds->y2, aabb.y1);
+        }
+    }
+};
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "geo2/ceng1_collision_filter.h"
+#include "geo2/geometry.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace geo2 {
+
+struct CEng1Obj final
+{
+    const Polygon *polygon;
+    int idx; //index of owner
+    uint16_t shape_id;
+    CEng1CollisionFilter filter; //copy of the owner's filter, so we don't have to look it up
+
+    CEng1Obj(const Polygon *polygon_, int idx_, uint16_t shape_id_, CEng1CollisionFilter filter_):
+        polygon(polygon_),
+        idx(idx_),
+        shape_id(shape_id_),
+        filter(filter_)
+    {}
+
+    static bool cmp_idx(const CEng1Obj &a, const CEng1Obj &b)
+    {
+        return a.idx < b.idx;
+    }
+};
+
+///when objects are deleted, the object at index from is moved to index to
+struct CEng1IdxMove final
+{
+    int from;
+    int to;
+};
+
+/** Deleting from ceng_data (and map_objs) is swap-and-pop: the holes left by deleted
+ *  objects are filled with the last objects, so only D objects move instead of everything
+ *  after the first deleted one. deleted_idx must be sorted and have no duplicates; the moves
+ *  are appended to moves in the order they should be done, and afterwards the size is
+ *  num_objs - deleted_idx.size().
+ */
+inline void get_swap_and_pop_moves(const std::vector<int> &deleted_idx, int num_objs,
+                                   std::vector<CEng1IdxMove> *moves)
+{
+    int new_size = num_objs - (int)deleted_idx.size();
+    //holes below new_size are filled from the back, skipping the deleted objects back there
+    size_t hole = 0;
+    size_t back_deleted = deleted_idx.size();
+    int from = num_objs - 1;
+    while(hole < deleted_idx.size() && deleted_idx[hole] < new_size) {
+        while(back_deleted > 0 && deleted_idx[back_deleted - 1] == from) {
+            back_deleted--;
+            from--;
+        }
+        moves->push_back(CEng1IdxMove{from, deleted_idx[hole]});
+        hole++;
+        from--;
+    }
+}
+
+///a is the object that found the pair
+struct CEng1ObjPair final
+{
+    const CEng1Obj *a;
+    const CEng1Obj *b;
+};
+
+/** A broadphase keeps track of the shapes of the dynamic (non-static) objects and finds
+ *  pairs of them whose AABBs overlap; the CollisionEngine1 does everything else. Indices
+ *  are indices into ceng_data, so a broadphase has to follow along when objects are
+ *  deleted and others are moved into their place (see get_swap_and_pop_moves()).
+ */
+class CEng1Broadphase
+{
+public:
+    virtual ~CEng1Broadphase() = default;
+
+    ///forgets about all objects
+    virtual void reset() = 0;
+    ///bounding box of the top left corners of the static objects (i.e. roughly the level)
+    virtual void set_level_bounds([[maybe_unused]] const AABB &bounds) {}
+    ///num_objs is the total number of objects after some were appended
+    virtual void process_added_objs(int num_objs) = 0;
+    ///deleted_idx is sorted and has no duplicates, and moves come from get_swap_and_pop_moves()
+    virtual void process_deleted_objs(const std::vector<int> &deleted_idx,
+                                      const std::vector<CEng1IdxMove> &moves) = 0;
+    ///after this is called, the broadphase contains exactly objs, which is sorted by idx
+    virtual void set_objs(const std::vector<CEng1Obj> &objs) = 0;
+    /** Finds every pair of objects with different owners, overlapping AABBs and filters
+     *  that could matter exactly once. Parts 0 ... num_parts-1 together find all pairs, and
+     *  they can run in parallel.
+     */
+    virtual void find_pairs(int part, int num_parts, std::vector<CEng1ObjPair> *add_to) const = 0;
+    ///finds every object that overlaps obj, has a different owner and a filter that could matter
+    virtual void find_overlaps(const CEng1Obj &obj, std::vector<CEng1ObjPair> *add_to) const = 0;
+    ///insert() and remove() modify what the last set_objs() call set
+    virtual void insert(const CEng1Obj &obj) = 0;
+    ///removes all shapes of object idx
+    virtual void remove(int idx) = 0;
+};
+
+}
@@ -14,6 +14,45 @@ struct CEng1Collision final
     {
         std::swap(idx1, idx2);
     }
+
+    static bool cmp_idx(const CEng1Collision &a, const CEng1Collision &b)
+    {
+        if(a.idx1 != b.idx1)
+            return a.idx1 < b.idx1;
+        return a.idx2 < b.idx2;
+    }
+};
+
+///shapes[shape_idx] (a shape that isn't in ceng_data, e.g. a projectile) overlaps object idx
+struct CEng1ShapeHit final
+{
+    int shape_idx;
+    int idx;
+    ///for swept shapes: roughly how far along the sweep (0 to 1) the hit happens
+    float time;
+
+    static bool cmp_idx(const CEng1ShapeHit &a, const CEng1ShapeHit &b)
+    {
+        if(a.shape_idx != b.shape_idx)
+            return a.shape_idx < b.shape_idx;
+        return a.idx < b.idx;
+    }
+    static bool cmp_time(const CEng1ShapeHit &a, const CEng1ShapeHit &b)
+    {
+        if(a.shape_idx != b.shape_idx)
+            return a.shape_idx < b.shape_idx;
+        if(a.time != b.time)
+            return a.time < b.time;
+        return a.idx < b.idx;
+    }
+};
+
+///what has to happen to the broadphase after a collision changed an object's move intent
+enum class CEng1BroadphaseUpdate: uint8_t
+{
+    None,
+    Remove,
+    RemoveAndAddCur
 };
 
 }
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace geo2 {
+
+/** Every collidable object is on one or more layers and has a mask of the layers it
+ *  wants to know about collisions with. A pair of objects only gets to the narrowphase
+ *  if at least one of them wants to know about the other, so most of the time we don't
+ *  have to touch the MapObjects at all. The filter is small enough to be stored inline
+ *  in CEng1Obj.
+ */
+struct CEng1CollisionFilter final
+{
+    using layer_t = uint8_t;
+
+    static constexpr layer_t LAYER_WALL = 1 << 0;
+    static constexpr layer_t LAYER_UNIT = 1 << 1;
+    static constexpr layer_t LAYER_PROJECTILE = 1 << 2;
+    static constexpr layer_t LAYER_COSMETIC = 1 << 3;
+    static constexpr layer_t ALL_LAYERS = 0x7f;
+    ///not a layer; if either object has this bit set in layer, MapObject::collision_could_matter()
+    ///is called as well (this is slow, so only use it if layers aren't enough)
+    static constexpr layer_t CUSTOM_CHECK = 0x80;
+
+    //by default, everything collides with everything
+    layer_t layer = ALL_LAYERS;
+    layer_t mask = ALL_LAYERS;
+
+    constexpr CEng1CollisionFilter() = default;
+    constexpr CEng1CollisionFilter(layer_t layer_, layer_t mask_):
+        layer(layer_),
+        mask(mask_)
+    {}
+
+    inline bool could_matter(CEng1CollisionFilter other) const
+    {
+        return ((layer & other.mask) | (other.layer & mask)) != 0;
+    }
+    inline bool needs_custom_check(CEng1CollisionFilter other) const
+    {
+        return ((layer | other.layer) & CUSTOM_CHECK) != 0;
+    }
+};
+
+}
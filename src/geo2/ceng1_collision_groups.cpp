@@ -0,0 +1,84 @@
+#include "geo2/ceng1_collision_groups.h"
+
+#include <algorithm>
+
+namespace geo2 {
+
+int CEng1CollisionGroups::find(int idx)
+{
+    //path halving
+    while(parent[idx] != idx) {
+        parent[idx] = parent[parent[idx]];
+        idx = parent[idx];
+    }
+    return idx;
+}
+void CEng1CollisionGroups::unite(int idx1, int idx2)
+{
+    idx1 = find(idx1);
+    idx2 = find(idx2);
+    //there are few enough objects per group that union by rank doesn't matter much
+    if(idx1 != idx2)
+        parent[std::max(idx1, idx2)] = std::min(idx1, idx2);
+}
+void CEng1CollisionGroups::build(const std::vector<CEng1Collision> &collisions,
+                                 size_t begin, size_t end,
+                                 const std::vector<CEng1Data> &ceng_data)
+{
+    k_expects(begin <= end && end <= collisions.size());
+
+    parent.assign(ceng_data.size(), -1);
+    for(size_t i=begin; i<end; i++) {
+        int idx1 = collisions[i].idx1;
+        int idx2 = collisions[i].idx2;
+        bool is_static1 = ceng_data[idx1].is_static();
+        bool is_static2 = ceng_data[idx2].is_static();
+        //static objects are never active, so they can't collide with each other
+        k_assert(!is_static1 || !is_static2);
+
+        if(!is_static1 && parent[idx1] == -1)
+            parent[idx1] = idx1;
+        if(!is_static2 && parent[idx2] == -1)
+            parent[idx2] = idx2;
+        if(!is_static1 && !is_static2)
+            unite(idx1, idx2);
+    }
+
+    //number the groups in the order of their first collision
+    group_of_root.assign(ceng_data.size(), -1);
+    group_of_collision.resize(end - begin);
+    group_offset.assign(1, 0);
+    for(size_t i=begin; i<end; i++) {
+        int idx = collisions[i].idx1;
+        if(ceng_data[idx].is_static())
+            idx = collisions[i].idx2;
+
+        int root = find(idx);
+        if(group_of_root[root] == -1) {
+            group_of_root[root] = group_offset.size() - 1;
+            group_offset.push_back(0);
+        }
+        group_of_collision[i - begin] = group_of_root[root];
+        group_offset[group_of_root[root] + 1]++;
+    }
+
+    //counting sort by group, which keeps the order within each group
+    for(size_t g=1; g<group_offset.size(); g++)
+        group_offset[g] += group_offset[g-1];
+    std::vector<int> next_pos(group_offset.begin(), group_offset.end() - 1);
+    collision_idx.resize(end - begin);
+    for(size_t i=begin; i<end; i++)
+        collision_idx[next_pos[group_of_collision[i - begin]]++] = i;
+}
+int CEng1CollisionGroups::num_groups() const
+{
+    return group_offset.size() - 1;
+}
+kx::kx_span<const int> CEng1CollisionGroups::get_group(int group) const
+{
+    k_expects(group >= 0 && group < num_groups());
+    return kx::kx_span<const int>(collision_idx.data() + group_offset[group],
+                                  collision_idx.data() + group_offset[group + 1]);
+}
+
+}
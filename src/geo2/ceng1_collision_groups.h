@@ -0,0 +1,39 @@
+#pragma once
+
+#include "geo2/ceng1_collision.h"
+#include "geo2/ceng1_data.h"
+
+#include "kx/kx_span.h"
+
+#include <vector>
+
+namespace geo2 {
+
+/** Splits collisions into groups that don't share any objects, so the groups can be
+ *  resolved in parallel. Static objects don't tie groups together, because handling a
+ *  collision never changes a static object (if it did, every unit touching the same wall
+ *  would end up in one group). Within a group, collisions keep their original order, so
+ *  resolving a group gives the same result as resolving everything serially.
+ */
+class CEng1CollisionGroups final
+{
+    //union-find over object indices; -1 means the object isn't in any collision
+    std::vector<int> parent;
+    std::vector<int> group_of_root;
+    std::vector<int> group_of_collision;
+    //group g is collision_idx[group_offset[g]] ... collision_idx[group_offset[g+1] - 1]
+    std::vector<int> group_offset;
+    std::vector<int> collision_idx;
+
+    int find(int idx);
+    void unite(int idx1, int idx2);
+public:
+    ///groups collisions[begin] ... collisions[end-1]; groups are ordered by their first collision
+    void build(const std::vector<CEng1Collision> &collisions, size_t begin, size_t end,
+               const std::vector<CEng1Data> &ceng_data);
+    int num_groups() const;
+    ///indices into the collisions passed to build(), in increasing order
+    kx::kx_span<const int> get_group(int group) const;
+};
+
+}
@@ -0,0 +1,125 @@
+#include "geo2/ceng1_contact_table.h"
+#include "geo2/map_obj_slot_map.h"
+
+#include <algorithm>
+
+namespace geo2 {
+
+CEng1ContactTable::Entry *CEng1ContactTable::find(uint64_t key)
+{
+    size_t mask = entries.size() - 1;
+    size_t i = get_home(key);
+    while(entries[i].key != key && entries[i].key != EMPTY_KEY)
+        i = (i + 1) & mask;
+    return &entries[i];
+}
+void CEng1ContactTable::erase_at(size_t i)
+{
+    //with linear probing, an entry can't just be emptied without cutting off the ones
+    //after it in its chain, so those that could have gone into the hole are moved back
+    size_t mask = entries.size() - 1;
+    for(size_t j = (i + 1) & mask; entries[j].key != EMPTY_KEY; j = (j + 1) & mask) {
+        //the entry at j stays if its home is in (i, j], going around the end
+        size_t home = get_home(entries[j].key);
+        bool stays = i < j? (home > i && home <= j): (home > i || home <= j);
+        if(!stays) {
+            entries[i] = entries[j];
+            i = j;
+        }
+    }
+    entries[i].key = EMPTY_KEY;
+    num_used--;
+}
+void CEng1ContactTable::rehash(size_t capacity)
+{
+    live_entries.clear();
+    for(const auto &entry: entries) {
+        if(entry.key != EMPTY_KEY)
+            live_entries.push_back(entry);
+    }
+    entries.assign(capacity, Entry{EMPTY_KEY, 0.0});
+    for(const auto &entry: live_entries)
+        *find(entry.key) = entry;
+    num_used = live_entries.size();
+}
+CEng1ContactTable::CEng1ContactTable():
+    entries(MIN_CAPACITY, Entry{EMPTY_KEY, 0.0}),
+    num_used(0)
+{}
+void CEng1ContactTable::remove_slot_key(uint32_t slot, uint64_t key)
+{
+    auto &keys = slot_keys[slot];
+    auto it = std::find(keys.begin(), keys.end(), key);
+    k_assert(it != keys.end());
+    *it = keys.back();
+    keys.pop_back();
+}
+bool CEng1ContactTable::record_contact(map_obj::MapObjHandle a, map_obj::MapObjHandle b,
+                                       double now, double *prev_time)
+{
+    k_expects(!a.is_null() && !b.is_null());
+
+    auto lg = lock.get_lock_guard();
+    auto key = make_key(a, b);
+    auto entry = find(key);
+    if(entry->key == key) {
+        *prev_time = entry->time;
+        entry->time = now;
+        return true;
+    }
+
+    if(2 * (num_used + 1) > entries.size()) {
+        rehash(2 * entries.size());
+        entry = find(key);
+    }
+    *entry = Entry{key, now};
+    num_used++;
+
+    auto max_slot = std::max(a.get_slot(), b.get_slot());
+    if(max_slot >= slot_keys.size())
+        slot_keys.resize(max_slot + 1);
+    slot_keys[a.get_slot()].push_back(key);
+    if(b.get_slot() != a.get_slot())
+        slot_keys[b.get_slot()].push_back(key);
+    return false;
+}
+void CEng1ContactTable::remove_objs(const std::vector<int> &deleted_idx, const MapObjSlotMap &map_objs)
+{
+    for(int idx: deleted_idx) {
+        auto slot = map_objs.get_handle(idx).get_slot();
+        if(slot >= slot_keys.size())
+            continue;
+        for(auto key: slot_keys[slot]) {
+            //if both objects are deleted, the other one may have removed it already
+            auto entry = find(key);
+            if(entry->key != key)
+                continue;
+            erase_at(entry - entries.data());
+            //the other object keeps its other contacts
+            auto a_slot = make_handle(key >> 32).get_slot();
+            auto b_slot = make_handle((uint32_t)key).get_slot();
+            auto other_slot = a_slot == slot? b_slot: a_slot;
+            if(other_slot != slot)
+                remove_slot_key(other_slot, key);
+        }
+        //keep the memory for the slot's next object
+        slot_keys[slot].clear();
+    }
+
+    //shrinking costs as much as the table, but only after most of it has been removed
+    if(entries.size() > MIN_CAPACITY && 8 * num_used < entries.size()) {
+        size_t capacity = entries.size();
+        while(capacity > MIN_CAPACITY && 8 * num_used < capacity)
+            capacity /= 2;
+        rehash(capacity);
+    }
+}
+void CEng1ContactTable::clear()
+{
+    entries.assign(MIN_CAPACITY, Entry{EMPTY_KEY, 0.0});
+    num_used = 0;
+    for(auto &keys: slot_keys)
+        keys.clear();
+}
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "geo2/map_obj/map_obj_handle.h"
+
+#include "kx/multithread/spinlock.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace geo2 {
+
+class MapObjSlotMap;
+
+/** Remembers when pairs of map objects last touched, for things that depend on how long
+ *  ago that was (e.g. collision damage). It's a flat hash table with linear probing keyed
+ *  by (handle, handle), so recording a contact doesn't allocate once it has grown. A
+ *  contact is kept for as long as both objects are in the level, however long ago it was,
+ *  and dropped by remove_objs() once either of them is deleted (their handles never come
+ *  back). Every slot keeps the keys of its object's contacts, so deleting an object only
+ *  costs as much as the contacts it had.
+ *  Contacts can be recorded while collisions are handled in parallel.
+ */
+class CEng1ContactTable final
+{
+    static constexpr uint64_t EMPTY_KEY = ~(uint64_t)0;
+    static constexpr size_t MIN_CAPACITY = 64;
+
+    struct Entry
+    {
+        uint64_t key;
+        double time;
+    };
+
+    std::vector<Entry> entries; //the size is a power of 2, and at most half are used
+    size_t num_used;
+    std::vector<Entry> live_entries; //persists across calls to save memory allocations
+    //the keys that the object in each slot is in, in no particular order
+    std::vector<std::vector<uint64_t>> slot_keys;
+    kx::Spinlock<> lock;
+
+    static inline uint64_t make_key(map_obj::MapObjHandle a, map_obj::MapObjHandle b)
+    {
+        return ((uint64_t)a.get_value() << 32) | b.get_value();
+    }
+    ///the inverse of get_value(), for getting the handles back out of a key
+    static inline map_obj::MapObjHandle make_handle(uint32_t value)
+    {
+        return map_obj::MapObjHandle(value & (map_obj::MapObjHandle::MAX_SLOTS - 1),
+                                     value >> map_obj::MapObjHandle::SLOT_BITS);
+    }
+    inline size_t get_home(uint64_t key) const
+    {
+        //fibonacci hashing; the high bits are the best mixed
+        return (key * 0x9E3779B97F4A7C15ull) >> 32 & (entries.size() - 1);
+    }
+    ///returns the entry with key, or the empty entry where it would go
+    Entry *find(uint64_t key);
+    ///empties entry i and moves later entries of its probe chain back into the hole
+    void erase_at(size_t i);
+    void rehash(size_t capacity);
+    void remove_slot_key(uint32_t slot, uint64_t key);
+public:
+    CEng1ContactTable();
+
+    /** Records that a touched b (in that order) at time now. Returns whether they touched
+     *  before, in which case prev_time is set to the last time they did.
+     */
+    bool record_contact(map_obj::MapObjHandle a, map_obj::MapObjHandle b, double now, double *prev_time);
+    ///drops the contacts of the objects at deleted_idx; call this before map_objs.erase()
+    void remove_objs(const std::vector<int> &deleted_idx, const MapObjSlotMap &map_objs);
+    void clear();
+    inline size_t size() const
+    {
+        return num_used;
+    }
+};
+
+}
@@ -1,10 +1,13 @@
 #pragma once
 
+#include "geo2/ceng1_collision_filter.h"
+#include "geo2/ceng1_polygon_arena.h"
 #include "geo2/geometry.h"
 
 #include <memory>
 #include <vector>
-#include <cstring>
+#include <limits>
+#include <cstdint>
 
 namespace geo2 {
 
@@ -15,111 +18,158 @@ namespace map_obj
 }
 
 /** The vast majority of the time, there will be only one shape, so this case
- *  is optimized for
+ *  is optimized for. Shapes with up to CEng1PolygonArena::MAX_N vertices are put into the
+ *  collision engine's arena (if it's set), so the shapes of neighbouring objects are next
+ *  to each other in memory instead of being separate heap allocations.
  */
 class CEng1Data final
 {
+    static constexpr uint32_t NO_SLOT = std::numeric_limits<uint32_t>::max();
+
+    ///a polygon in the arena, or one that's on the heap if slot is NO_SLOT
+    struct PolygonRef
+    {
+        Polygon *polygon;
+        uint32_t slot;
+    };
     struct PolygonData
     {
-        int num_polygons;
-
-        union
-        {
-            std::unique_ptr<Polygon> ptr;
-            //use a pointer to save memory because we won't use this 99% of the time
-            std::unique_ptr<std::vector<std::unique_ptr<Polygon>>> vec;
-        };
-
-        PolygonData():
-            num_polygons(0)
-        {}
-        PolygonData(PolygonData &&other)
-        {
-            //we copy the biggest member of the union; here we assume it's vec
-            static_assert(sizeof(vec) >= sizeof(ptr));
-
-            num_polygons = other.num_polygons;
-            other.num_polygons = 0;
-            std::memcpy((void*)&vec, (void*)&other.vec, sizeof(vec));
-        }
-        PolygonData &operator = (PolygonData &&other)
-        {
-            //we copy the biggest member of the union; here we assume it's vec
-            static_assert(sizeof(vec) >= sizeof(ptr));
-
-            num_polygons = other.num_polygons;
-            other.num_polygons = 0;
-            std::memcpy((void*)&vec, (void*)&other.vec, sizeof(vec));
-            return *this;
-        }
-        ~PolygonData()
-        {
-            if(num_polygons == 1)
-                ptr.~unique_ptr();
-            else if(num_polygons > 1)
-                vec.~unique_ptr();
-        }
-        void push_back(std::unique_ptr<Polygon> &&polygon)
-        {
-            if(num_polygons == 0) {
-                new (&ptr) decltype(ptr)(std::move(polygon));
-            } else if(num_polygons >= 1) {
-                if(num_polygons == 1) {
-                    auto tmp = std::move(ptr);
-                    new (&vec) decltype(vec)();
-                    vec->push_back(std::move(tmp));
-                }
-                vec->push_back(std::move(polygon));
-            }
-            num_polygons++;
-        }
+        int num_polygons = 0;
+        PolygonRef first;
+        //use a pointer to save memory because we won't use this 99% of the time
+        std::unique_ptr<std::vector<PolygonRef>> rest;
     };
 
     PolygonData cur;
     PolygonData des;
 
+    CEng1PolygonArena *arena = nullptr;
     MoveIntent move_intent;
+    //static objects never move, and their current position shapes never change after
+    //init(), so the collision engine only has to put them into its grid once
+    bool static_obj = false;
+    CEng1CollisionFilter collision_filter;
 
     template<class Func> inline static void for_each(const PolygonData &data, const Func &func)
     {
-        if(__builtin_expect(data.num_polygons == 1, 1)) {
-            func(data.ptr.get(), 0);
-        } else if(data.num_polygons > 1) {
-            for(size_t i=0; i<data.vec->size(); i++) {
-                func((*data.vec)[i].get(), i);
+        if(__builtin_expect(data.num_polygons >= 1, 1))
+            func(data.first.polygon, 0);
+        if(__builtin_expect(data.num_polygons > 1, 0)) {
+            for(size_t i=0; i<data.rest->size(); i++) {
+                func((*data.rest)[i].polygon, i + 1);
             }
         }
     }
+    inline void add_polygon(PolygonData *data, uint32_t num_sides)
+    {
+        PolygonRef ref;
+        if(arena != nullptr && num_sides <= CEng1PolygonArena::MAX_N) {
+            ref.slot = arena->allocate(num_sides);
+            ref.polygon = arena->get(ref.slot);
+        } else {
+            ref.slot = NO_SLOT;
+            ref.polygon = Polygon::make_with_num_sides(num_sides).release();
+        }
+
+        if(data->num_polygons == 0)
+            data->first = ref;
+        else {
+            if(data->rest == nullptr)
+                data->rest = std::make_unique<std::vector<PolygonRef>>();
+            data->rest->push_back(ref);
+        }
+        data->num_polygons++;
+    }
+    inline void free_polygon(PolygonRef ref)
+    {
+        if(ref.slot == NO_SLOT)
+            delete ref.polygon;
+        else
+            arena->deallocate(ref.slot);
+    }
+    inline void free_polygons(PolygonData *data)
+    {
+        if(data->num_polygons >= 1)
+            free_polygon(data->first);
+        if(data->num_polygons > 1) {
+            for(auto ref: *data->rest)
+                free_polygon(ref);
+        }
+        data->num_polygons = 0;
+        data->rest.reset();
+    }
 public:
     CEng1Data() = default;
+    ~CEng1Data()
+    {
+        free_polygons(&cur);
+        free_polygons(&des);
+    }
+    ///moving only copies a few pointers, the polygons stay where they are
+    CEng1Data(CEng1Data &&other) noexcept:
+        cur(std::move(other.cur)),
+        des(std::move(other.des)),
+        arena(other.arena),
+        move_intent(other.move_intent),
+        static_obj(other.static_obj),
+        collision_filter(other.collision_filter)
+    {
+        other.cur.num_polygons = 0;
+        other.des.num_polygons = 0;
+    }
+    CEng1Data &operator = (CEng1Data &&other) noexcept
+    {
+        if(this != &other) {
+            free_polygons(&cur);
+            free_polygons(&des);
+            cur = std::move(other.cur);
+            des = std::move(other.des);
+            arena = other.arena;
+            move_intent = other.move_intent;
+            static_obj = other.static_obj;
+            collision_filter = other.collision_filter;
+            other.cur.num_polygons = 0;
+            other.des.num_polygons = 0;
+        }
+        return *this;
+    }
+    CEng1Data(const CEng1Data&) = delete;
+    CEng1Data &operator = (const CEng1Data&) = delete;
 
+    ///call this before adding any polygons; the arena has to outlive this
+    inline void set_polygon_arena(CEng1PolygonArena *arena_)
+    {
+        k_expects(cur.num_polygons == 0 && des.num_polygons == 0);
+        arena = arena_;
+    }
+    ///not thread safe, as the polygons come from the arena
     inline void add_current_pos_polygon_with_num_sides(uint32_t num_sides)
     {
-        cur.push_back(Polygon::make_with_num_sides(num_sides));
+        add_polygon(&cur, num_sides);
     }
     inline void add_desired_pos_polygon_with_num_sides(uint32_t num_sides)
     {
-        des.push_back(Polygon::make_with_num_sides(num_sides));
+        add_polygon(&des, num_sides);
     }
     inline Polygon *get_sole_current_pos()
     {
         k_expects(cur.num_polygons == 1);
-        return cur.ptr.get();
+        return cur.first.polygon;
     }
     inline const Polygon *get_sole_current_pos() const
     {
         k_expects(cur.num_polygons == 1);
-        return cur.ptr.get();
+        return cur.first.polygon;
     }
     inline Polygon *get_sole_desired_pos()
     {
         k_expects(des.num_polygons == 1);
-        return des.ptr.get();
+        return des.first.polygon;
     }
     inline const Polygon *get_sole_desired_pos() const
     {
         k_expects(des.num_polygons == 1);
-        return des.ptr.get();
+        return des.first.polygon;
     }
     inline MoveIntent get_move_intent() const
     {
@@ -129,6 +179,22 @@ public:
     {
         move_intent = new_intent;
     }
+    inline bool is_static() const
+    {
+        return static_obj;
+    }
+    inline void set_static(bool static_obj_)
+    {
+        static_obj = static_obj_;
+    }
+    inline CEng1CollisionFilter get_collision_filter() const
+    {
+        return collision_filter;
+    }
+    inline void set_collision_filter(CEng1CollisionFilter filter)
+    {
+        collision_filter = filter;
+    }
     template<class Func> inline void for_each_cur(const Func &func)
     {
         for_each(cur, func);
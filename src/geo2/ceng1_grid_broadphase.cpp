@@ -0,0 +1,266 @@
+#include "geo2/ceng1_grid_broadphase.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace geo2 {
+
+int CEng1GridBroadphase::GridGeometry::x_to_grid_x(float x) const
+{
+    int x_ = std::clamp((int)((x - global_AABB.x1) / grid_rect_w), 0, GRID_LEN - 1);
+    return x_;
+}
+int CEng1GridBroadphase::GridGeometry::y_to_grid_y(float y) const
+{
+    int y_ = std::clamp((int)((y - global_AABB.y1) / grid_rect_h), 0, GRID_LEN - 1);
+    return y_;
+}
+int CEng1GridBroadphase::GridGeometry::get_grid_cell(const AABB &aabb) const
+{
+    return x_to_grid_x(aabb.x1)*GRID_LEN + y_to_grid_y(aabb.y1);
+}
+void CEng1GridBroadphase::GridGeometry::fit_to(const CEng1AABBStore &aabbs)
+{
+    //we grid things based on their top left corner, so calculate the global
+    //AABB based on top left corners only.
+    aabbs.get_bounds(&global_AABB, &max_AABB_w, &max_AABB_h);
+
+    update_grid_rect_size();
+}
+void CEng1GridBroadphase::GridGeometry::update_grid_rect_size()
+{
+    //don't divide by 0 later if there's only 1 object (or everything is lined up)
+    constexpr float MIN_GRID_RECT_LEN = 1e-3f;
+    grid_rect_w = std::max((global_AABB.x2 - global_AABB.x1) / GRID_LEN, MIN_GRID_RECT_LEN);
+    grid_rect_h = std::max((global_AABB.y2 - global_AABB.y1) / GRID_LEN, MIN_GRID_RECT_LEN);
+}
+void CEng1GridBroadphase::insert_into_grid(const CEng1Obj &obj, const AABB &aabb)
+{
+    int cell = geometry.get_grid_cell(aabb);
+    grid.push_back(cell, obj, aabb);
+    obj_cells[obj.idx].push_back(cell);
+}
+void CEng1GridBroadphase::rebuild_grid()
+{
+    grid.reset();
+    for(auto &cells: obj_cells)
+        cells.clear();
+
+    //step 2
+    //this until processing the active objects takes ~80us on Test2(40, 40)
+    geometry.fit_to(objs_aabbs);
+
+    //the bounds are kept until the next rebuild in Persistent mode, so make sure they
+    //at least cover the level
+    if(grid_mode == GridMode::Persistent && level_bounds.x1 <= level_bounds.x2) {
+        geometry.global_AABB.x1 = std::min(geometry.global_AABB.x1, level_bounds.x1);
+        geometry.global_AABB.x2 = std::max(geometry.global_AABB.x2, level_bounds.x2);
+        geometry.global_AABB.y1 = std::min(geometry.global_AABB.y1, level_bounds.y1);
+        geometry.global_AABB.y2 = std::max(geometry.global_AABB.y2, level_bounds.y2);
+    }
+    geometry.update_grid_rect_size();
+
+    //step 3
+    //~100us on Test2(40, 40)
+    for(size_t i=0; i<objs.size(); i++)
+        insert_into_grid(objs[i], objs_aabbs.get_AABB(i));
+
+    grid_needs_rebuild = false;
+}
+void CEng1GridBroadphase::update_persistent_grid()
+{
+    //objs is sorted by idx, so the shapes of each object are contiguous
+    size_t obj_begin = 0;
+    for(size_t i=0; i<obj_cells.size(); i++) {
+        size_t obj_end = obj_begin;
+        while(obj_end < objs.size() && objs[obj_end].idx == (int)i)
+            obj_end++;
+
+        auto &cells = obj_cells[i];
+        if(obj_end - obj_begin == 1 && cells.size() == 1) {
+            //the vast majority of objects have only 1 shape and stay in the same cell
+            const auto &obj = objs[obj_begin];
+            auto aabb = objs_aabbs.get_AABB(obj_begin);
+            geometry.max_AABB_w = std::max(geometry.max_AABB_w, aabb.x2 - aabb.x1);
+            geometry.max_AABB_h = std::max(geometry.max_AABB_h, aabb.y2 - aabb.y1);
+
+            int cell = geometry.get_grid_cell(aabb);
+            if(cell == cells[0])
+                grid.replace_one_with_idx(cell, i, obj, aabb);
+            else {
+                grid.remove_one_with_idx(cells[0], i);
+                grid.push_back(cell, obj, aabb);
+                cells[0] = cell;
+            }
+        } else {
+            remove(i);
+            for(size_t j=obj_begin; j<obj_end; j++) {
+                auto aabb = objs_aabbs.get_AABB(j);
+                geometry.max_AABB_w = std::max(geometry.max_AABB_w, aabb.x2 - aabb.x1);
+                geometry.max_AABB_h = std::max(geometry.max_AABB_h, aabb.y2 - aabb.y1);
+                insert_into_grid(objs[j], aabb);
+            }
+        }
+
+        obj_begin = obj_end;
+    }
+}
+CEng1GridBroadphase::CEng1GridBroadphase(GridMode grid_mode_):
+    grid_mode(grid_mode_),
+    grid_needs_rebuild(true),
+    level_bounds(AABB::make_maxbad_AABB())
+{
+
+}
+CEng1GridBroadphase::GridMode CEng1GridBroadphase::get_grid_mode() const
+{
+    return grid_mode;
+}
+void CEng1GridBroadphase::reset()
+{
+    grid.reset();
+    obj_cells.clear();
+    objs.clear();
+    objs_aabbs.clear();
+    level_bounds = AABB::make_maxbad_AABB();
+    grid_needs_rebuild = true;
+}
+void CEng1GridBroadphase::set_level_bounds(const AABB &bounds)
+{
+    level_bounds = bounds;
+    grid_needs_rebuild = true;
+}
+void CEng1GridBroadphase::process_added_objs(int num_objs)
+{
+    //new objects are put in the grid by the next set_objs() call
+    obj_cells.resize(num_objs);
+}
+void CEng1GridBroadphase::process_deleted_objs(const std::vector<int> &deleted_idx,
+                                               const std::vector<CEng1IdxMove> &moves)
+{
+    if(deleted_idx.empty())
+        return;
+
+    k_expects(deleted_idx.back() < (int)obj_cells.size());
+    size_t new_size = obj_cells.size() - deleted_idx.size();
+
+    if(grid_mode == GridMode::RebuildEachTick) {
+        //the grid is cleared before it's used again anyway
+        obj_cells.resize(new_size);
+        return;
+    }
+
+    for(int idx: deleted_idx)
+        remove(idx);
+
+    //only the moved objects change their idx, like in Game
+    for(auto move: moves) {
+        for(int cell: obj_cells[move.from])
+            grid.change_idx(cell, move.from, move.to);
+        std::swap(obj_cells[move.to], obj_cells[move.from]);
+    }
+    obj_cells.resize(new_size);
+}
+void CEng1GridBroadphase::set_objs(const std::vector<CEng1Obj> &objs_)
+{
+    objs = objs_;
+    //this is the only time we look at the polygons of the active objects
+    objs_aabbs.clear();
+    objs_aabbs.reserve(objs.size());
+    for(const auto &obj: objs)
+        objs_aabbs.push_back(obj.polygon->get_AABB(), obj.idx);
+
+    //steps 2 and 3
+    if(grid_mode == GridMode::RebuildEachTick || grid_needs_rebuild)
+        rebuild_grid();
+    else
+        update_persistent_grid();
+}
+void CEng1GridBroadphase::find_pairs(int part, int num_parts,
+                                     std::vector<CEng1ObjPair> *add_to) const
+{
+    size_t idx1 = objs.size() * part / (double)num_parts;
+    size_t idx2 = objs.size() * (part+1) / (double)num_parts;
+
+    for(size_t i=idx1; i<idx2; i++) {
+        //Only look for collisions to the right! Break ties by x.
+        const auto &obj = objs[i];
+        auto aabb = objs_aabbs.get_AABB(i);
+        int x1 = geometry.x_to_grid_x(aabb.x1);
+        int x2 = geometry.x_to_grid_x(aabb.x2);
+        int y1 = geometry.y_to_grid_y(aabb.y1 - geometry.max_AABB_h);
+        int y2 = geometry.y_to_grid_y(aabb.y2);
+
+        //the AABB store already filtered out shapes with the same owner or
+        //non-overlapping AABBs without touching their polygons
+
+        //to optimize for performance, break this into two cases:
+        //(1) same x grid value
+        for(int y=y1; y<=y2; y++) {
+            const auto &cell = grid.get_const_cell(x1, y);
+            cell.aabbs.for_each_overlap(aabb, obj.idx, [&obj, &aabb, &cell, add_to](size_t j)
+                {
+                    const auto &other = cell.vals[j];
+                    float other_x1 = cell.aabbs.get_AABB(j).x1;
+
+                    //only consider other objects with AABBs to the right, breaking ties by index
+                    if(aabb.x1 < other_x1)
+                        return;
+                    if(aabb.x1 == other_x1 && obj.idx <= other.idx)
+                        return;
+
+                    if(obj.filter.could_matter(other.filter))
+                        add_to->push_back(CEng1ObjPair{&obj, &other});
+                });
+        }
+
+        //(2) higher x grid value
+        for(int x=x1+1; x<=x2; x++) {
+            for(int y=y1; y<=y2; y++) {
+                const auto &cell = grid.get_const_cell(x, y);
+                cell.aabbs.for_each_overlap(aabb, obj.idx, [&obj, &cell, add_to](size_t j)
+                    {
+                        if(obj.filter.could_matter(cell.vals[j].filter))
+                            add_to->push_back(CEng1ObjPair{&obj, &cell.vals[j]});
+                    });
+            }
+        }
+    }
+}
+void CEng1GridBroadphase::find_overlaps(const CEng1Obj &obj,
+                                        std::vector<CEng1ObjPair> *add_to) const
+{
+    const auto &aabb = obj.polygon->get_AABB();
+    int x1 = geometry.x_to_grid_x(aabb.x1 - geometry.max_AABB_w);
+    int x2 = geometry.x_to_grid_x(aabb.x2);
+    int y1 = geometry.y_to_grid_y(aabb.y1 - geometry.max_AABB_h);
+    int y2 = geometry.y_to_grid_y(aabb.y2);
+
+    for(int x=x1; x<=x2; x++) {
+        for(int y=y1; y<=y2; y++) {
+            const auto &cell = grid.get_const_cell(x, y);
+            cell.aabbs.for_each_overlap(aabb, obj.idx, [&obj, &cell, add_to](size_t i)
+                {
+                    if(obj.filter.could_matter(cell.vals[i].filter))
+                        add_to->push_back(CEng1ObjPair{&obj, &cell.vals[i]});
+                });
+        }
+    }
+}
+void CEng1GridBroadphase::insert(const CEng1Obj &obj)
+{
+    auto aabb = obj.polygon->get_AABB();
+    //we don't have to update global_AABB because that's only used
+    //for optimization (making the grid bounds as tight as possible)
+    geometry.max_AABB_w = std::max(geometry.max_AABB_w, aabb.x2 - aabb.x1);
+    geometry.max_AABB_h = std::max(geometry.max_AABB_h, aabb.y2 - aabb.y1);
+    insert_into_grid(obj, aabb);
+}
+void CEng1GridBroadphase::remove(int idx)
+{
+    for(int cell: obj_cells[idx])
+        grid.remove_one_with_idx(cell, idx);
+    obj_cells[idx].clear();
+}
+
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "geo2/ceng1_aabb_store.h"
+#include "geo2/ceng1_broadphase.h"
+#include "geo2/geometry.h"
+
+#include "kx/fixed_size_array.h"
+#include "kx/kx_span.h"
+
+#include <array>
+#include <vector>
+
+namespace geo2 {
+
+///a uniform grid over the bounding box of the top left corners of everything in it
+class CEng1GridBroadphase final: public CEng1Broadphase
+{
+public:
+    /** -RebuildEachTick clears the grid and inserts every active shape into it again
+     *   every tick.
+     *  -Persistent keeps shapes in the grid across ticks. An object's grid entry is updated
+     *   in place unless it moved to another cell. The grid bounds are only recalculated when
+     *   the grid is built (i.e. when the level bounds change or after reset()), and they
+     *   also cover the level bounds; shapes outside of the bounds are clamped to the
+     *   border cells, which is still correct, just slower.
+     *  Both modes find exactly the same pairs.
+     */
+    enum class GridMode {RebuildEachTick, Persistent};
+
+    constexpr static int GRID_LEN = 128; //power of 2 is faster cuz mult turns into bitshift
+
+    //fastish spatial partition grid; each cell also keeps the AABBs of its values in a
+    //CEng1AABBStore, so T needs an idx
+    template<class T> class Grid
+    {
+    public:
+        struct Cell
+        {
+            std::vector<T> vals;
+            CEng1AABBStore aabbs; //aabbs[i] belongs to vals[i]
+        };
+    private:
+        std::array<Cell, GRID_LEN * GRID_LEN> cells;
+
+        inline size_t find_pos_with_idx(int cell, int idx) const
+        {
+            size_t pos = cells[cell].aabbs.find_idx(idx);
+            //no matches found!
+            k_assert(pos < cells[cell].vals.size());
+            return pos;
+        }
+    public:
+        void reset()
+        {
+            for(auto &cell: cells) {
+                cell.vals.clear();
+                cell.aabbs.clear();
+            }
+        }
+        inline const Cell& get_const_cell(int a, int b) const
+        {
+            return cells[a*GRID_LEN + b];
+        }
+        inline void push_back(int cell, const T &val, const AABB &aabb)
+        {
+            cells[cell].vals.push_back(val);
+            cells[cell].aabbs.push_back(aabb, val.idx);
+        }
+        inline void remove_one_with_idx(int cell, int idx)
+        {
+            auto &grid_cell = cells[cell];
+            size_t pos = find_pos_with_idx(cell, idx);
+            grid_cell.vals[pos] = grid_cell.vals.back();
+            grid_cell.vals.pop_back();
+            grid_cell.aabbs.remove_by_swapping_with_back(pos);
+        }
+        inline void replace_one_with_idx(int cell, int idx, const T &val, const AABB &aabb)
+        {
+            size_t pos = find_pos_with_idx(cell, idx);
+            cells[cell].vals[pos] = val;
+            cells[cell].aabbs.set(pos, aabb, val.idx);
+        }
+        inline void change_idx(int cell, int idx, int new_idx)
+        {
+            size_t pos = find_pos_with_idx(cell, idx);
+            cells[cell].vals[pos].idx = new_idx;
+            cells[cell].aabbs.set_idx(pos, new_idx);
+        }
+    };
+
+    //Static objects never move, so the static grid is built all at once and stored
+    //contiguously; it doesn't support inserting or removing individual objects.
+    template<class T> class StaticGrid
+    {
+        std::vector<T> vals;
+        CEng1AABBStore aabbs; //aabbs[i] belongs to vals[i]
+        std::vector<int> offset; //cell i holds vals[offset[i]] ... vals[offset[i+1] - 1]
+    public:
+        void reset()
+        {
+            vals.clear();
+            aabbs.clear();
+            offset.assign(GRID_LEN*GRID_LEN + 1, 0);
+        }
+        ///cells[i] is the cell that objs[i] goes in, and objs_aabbs[i] is its AABB
+        void build(const std::vector<T> &objs, const CEng1AABBStore &objs_aabbs,
+                   const std::vector<int> &cells)
+        {
+            k_expects(objs.size() == cells.size());
+            k_expects(objs.size() == objs_aabbs.size());
+
+            //counting sort by cell
+            offset.assign(GRID_LEN*GRID_LEN + 1, 0);
+            for(int cell: cells)
+                offset[cell + 1]++;
+            for(int i=1; i<=GRID_LEN*GRID_LEN; i++)
+                offset[i] += offset[i-1];
+
+            std::vector<int> order(objs.size());
+            std::vector<int> next_pos(offset.begin(), offset.end() - 1);
+            for(size_t i=0; i<objs.size(); i++)
+                order[next_pos[cells[i]]++] = i;
+
+            vals.clear();
+            vals.reserve(objs.size());
+            aabbs.clear();
+            aabbs.reserve(objs.size());
+            for(int i: order) {
+                vals.push_back(objs[i]);
+                aabbs.push_back(objs_aabbs.get_AABB(i), objs[i].idx);
+            }
+        }
+        ///calls func(val) for every val in cell (a, b) that overlaps aabb and isn't owned by idx
+        template<class Func> inline void for_each_overlap(int a, int b, const AABB &aabb, int idx,
+                                                          const Func &func) const
+        {
+            int cell = a*GRID_LEN + b;
+            aabbs.for_each_overlap(offset[cell], offset[cell + 1], aabb, idx,
+                                   [this, &func](size_t i)
+                                   {
+                                       func(vals[i]);
+                                   });
+        }
+        ///sets the idx of every value to new_idx(idx)
+        template<class Func> inline void update_idx(const Func &new_idx)
+        {
+            for(size_t i=0; i<vals.size(); i++) {
+                vals[i].idx = new_idx(vals[i].idx);
+                aabbs.set_idx(i, vals[i].idx);
+            }
+        }
+        inline bool empty() const
+        {
+            return vals.empty();
+        }
+    };
+
+    ///determines which grid cell an object goes in (based on its top left corner)
+    struct GridGeometry
+    {
+        AABB global_AABB; //bounding box of the top left corners of all objects in the grid
+        float grid_rect_w;
+        float grid_rect_h;
+        //the largest AABB dimensions in the grid, which determine how far we have to look
+        float max_AABB_w;
+        float max_AABB_h;
+
+        int x_to_grid_x(float x) const;
+        int y_to_grid_y(float y) const;
+        int get_grid_cell(const AABB &aabb) const;
+        void fit_to(const CEng1AABBStore &aabbs);
+        void update_grid_rect_size();
+    };
+
+    /*
+    template<class T> class Grid
+    {
+        kx::FixedSizeArray<T> vals;
+        std::array<int, GRID_LEN*GRID_LEN> offset;
+        std::array<int, GRID_LEN*GRID_LEN> cur_size;
+    public:
+        Grid()
+        {}
+        void init_with_max_sizes(kx::kx_span<int> max_sizes)
+        {
+            std::fill(std::begin(cur_size), std::end(cur_size), 0);
+            offset[0] = 0;
+            for(int i=1; i<GRID_LEN*GRID_LEN; i++)
+                offset[i] = offset[i-1] + max_sizes[i-1];
+            vals = decltype(vals)(max_sizes[GRID_LEN*GRID_LEN-1] + offset[GRID_LEN*GRID_LEN-1]);
+        }
+        inline std::vector<T>& get_ref(int a, int b)
+        {
+            return vals[a*GRID_LEN + b];
+        }
+    }
+    */
+
+private:
+    GridMode grid_mode;
+    bool grid_needs_rebuild;
+    Grid<CEng1Obj> grid;
+    GridGeometry geometry;
+    AABB level_bounds;
+    std::vector<CEng1Obj> objs;
+    CEng1AABBStore objs_aabbs; //objs_aabbs[i] is the AABB of objs[i]
+    //obj_cells[i] holds the grid cells that the shapes of object i are currently in,
+    //which is what we use to find (and remove) them
+    std::vector<std::vector<int>> obj_cells;
+
+    void rebuild_grid();
+    void update_persistent_grid();
+    void insert_into_grid(const CEng1Obj &obj, const AABB &aabb);
+public:
+    CEng1GridBroadphase(GridMode grid_mode_);
+
+    GridMode get_grid_mode() const;
+
+    void reset() override;
+    void set_level_bounds(const AABB &bounds) override;
+    void process_added_objs(int num_objs) override;
+    void process_deleted_objs(const std::vector<int> &deleted_idx,
+                              const std::vector<CEng1IdxMove> &moves) override;
+    void set_objs(const std::vector<CEng1Obj> &objs_) override;
+    void find_pairs(int part, int num_parts, std::vector<CEng1ObjPair> *add_to) const override;
+    void find_overlaps(const CEng1Obj &obj, std::vector<CEng1ObjPair> *add_to) const override;
+    void insert(const CEng1Obj &obj) override;
+    void remove(int idx) override;
+};
+
+}
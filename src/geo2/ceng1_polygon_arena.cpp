@@ -0,0 +1,58 @@
+#include "geo2/ceng1_polygon_arena.h"
+
+#include <new>
+#include <type_traits>
+
+namespace geo2 {
+
+//slots are reused without calling the destructor
+static_assert(std::is_trivially_destructible_v<Polygon>);
+
+void CEng1PolygonArena::ChunkDeleter::operator()(uint8_t *chunk) const
+{
+    ::operator delete(chunk, std::align_val_t(ALIGNMENT));
+}
+CEng1PolygonArena::CEng1PolygonArena():
+    slot_size((Polygon::get_size_with_num_sides(MAX_N) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT),
+    num_used_slots(0),
+    num_live(0)
+{}
+CEng1PolygonArena::~CEng1PolygonArena()
+{
+    k_expects(num_live == 0);
+}
+uint32_t CEng1PolygonArena::allocate(uint32_t num_sides)
+{
+    k_expects(num_sides <= MAX_N);
+
+    uint32_t slot;
+    if(!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    } else {
+        if(num_used_slots == chunks.size() * SLOTS_PER_CHUNK) {
+            auto chunk = (uint8_t*)::operator new(SLOTS_PER_CHUNK * slot_size, std::align_val_t(ALIGNMENT));
+            chunks.emplace_back(chunk);
+        }
+        slot = num_used_slots++;
+    }
+
+    Polygon::make_with_num_sides_at(get(slot), num_sides);
+    num_live++;
+    return slot;
+}
+void CEng1PolygonArena::deallocate(uint32_t slot)
+{
+    k_expects(slot < num_used_slots && num_live > 0);
+
+    //polygons are trivially destructible, so the slot can just be reused
+    num_live--;
+    if(num_live == 0) {
+        //start from the beginning again, so the next level's objects are in order
+        free_slots.clear();
+        num_used_slots = 0;
+    } else
+        free_slots.push_back(slot);
+}
+
+}
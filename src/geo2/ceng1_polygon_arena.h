@@ -0,0 +1,56 @@
+#pragma once
+
+#include "geo2/geometry.h"
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace geo2 {
+
+/** Storage for the shapes of the objects in ceng_data. Small polygons are all put into
+ *  slots of the same size, in chunks that never move, so pointers to them stay valid and
+ *  the shapes of objects that were added together are next to each other in memory.
+ *  Freed slots are reused, and once everything is freed (e.g. between levels), slots are
+ *  handed out in order again. Not thread safe.
+ */
+class CEng1PolygonArena final
+{
+public:
+    ///polygons with more vertices than this have to be allocated separately
+    static constexpr uint32_t MAX_N = 8;
+private:
+    static constexpr uint32_t SLOTS_PER_CHUNK = 1024;
+    static constexpr size_t ALIGNMENT = 32;
+
+    struct ChunkDeleter
+    {
+        void operator()(uint8_t *chunk) const;
+    };
+
+    size_t slot_size;
+    std::vector<std::unique_ptr<uint8_t[], ChunkDeleter>> chunks;
+    std::vector<uint32_t> free_slots;
+    uint32_t num_used_slots;
+    uint32_t num_live;
+public:
+    CEng1PolygonArena();
+    ~CEng1PolygonArena();
+
+    CEng1PolygonArena(const CEng1PolygonArena&) = delete;
+    CEng1PolygonArena &operator = (const CEng1PolygonArena&) = delete;
+
+    ///returns the slot of a new polygon with num_sides <= MAX_N vertices
+    uint32_t allocate(uint32_t num_sides);
+    void deallocate(uint32_t slot);
+    inline Polygon *get(uint32_t slot) const
+    {
+        return (Polygon*)(chunks[slot / SLOTS_PER_CHUNK].get() + (slot % SLOTS_PER_CHUNK) * slot_size);
+    }
+    inline uint32_t get_num_live() const
+    {
+        return num_live;
+    }
+};
+
+}
@@ -0,0 +1,258 @@
+#include "geo2/ceng1_sweep_and_prune.h"
+
+#include "kx/sort.h"
+#include "kx/util.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace geo2 {
+
+//maps floats to unsigned ints with the same ordering
+static uint32_t float_to_sortable_u32(float x)
+{
+    uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    return (u & 0x80000000)? ~u: (u | 0x80000000);
+}
+
+void CEng1SweepAndPrune::insertion_sort_entries()
+{
+    for(size_t i=1; i<entries.size(); i++) {
+        if(entries[i-1].aabb.x1 <= entries[i].aabb.x1)
+            continue;
+        auto entry = entries[i];
+        size_t j = i;
+        for(; j>0 && entries[j-1].aabb.x1 > entry.aabb.x1; j--)
+            entries[j] = entries[j-1];
+        entries[j] = entry;
+    }
+}
+void CEng1SweepAndPrune::radix_sort_entries()
+{
+    //the high 32 bits are the key and the low 32 bits are where the entry currently is
+    radix_keys.clear();
+    for(size_t i=0; i<entries.size(); i++)
+        radix_keys.push_back(((uint64_t)float_to_sortable_u32(entries[i].aabb.x1) << 32) | i);
+
+    lsd_radix_sort64_u(radix_keys.data(), radix_keys.size());
+
+    sorted_entries.clear();
+    for(auto key: radix_keys)
+        sorted_entries.push_back(entries[key & 0xffffffff]);
+    std::swap(entries, sorted_entries);
+}
+template<class Func>
+void CEng1SweepAndPrune::for_each_overlap(const std::vector<Entry> &in, const AABB &aabb,
+                                          const Func &func) const
+{
+    auto begin = std::lower_bound(in.begin(), in.end(), aabb.x1 - max_AABB_w,
+                                  [](const Entry &entry, float x) -> bool
+                                  {
+                                      return entry.aabb.x1 < x;
+                                  });
+    for(auto it = begin; it != in.end() && it->aabb.x1 <= aabb.x2; it++) {
+        if(aabb.overlaps(it->aabb) && is_live(*it))
+            func(*it);
+    }
+}
+void CEng1SweepAndPrune::merge_inserted()
+{
+    //on ties, the older entries come first, like when inserting after the last equal one
+    sorted_entries.clear();
+    auto it = inserted.begin();
+    for(const auto &entry: entries) {
+        for(; it != inserted.end() && it->aabb.x1 < entry.aabb.x1; it++) {
+            if(is_live(*it))
+                sorted_entries.push_back(*it);
+        }
+        if(is_live(entry))
+            sorted_entries.push_back(entry);
+    }
+    for(; it != inserted.end(); it++) {
+        if(is_live(*it))
+            sorted_entries.push_back(*it);
+    }
+    std::swap(entries, sorted_entries);
+    inserted.clear();
+    num_dead = 0;
+}
+void CEng1SweepAndPrune::update_obj_rank()
+{
+    std::fill(obj_rank.begin(), obj_rank.end(), -1);
+    for(size_t i=0; i<entries.size(); i++)
+        obj_rank[entries[i].obj.idx] = i;
+}
+CEng1SweepAndPrune::CEng1SweepAndPrune():
+    num_dead(0),
+    max_AABB_w(0.0f)
+{}
+void CEng1SweepAndPrune::reset()
+{
+    entries.clear();
+    inserted.clear();
+    obj_gen.clear();
+    obj_num_live.clear();
+    num_dead = 0;
+    obj_rank.clear();
+    max_AABB_w = 0.0f;
+}
+void CEng1SweepAndPrune::process_added_objs(int num_objs)
+{
+    obj_rank.resize(num_objs, -1);
+    obj_gen.resize(num_objs, 0);
+    obj_num_live.resize(num_objs, 0);
+}
+void CEng1SweepAndPrune::process_deleted_objs(const std::vector<int> &deleted_idx,
+                                              const std::vector<CEng1IdxMove> &moves)
+{
+    if(deleted_idx.empty())
+        return;
+
+    k_expects(deleted_idx.back() < (int)obj_rank.size());
+    int new_size = obj_rank.size() - deleted_idx.size();
+
+    //afterwards, every entry is live and in entries
+    merge_inserted();
+
+    //entries aren't sorted by idx, so this is a pass over all of them either way
+    kx::erase_remove_if(&entries, [&deleted_idx](const Entry &entry) -> bool
+                                  {
+                                      return std::binary_search(deleted_idx.begin(),
+                                                                deleted_idx.end(),
+                                                                entry.obj.idx);
+                                  });
+    //every object that moved came from past new_size
+    moved_to.assign(obj_rank.size() - new_size, -1);
+    for(auto move: moves) {
+        moved_to[move.from - new_size] = move.to;
+        obj_gen[move.to] = obj_gen[move.from];
+        obj_num_live[move.to] = obj_num_live[move.from];
+    }
+    for(auto &entry: entries) {
+        if(entry.obj.idx >= new_size)
+            entry.obj.idx = moved_to[entry.obj.idx - new_size];
+    }
+
+    obj_rank.resize(new_size);
+    obj_gen.resize(new_size);
+    obj_num_live.resize(new_size);
+    update_obj_rank();
+}
+void CEng1SweepAndPrune::set_objs(const std::vector<CEng1Obj> &objs)
+{
+    //put the objects that were here last time in their old order, followed by the new ones
+    slots.assign(entries.size(), -1);
+    new_objs.clear();
+    for(size_t i=0; i<objs.size(); i++) {
+        int rank = obj_rank[objs[i].idx];
+        if(rank >= 0 && rank < (int)slots.size() && slots[rank] == -1)
+            slots[rank] = i;
+        else
+            new_objs.push_back(i);
+    }
+
+    entries.clear();
+    inserted.clear();
+    num_dead = 0;
+    std::fill(obj_num_live.begin(), obj_num_live.end(), 0);
+    max_AABB_w = 0.0f;
+    auto add_entry = [this, &objs](int i) -> void
+                     {
+                         const auto &aabb = objs[i].polygon->get_AABB();
+                         max_AABB_w = std::max(max_AABB_w, aabb.x2 - aabb.x1);
+                         entries.push_back(Entry{aabb, objs[i], obj_gen[objs[i].idx]});
+                         obj_num_live[objs[i].idx]++;
+                     };
+    for(int i: slots) {
+        if(i != -1)
+            add_entry(i);
+    }
+    for(int i: new_objs)
+        add_entry(i);
+
+    //insertion sort is quadratic if the order is far off, e.g. when a level starts
+    if(new_objs.size() > 32 && new_objs.size() > entries.size() / 4)
+        radix_sort_entries();
+    else
+        insertion_sort_entries();
+
+    update_obj_rank();
+}
+void CEng1SweepAndPrune::find_pairs(int part, int num_parts,
+                                    std::vector<CEng1ObjPair> *add_to) const
+{
+    size_t idx1 = entries.size() * part / (double)num_parts;
+    size_t idx2 = entries.size() * (part+1) / (double)num_parts;
+
+    for(size_t i=idx1; i<idx2; i++) {
+        const auto &entry = entries[i];
+        if(!is_live(entry))
+            continue;
+        //everything after this has a bigger (or equal) x1, so we can stop once x1 is
+        //past our x2; use <= because AABBs with 0 width can still overlap
+        for(size_t j=i+1; j<entries.size() && entries[j].aabb.x1 <= entry.aabb.x2; j++) {
+            const auto &other = entries[j];
+            if(entry.obj.filter.could_matter(other.obj.filter) && entry.obj.idx != other.obj.idx &&
+               entry.aabb.overlaps(other.aabb) && is_live(other))
+                add_to->push_back(CEng1ObjPair{&entry.obj, &other.obj});
+        }
+    }
+
+    //inserted is usually empty right after set_objs(), so the last part does it
+    if(part != num_parts - 1)
+        return;
+    for(size_t i=0; i<inserted.size(); i++) {
+        const auto &entry = inserted[i];
+        if(!is_live(entry))
+            continue;
+        auto add_pair = [&entry, add_to](const Entry &other)
+                        {
+                            if(entry.obj.filter.could_matter(other.obj.filter) &&
+                               entry.obj.idx != other.obj.idx)
+                                add_to->push_back(CEng1ObjPair{&entry.obj, &other.obj});
+                        };
+        for_each_overlap(entries, entry.aabb, add_pair);
+        for(size_t j=i+1; j<inserted.size() && inserted[j].aabb.x1 <= entry.aabb.x2; j++) {
+            if(entry.aabb.overlaps(inserted[j].aabb) && is_live(inserted[j]))
+                add_pair(inserted[j]);
+        }
+    }
+}
+void CEng1SweepAndPrune::find_overlaps(const CEng1Obj &obj,
+                                       std::vector<CEng1ObjPair> *add_to) const
+{
+    auto add_pair = [&obj, add_to](const Entry &other)
+                    {
+                        if(obj.filter.could_matter(other.obj.filter) && obj.idx != other.obj.idx)
+                            add_to->push_back(CEng1ObjPair{&obj, &other.obj});
+                    };
+    const auto &aabb = obj.polygon->get_AABB();
+    for_each_overlap(entries, aabb, add_pair);
+    for_each_overlap(inserted, aabb, add_pair);
+}
+void CEng1SweepAndPrune::insert(const CEng1Obj &obj)
+{
+    const auto &aabb = obj.polygon->get_AABB();
+    max_AABB_w = std::max(max_AABB_w, aabb.x2 - aabb.x1);
+    auto pos = std::upper_bound(inserted.begin(), inserted.end(), aabb.x1,
+                                [](float x, const Entry &entry) -> bool
+                                {
+                                    return x < entry.aabb.x1;
+                                });
+    //obj_rank is only used as a hint, so it doesn't have to be updated
+    inserted.insert(pos, Entry{aabb, obj, obj_gen[obj.idx]});
+    obj_num_live[obj.idx]++;
+    if(inserted.size() > std::max(MIN_MERGE_SIZE, entries.size() / 16))
+        merge_inserted();
+}
+void CEng1SweepAndPrune::remove(int idx)
+{
+    obj_gen[idx]++;
+    num_dead += obj_num_live[idx];
+    obj_num_live[idx] = 0;
+    if(num_dead > std::max(MIN_MERGE_SIZE, entries.size() / 4))
+        merge_inserted();
+}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "geo2/ceng1_broadphase.h"
+#include "geo2/geometry.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace geo2 {
+
+/** Sweep and prune along the x axis. Unlike the grid, it doesn't care how spread out
+ *  things are (e.g. a projectile that flies far away doesn't slow it down).
+ *  The order from the previous set_objs() call is reused, so if things don't move much
+ *  relative to each other, sorting is an insertion sort on nearly sorted data. If a lot
+ *  of objects are new, we fall back to a radix sort.
+ *  insert() and remove() are called for every object that's moved back while collisions
+ *  are resolved, so they don't touch the sorted entries: removed entries are left in place
+ *  as tombstones, and inserted ones go in a small sorted list of their own. Both are merged
+ *  back into the entries once they've grown big enough, and by the next set_objs() call.
+ */
+class CEng1SweepAndPrune final: public CEng1Broadphase
+{
+    static constexpr size_t MIN_MERGE_SIZE = 64;
+
+    struct Entry
+    {
+        AABB aabb;
+        CEng1Obj obj;
+        uint32_t gen; //it's a tombstone if this isn't obj_gen[obj.idx]
+    };
+
+    std::vector<Entry> entries; //sorted by aabb.x1
+    std::vector<Entry> inserted; //sorted by aabb.x1; what insert() added since the last merge
+    //by idx; remove() bumps an object's generation, which kills all its entries at once
+    std::vector<uint32_t> obj_gen;
+    std::vector<int> obj_num_live; //live entries (in both lists)
+    size_t num_dead;
+    //obj_rank[i] is the position of (a shape of) object i in entries after the last
+    //set_objs() call, or -1 if it had no shapes
+    std::vector<int> obj_rank;
+    float max_AABB_w;
+
+    //these persist across calls to save memory allocations
+    std::vector<int> slots;
+    std::vector<int> new_objs;
+    std::vector<uint64_t> radix_keys;
+    std::vector<Entry> sorted_entries;
+    std::vector<int> moved_to;
+
+    inline bool is_live(const Entry &entry) const
+    {
+        return entry.gen == obj_gen[entry.obj.idx];
+    }
+    template<class Func> void for_each_overlap(const std::vector<Entry> &in, const AABB &aabb,
+                                               const Func &func) const;
+    ///moves inserted into entries and drops the tombstones
+    void merge_inserted();
+    void update_obj_rank();
+    void insertion_sort_entries();
+    void radix_sort_entries();
+public:
+    CEng1SweepAndPrune();
+
+    void reset() override;
+    void process_added_objs(int num_objs) override;
+    void process_deleted_objs(const std::vector<int> &deleted_idx,
+                              const std::vector<CEng1IdxMove> &moves) override;
+    void set_objs(const std::vector<CEng1Obj> &objs) override;
+    void find_pairs(int part, int num_parts, std::vector<CEng1ObjPair> *add_to) const override;
+    void find_overlaps(const CEng1Obj &obj, std::vector<CEng1ObjPair> *add_to) const override;
+    void insert(const CEng1Obj &obj) override;
+    void remove(int idx) override;
+};
+
+}
@@ -15,164 +15,148 @@ bool cmp_idx_int(const CEng1Obj &a, int b)
 {
     return a.idx < b;
 }
-int CollisionEngine1::x_to_grid_x(float x) const
+void CollisionEngine1::add_shape_to_grid(const CEng1Obj &obj,
+                                         std::vector<CEng1Collision> *collisions)
 {
-    int x_ = std::clamp((int)((x - global_AABB.x1) / grid_rect_w), 0, GRID_LEN - 1);
-    return x_;
+    pairs.resize(std::max<size_t>(pairs.size(), 1));
+    pairs[0].clear();
+    broadphase->find_overlaps(obj, &pairs[0]);
+    find_and_add_collisions(collisions, pairs[0]);
+    find_and_add_static_collisions(collisions, obj);
+    broadphase->insert(obj);
 }
-int CollisionEngine1::y_to_grid_y(float y) const
+void CollisionEngine1::add_cur_to_grid(int idx, std::vector<CEng1Collision> *collisions)
 {
-    int y_ = std::clamp((int)((y - global_AABB.y1) / grid_rect_h), 0, GRID_LEN - 1);
-    return y_;
+    size_t old_size = collisions->size();
+    auto filter = (*ceng_data)[idx].get_collision_filter();
+    (*ceng_data)[idx].for_each_cur([this, idx, filter, collisions](const Polygon *polygon, int shape_id)
+                                   {
+                                       add_shape_to_grid(CEng1Obj(polygon, idx, shape_id, filter), collisions);
+                                   });
+    //the order that the broadphase finds things in depends on its internal layout
+    std::sort(collisions->begin() + old_size, collisions->end(), CEng1Collision::cmp_idx);
 }
-void CollisionEngine1::remove_cur_from_grid(int idx)
+void CollisionEngine1::add_des_to_grid(int idx, std::vector<CEng1Collision> *collisions)
 {
-    auto remove_obj_from_grid = [this, idx](const Polygon *polygon, int) -> void
-    {
-        auto aabb = polygon->get_AABB();
-        int x = x_to_grid_x(aabb.x1);
-        int y = y_to_grid_y(aabb.y1);
-        grid.remove_one_with_idx(x, y, idx);
-    };
-    (*ceng_data)[idx].for_each_cur(remove_obj_from_grid);
+    size_t old_size = collisions->size();
+    auto filter = (*ceng_data)[idx].get_collision_filter();
+    (*ceng_data)[idx].for_each_des([this, idx, filter, collisions](const Polygon *polygon, int shape_id)
+                                   {
+                                       add_shape_to_grid(CEng1Obj(polygon, idx, shape_id, filter), collisions);
+                                   });
+    std::sort(collisions->begin() + old_size, collisions->end(), CEng1Collision::cmp_idx);
 }
-void CollisionEngine1::remove_des_from_grid(int idx)
+///pairs with the same a, checked with one call to Polygon::has_collision_many()
+class CEng1NarrowphaseBatch final
 {
-    auto remove_obj_from_grid = [this, idx](const Polygon *polygon, int) -> void
+    static constexpr size_t MAX_SIZE = 64;
+
+    const CEng1Obj *query = nullptr;
+    std::array<const CEng1Obj*, MAX_SIZE> others;
+    std::array<const Polygon*, MAX_SIZE> polygons;
+    size_t num_others = 0;
+public:
+    inline size_t size() const
     {
-        auto aabb = polygon->get_AABB();
-        int x = x_to_grid_x(aabb.x1);
-        int y = y_to_grid_y(aabb.y1);
-        grid.remove_one_with_idx(x, y, idx);
-    };
-    (*ceng_data)[idx].for_each_des(remove_obj_from_grid);
-}
-void CollisionEngine1::add_cur_to_grid(int idx, std::vector<CEng1Collision> *collisions)
-{
-    auto add_obj_to_grid = [this, idx, collisions](const Polygon *polygon, int shape_id)
-                            {
-                                auto aabb = polygon->get_AABB();
-                                //we don't have to update global_AABB because that's only used
-                                //for optimization (making the grid bounds as tight as possible)
-                                max_AABB_w = std::max(max_AABB_w, aabb.x2 - aabb.x1);
-                                max_AABB_h = std::max(max_AABB_h, aabb.y2 - aabb.y1);
-                                int x = x_to_grid_x(aabb.x1);
-                                int y = y_to_grid_y(aabb.y1);
-                                CEng1Obj obj(polygon, idx, shape_id);
-                                find_and_add_collisions_neq(collisions, obj);
-                                grid.get_ref(x, y).push_back(obj);
-
+        return num_others;
+    }
+    inline bool full() const
+    {
+        return num_others == MAX_SIZE;
+    }
+    inline const CEng1Obj *get_query() const
+    {
+        return query;
+    }
+    inline void add(const CEng1Obj *a, const CEng1Obj *b)
+    {
+        k_expects(!full() && (num_others == 0 || a == query));
+        query = a;
+        others[num_others] = b;
+        polygons[num_others] = b->polygon;
+        num_others++;
+    }
+    ///adds the pairs that collide (in the order they were added) and empties the batch
+    void flush(std::vector<CEng1Collision> *add_to)
+    {
+        if(num_others == 0)
+            return;
+        auto hits = query->polygon->has_collision_many(
+                        kx::kx_span<const Polygon* const>(polygons.data(), polygons.data() + num_others));
+        for(size_t k=0; k<num_others; k++) {
+            if((hits >> k) & 1) {
+                CEng1Collision collision;
+                collision.idx1 = query->idx;
+                collision.idx2 = others[k]->idx;
+                add_to->push_back(collision);
+            }
+        }
+        num_others = 0;
+    }
+};
 
-                            };
-    (*ceng_data)[idx].for_each_cur(add_obj_to_grid);
+void CollisionEngine1::find_and_add_collisions(std::vector<CEng1Collision> *add_to,
+                                               const std::vector<CEng1ObjPair> &candidates) const
+{
+    //the broadphase already filtered out pairs with the same owner, non-overlapping AABBs
+    //or filters that say the collision can't matter
+    //The broadphases give every object's pairs one after another, so consecutive pairs
+    //with the same a are checked with one call to has_collision_many().
+    CEng1NarrowphaseBatch batch;
+    for(const auto &pair: candidates) {
+        if(pair.a->filter.needs_custom_check(pair.b->filter) && !custom_check(*pair.a, *pair.b))
+            continue;
+        if(batch.size() > 0 && (batch.get_query() != pair.a || batch.full()))
+            batch.flush(add_to);
+        batch.add(pair.a, pair.b);
+    }
+    batch.flush(add_to);
 }
-void CollisionEngine1::add_des_to_grid(int idx, std::vector<CEng1Collision> *collisions)
+bool CollisionEngine1::custom_check(const CEng1Obj &a, const CEng1Obj &b) const
 {
-    auto add_obj_to_grid = [this, idx, collisions](const Polygon *polygon, int shape_id)
-                            {
-                                auto aabb = polygon->get_AABB();
-                                //we don't have to update global_AABB because that's only used
-                                //for optimization (making the grid bounds as tight as possible)
-                                max_AABB_w = std::max(max_AABB_w, aabb.x2 - aabb.x1);
-                                max_AABB_h = std::max(max_AABB_h, aabb.y2 - aabb.y1);
-                                int x = x_to_grid_x(aabb.x1);
-                                int y = y_to_grid_y(aabb.y1);
-                                CEng1Obj obj(polygon, idx, shape_id);
-                                find_and_add_collisions_neq(collisions, obj);
-                                grid.get_ref(x, y).push_back(obj);
-                            };
-    (*ceng_data)[idx].for_each_des(add_obj_to_grid);
+    //objects that didn't ask for the custom check don't get a say
+    const auto &map_obj_a = *(*map_objs)[a.idx];
+    const auto &map_obj_b = *(*map_objs)[b.idx];
+    auto custom = CEng1CollisionFilter::CUSTOM_CHECK;
+    return (!(a.filter.layer & custom) || map_obj_a.collision_could_matter(map_obj_b)) &&
+           (!(b.filter.layer & custom) || map_obj_b.collision_could_matter(map_obj_a));
 }
-void CollisionEngine1::find_and_add_collisions_neq(std::vector<CEng1Collision> *add_to,
-                                                   const CEng1Obj &ceng_obj)
-                                                   const
+template<class Func> void CollisionEngine1::for_each_static_overlap(const CEng1Obj &ceng_obj,
+                                                                    const Func &func) const
 {
+    if(static_grid.empty())
+        return;
+
     const auto &aabb = ceng_obj.polygon->get_AABB();
-    int x1 = x_to_grid_x(aabb.x1 - max_AABB_w);
-    int x2 = x_to_grid_x(aabb.x2);
-    int y1 = y_to_grid_y(aabb.y1 - max_AABB_h);
-    int y2 = y_to_grid_y(aabb.y2);
+    int x1 = static_geometry.x_to_grid_x(aabb.x1 - static_geometry.max_AABB_w);
+    int x2 = static_geometry.x_to_grid_x(aabb.x2);
+    int y1 = static_geometry.y_to_grid_y(aabb.y1 - static_geometry.max_AABB_h);
+    int y2 = static_geometry.y_to_grid_y(aabb.y2);
 
     for(int x=x1; x<=x2; x++) {
         for(int y=y1; y<=y2; y++) {
-            for(const auto &other: grid.get_const_ref(x, y)) {
-                //filter out a potential collision if:
-                //-the .idx (owner) is the same
-                //-the AABBs don't overlap
-                //-the collision wouldn't matter anyway
-                if(ceng_obj.idx != other.idx &&
-                   collision_could_matter(*(*map_objs)[ceng_obj.idx], *(*map_objs)[other.idx]))
+            //ceng_obj is dynamic, so it can't have the same owner as anything in here
+            static_grid.for_each_overlap(x, y, aabb, ceng_obj.idx, [&ceng_obj, &func](const CEng1Obj &other)
                 {
-                    if(ceng_obj.polygon->has_collision(*other.polygon)) {
-                        CEng1Collision collision;
-                        collision.idx1 = ceng_obj.idx;
-                        collision.idx2 = other.idx;
-                        add_to->push_back(collision);
-                    }
-                }
-            }
+                    if(ceng_obj.filter.could_matter(other.filter))
+                        func(other);
+                });
         }
     }
 }
-void CollisionEngine1::find_and_add_collisions_gt(std::vector<CEng1Collision> *add_to,
-                                                  const CEng1Obj &ceng_obj) const
+void CollisionEngine1::find_and_add_static_collisions(std::vector<CEng1Collision> *add_to,
+                                                      const CEng1Obj &ceng_obj) const
 {
-    //Only look for collisions to the right! Break ties by x.
-    const auto &aabb = ceng_obj.polygon->get_AABB();
-    int x1 = x_to_grid_x(aabb.x1);
-    int x2 = x_to_grid_x(aabb.x2);
-    int y1 = y_to_grid_y(aabb.y1 - max_AABB_h);
-    int y2 = y_to_grid_y(aabb.y2);
-
-    //to optimize for performance, break this into two cases:
-    //(1) same x grid value
-    for(int y=y1; y<=y2; y++) {
-        for(const auto &other: grid.get_const_ref(x1, y)) {
-            auto other_AABB = other.polygon->get_AABB();
-
-            //only consider other objects with AABBs to the right, breaking ties by index
-            if(aabb.x1 < other_AABB.x1)
-                continue;
-            if(aabb.x1 == other_AABB.x1 && ceng_obj.idx <= other.idx)
-                continue;
-
-            if(ceng_obj.idx != other.idx &&
-               collision_could_matter(*(*map_objs)[ceng_obj.idx], *(*map_objs)[other.idx]))
-            {
-                if(ceng_obj.polygon->has_collision(*other.polygon)) {
-                    CEng1Collision collision;
-                    collision.idx1 = ceng_obj.idx;
-                    collision.idx2 = other.idx;
-                    add_to->push_back(collision);
-                }
-            }
-        }
-    }
-
-    //(2) higher x grid value
-    for(int x=x1+1; x<=x2; x++) {
-        for(int y=y1; y<=y2; y++) {
-            for(const auto &other: grid.get_const_ref(x, y)) {
-                //filter out a potential collision if:
-                //-the .idx (owner) is the same
-                //-the AABBs don't overlap
-                //-the collision wouldn't matter anyway
-
-                //note that we assume the grid cells are ordered, so we can break
-                //and move on to the next cell if our idx isn't greater than the other's idx
-                if(ceng_obj.idx != other.idx &&
-                   collision_could_matter(*(*map_objs)[ceng_obj.idx], *(*map_objs)[other.idx]))
-                {
-                    if(ceng_obj.polygon->has_collision(*other.polygon)) {
-                        CEng1Collision collision;
-                        collision.idx1 = ceng_obj.idx;
-                        collision.idx2 = other.idx;
-                        add_to->push_back(collision);
-                    }
-                }
-            }
-        }
-    }
+    CEng1NarrowphaseBatch batch;
+    for_each_static_overlap(ceng_obj, [this, &ceng_obj, add_to, &batch](const CEng1Obj &other)
+        {
+            if(ceng_obj.filter.needs_custom_check(other.filter) && !custom_check(ceng_obj, other))
+                return;
+            if(batch.full())
+                batch.flush(add_to);
+            batch.add(&ceng_obj, &other);
+        });
+    batch.flush(add_to);
 }
 bool CollisionEngine1::des_cur_has_collision(int idx1, int idx2) const
 {
@@ -192,27 +176,117 @@ bool CollisionEngine1::des_cur_has_collision(int idx1, int idx2) const
     return collision;
 }
 CollisionEngine1::CollisionEngine1(std::shared_ptr<ThreadPool> thread_pool_):
-    thread_pool(std::move(thread_pool_))
+    thread_pool(std::move(thread_pool_)),
+    ceng_data(nullptr),
+    broadphase(std::make_unique<CEng1GridBroadphase>(CEng1GridBroadphase::GridMode::Persistent)),
+    num_objs(0),
+    static_grid_needs_rebuild(true),
+    max_static_idx(-1)
 {
 
 }
 void CollisionEngine1::reset()
 {
-    grid.reset();
+    broadphase->reset();
+    num_objs = 0;
+    static_grid.reset();
+    static_grid_needs_rebuild = true;
+    max_static_idx = -1;
+    contact_table.clear();
+}
+void CollisionEngine1::set_broadphase(std::unique_ptr<CEng1Broadphase> broadphase_)
+{
+    broadphase = std::move(broadphase_);
+    broadphase->process_added_objs(num_objs);
+    //so the new broadphase gets the level bounds
+    static_grid_needs_rebuild = true;
 }
 void CollisionEngine1::set_ceng_data(std::vector<CEng1Data> *data)
 {
     ceng_data = data;
 }
-void CollisionEngine1::set2(const std::vector<std::shared_ptr<map_obj::MapObject>> *map_objs_,
-                std::function<bool(const MapObject&, const MapObject&)> collision_could_matter_)
+void CollisionEngine1::process_added_objs()
+{
+    size_t first_new_idx = num_objs;
+    num_objs = ceng_data->size();
+    broadphase->process_added_objs(num_objs);
+
+    //new dynamic objects are put in the broadphase by the next find_collisions() call, but
+    //the static grid is immutable
+    for(size_t i=first_new_idx; i<ceng_data->size(); i++) {
+        if((*ceng_data)[i].is_static())
+            static_grid_needs_rebuild = true;
+    }
+}
+void CollisionEngine1::process_deleted_objs(const std::vector<int> &deleted_idx,
+                                            const std::vector<CEng1IdxMove> &moves)
+{
+    if(deleted_idx.empty())
+        return;
+
+    k_expects(std::is_sorted(deleted_idx.begin(), deleted_idx.end()));
+    k_expects(deleted_idx.back() < num_objs);
+
+    int new_size = num_objs - deleted_idx.size();
+    if(deleted_idx[0] <= max_static_idx) {
+        bool static_obj_deleted = false;
+        for(int idx: deleted_idx)
+            static_obj_deleted |= (*ceng_data)[idx].is_static();
+
+        if(static_obj_deleted)
+            static_grid_needs_rebuild = true;
+        else if(max_static_idx >= new_size) {
+            //static objects past new_size are moved into the holes
+            moved_to.assign(num_objs - new_size, -1);
+            for(auto move: moves)
+                moved_to[move.from - new_size] = move.to;
+            static_grid.update_idx([this, new_size](int idx) -> int
+                {
+                    return idx < new_size? idx: moved_to[idx - new_size];
+                });
+            max_static_idx = new_size - 1;
+        }
+    }
+
+    num_objs = new_size;
+    broadphase->process_deleted_objs(deleted_idx, moves);
+}
+void CollisionEngine1::set2(const std::vector<map_obj::MapObject*> *map_objs_)
 {
     map_objs = map_objs_;
-    collision_could_matter = std::move(collision_could_matter_);
-    grid.reset();
 
     k_expects(map_objs->size() == ceng_data->size());
 }
+void CollisionEngine1::rebuild_static_grid()
+{
+    std::vector<CEng1Obj> static_objs;
+    max_static_idx = -1;
+    for(size_t i=0; i<ceng_data->size(); i++) {
+        if((*ceng_data)[i].is_static()) {
+            auto filter = (*ceng_data)[i].get_collision_filter();
+            (*ceng_data)[i].for_each_cur([&static_objs, i, filter](const Polygon *polygon, int shape_id)
+                                         {
+                                             static_objs.emplace_back(polygon, i, shape_id, filter);
+                                         });
+            max_static_idx = i;
+        }
+    }
+
+    CEng1AABBStore static_aabbs;
+    static_aabbs.reserve(static_objs.size());
+    for(const auto &obj: static_objs)
+        static_aabbs.push_back(obj.polygon->get_AABB(), obj.idx);
+    static_geometry.fit_to(static_aabbs);
+
+    std::vector<int> cells;
+    cells.reserve(static_objs.size());
+    for(size_t i=0; i<static_objs.size(); i++)
+        cells.push_back(static_geometry.get_grid_cell(static_aabbs.get_AABB(i)));
+    static_grid.build(static_objs, static_aabbs, cells);
+    broadphase->set_level_bounds(static_geometry.global_AABB);
+
+    static_grid_needs_rebuild = false;
+}
 std::vector<CEng1Collision> CollisionEngine1::find_collisions()
 {
     //step 1
@@ -220,13 +294,17 @@ std::vector<CEng1Collision> CollisionEngine1::find_collisions()
 
     //~50us on Test2(40, 40)
     for(size_t i=0; i<ceng_data->size(); i++) {
-        auto add_active_obj = [this, i](const Polygon *polygon, int shape_idx) -> void
+        auto filter = (*ceng_data)[i].get_collision_filter();
+        auto add_active_obj = [this, i, filter](const Polygon *polygon, int shape_idx) -> void
                             {
-                                active_objs.emplace_back(polygon, i, shape_idx);
+                                active_objs.emplace_back(polygon, i, shape_idx, filter);
                             };
 
         auto move_intent = (*ceng_data)[i].get_move_intent();
-        if(move_intent == MoveIntent::StayAtCurrentPos)
+        if((*ceng_data)[i].is_static()) {
+            //static objects are in the static grid
+            k_assert(move_intent == MoveIntent::StayAtCurrentPos);
+        } else if(move_intent == MoveIntent::StayAtCurrentPos)
             (*ceng_data)[i].for_each_cur(add_active_obj);
         else if(move_intent == MoveIntent::GoToDesiredPos)
             (*ceng_data)[i].for_each_des(add_active_obj);
@@ -238,137 +316,42 @@ std::vector<CEng1Collision> CollisionEngine1::find_collisions()
         }
     }
 
-    //step 2
-    #if 0 //#ifdef __AVX2__
-    //the spec for gather doesn't require any alignment, so I'll comment out this assert...
-    //hopefully alignment isn't implicitly required
-    //k_assert((uintptr_t)active_objs.data() % 8 == 0);
-    auto active_objs_base_ptr = (long long int*)active_objs.data();
-    auto mm_vec_iterator = sizeof(CEng1Obj) * _mm256_set_epi64x(3, 2, 1, 0);
-
-    auto mm_max_dimensions = _mm256_set1_ps(0);
-    auto mm_global_aabb_min = _mm256_set1_ps( std::numeric_limits<float>::max());
-    auto mm_global_aabb_max = _mm256_set1_ps(-std::numeric_limits<float>::max());
-
-    auto last_avx_idx = 4 * (active_objs.size() / 4);
-    //we grid things based on their top left corner, so calculate the global
-    //AABB based on top left corners only.
-    for(size_t i=0; i<last_avx_idx; i+=4) {
-        static_assert(offsetof(CEng1Obj, polygon) == 0);
-        static_assert(Polygon::offset_of_aabb() == 0);
-
-        static_assert(offsetof(AABB, x1) == 0);
-        static_assert(offsetof(AABB, y1) == 4);
-        static_assert(offsetof(AABB, x2) == 8);
-        static_assert(offsetof(AABB, y2) == 12);
-
-        static_assert(std::is_same_v<decltype(AABB::x1), float>);
-        static_assert(std::is_same_v<decltype(AABB::y1), float>);
-        static_assert(std::is_same_v<decltype(AABB::x2), float>);
-        static_assert(std::is_same_v<decltype(AABB::y2), float>);
-
-        //only holds for 64 bit compilers, but it shouldn't be hard to adapt this to 32-bit compilers in the future
-        static_assert(sizeof(CEng1Obj::polygon) == 8);
-
-        auto mm_x1y1_addr = _mm256_i64gather_epi64(active_objs_base_ptr, mm_vec_iterator, 1);
-        auto mm_x2y2_addr = 8 + mm_x1y1_addr;
-
-        auto mm_x1y1_epi64 = _mm256_i64gather_epi64(nullptr, mm_x1y1_addr, 1);
-        auto mm_x2y2_epi64 = _mm256_i64gather_epi64(nullptr, mm_x2y2_addr, 1);
-
-        auto mm_x1y1 = *reinterpret_cast<__m256*>(&mm_x1y1_epi64);
-        auto mm_x2y2 = *reinterpret_cast<__m256*>(&mm_x2y2_epi64);
-
-        mm_vec_iterator += sizeof(CEng1Obj) * 4;
-
-        mm_global_aabb_min = _mm256_min_ps(mm_global_aabb_min, mm_x1y1);
-        mm_global_aabb_max = _mm256_max_ps(mm_global_aabb_max, mm_x1y1);
-        mm_max_dimensions = _mm256_max_ps(mm_max_dimensions, mm_x2y2 - mm_x1y1);
-    }
-    std::array<float, 8> mm_vals;
-
-    _mm256_storeu_ps(mm_vals.data(), mm_max_dimensions);
-    max_AABB_w = std::max(mm_vals[0], std::max(mm_vals[2], std::max(mm_vals[4], mm_vals[6])));
-    max_AABB_h = std::max(mm_vals[1], std::max(mm_vals[3], std::max(mm_vals[5], mm_vals[7])));
-
-    _mm256_storeu_ps(mm_vals.data(), mm_global_aabb_min);
-    global_AABB.x1 = std::min(mm_vals[0], std::min(mm_vals[2], std::min(mm_vals[4], mm_vals[6])));
-    global_AABB.y1 = std::min(mm_vals[1], std::min(mm_vals[3], std::min(mm_vals[5], mm_vals[7])));
-
-    _mm256_storeu_ps(mm_vals.data(), mm_global_aabb_max);
-    global_AABB.x2 = std::max(mm_vals[0], std::max(mm_vals[2], std::max(mm_vals[4], mm_vals[6])));
-    global_AABB.y2 = std::max(mm_vals[1], std::max(mm_vals[3], std::max(mm_vals[5], mm_vals[7])));
-
-    for(auto i=last_avx_idx; i<active_objs.size(); i++) {
-        const auto &aabb = active_objs[i].polygon->get_AABB();
-
-        max_AABB_w = std::max(max_AABB_w, aabb.x2 - aabb.x1);
-        max_AABB_h = std::max(max_AABB_h, aabb.y2 - aabb.y1);
-
-        global_AABB.x1 = std::min(global_AABB.x1, aabb.x1);
-        global_AABB.y1 = std::min(global_AABB.y1, aabb.y1);
-        global_AABB.x2 = std::max(global_AABB.x2, aabb.x1);
-        global_AABB.y2 = std::max(global_AABB.y2, aabb.y1);
-    }
-    #else
-    //this until processing the active objects takes ~80us on Test2(40, 40)
-    max_AABB_w = 0.0f;
-    max_AABB_h = 0.0f;
-
-    //we grid things based on their top left corner, so calculate the global
-    //AABB based on top left corners only.
-    global_AABB = AABB::make_maxbad_AABB();
-    for(const auto &obj: active_objs) {
-        const auto &aabb = obj.polygon->get_AABB();
-
-        max_AABB_w = std::max(max_AABB_w, aabb.x2 - aabb.x1);
-        max_AABB_h = std::max(max_AABB_h, aabb.y2 - aabb.y1);
-
-        global_AABB.x1 = std::min(global_AABB.x1, aabb.x1);
-        global_AABB.x2 = std::max(global_AABB.x2, aabb.x1);
-        global_AABB.y1 = std::min(global_AABB.y1, aabb.y1);
-        global_AABB.y2 = std::max(global_AABB.y2, aabb.y1);
-    }
-    #endif
-
-    grid_rect_w = (global_AABB.x2 - global_AABB.x1) / GRID_LEN;
-    grid_rect_h = (global_AABB.y2 - global_AABB.y1) / GRID_LEN;
-
-    //step 3
-    //~100us on Test2(40, 40)
-    for(const auto &obj: active_objs) {
-        const auto &aabb = obj.polygon->get_AABB();
-        auto x = x_to_grid_x(aabb.x1);
-        auto y = y_to_grid_y(aabb.y1);
-        grid.get_ref(x, y).push_back(obj);
-    }
+    //steps 2 and 3
+    if(static_grid_needs_rebuild)
+        rebuild_static_grid();
+    broadphase->set_objs(active_objs);
 
     //step 4
     size_t num_threads = 1 + thread_pool->size();
 
     std::vector<std::vector<CEng1Collision>> collisions(num_threads);
-    std::vector<std::function<void()>> tasks(num_threads);
-    std::vector<std::future<void>> is_done(num_threads);
+    pairs.resize(num_threads);
 
-    for(size_t i=0; i<num_threads; i++) {
+    //the multithreaded version ~160us on Test2(40, 40)
+    thread_pool->parallel_for(0, num_threads, 1, [num_threads, this, &collisions](int i)
+    {
         size_t idx1 = active_objs.size() * i / (double)num_threads;
         size_t idx2 = active_objs.size() * (i+1) / (double)num_threads;
-        tasks[i] = [num_threads, i, idx1, idx2, this, &collisions]
-                    {
-                        for(size_t j=idx1; j<idx2; j++)
-                            find_and_add_collisions_gt(&collisions[i], active_objs[j]);
-                    };
-    }
-    //the multithreaded version ~160us on Test2(40, 40)
-    for(size_t i=1; i<tasks.size(); i++)
-        is_done[i] = thread_pool->add_task(tasks[i]);
-    tasks[0]();
 
-    for(size_t i=1; i<collisions.size(); i++)
-        is_done[i].get();
+        pairs[i].clear();
+        broadphase->find_pairs(i, num_threads, &pairs[i]);
+        find_and_add_collisions(&collisions[i], pairs[i]);
+
+        for(size_t j=idx1; j<idx2; j++)
+            find_and_add_static_collisions(&collisions[i], active_objs[j]);
+    });
+
     for(size_t i=1; i<collisions.size(); i++)
         collisions[0].insert(collisions[0].end(), collisions[i].begin(), collisions[i].end());
 
+    //which object of a pair finds the collision (and the order they're found in) depends
+    //on the broadphase, which we don't want to affect how collisions are resolved
+    for(auto &collision: collisions[0]) {
+        if(collision.idx1 > collision.idx2)
+            collision.swap();
+    }
+    std::sort(collisions[0].begin(), collisions[0].end(), CEng1Collision::cmp_idx);
+
     return collisions[0];
 
     /*
@@ -381,31 +364,27 @@ std::vector<CEng1Collision> CollisionEngine1::find_collisions()
     return collisions;
     */
 }
-void CollisionEngine1::update_intent_after_collision(int idx,
-                                                     MoveIntent prev_intent,
-                                                     int other_idx,
-                                                     MoveIntent other_prev_intent,
-                                                     std::vector<CEng1Collision> *add_to)
+CEng1BroadphaseUpdate CollisionEngine1::update_intent_after_collision(int idx,
+                                                                     MoveIntent prev_intent,
+                                                                     int other_idx,
+                                                                     MoveIntent other_prev_intent)
 {
     //if the intent didn't change, do nothing
     auto new_intent = (*ceng_data)[idx].get_move_intent();
     k_expects(new_intent != MoveIntent::NotSet);
     if(new_intent == prev_intent)
-        return;
+        return CEng1BroadphaseUpdate::None;
+    //static objects must always stay at their current position
+    k_expects(!(*ceng_data)[idx].is_static());
 
     if(new_intent == MoveIntent::StayAtCurrentPos) {
-        if(prev_intent == MoveIntent::GoToDesiredPos)
-            remove_des_from_grid(idx);
-        else
+        if(prev_intent != MoveIntent::GoToDesiredPos)
             k_assert(false);
-        add_cur_to_grid(idx, add_to);
+        return CEng1BroadphaseUpdate::RemoveAndAddCur;
     } else if(new_intent == MoveIntent::RemoveShapes) {
-        if(prev_intent == MoveIntent::GoToDesiredPos)
-            remove_des_from_grid(idx);
-        else if(prev_intent == MoveIntent::StayAtCurrentPos)
-            remove_cur_from_grid(idx);
-        else
+        if(prev_intent != MoveIntent::GoToDesiredPos && prev_intent != MoveIntent::StayAtCurrentPos)
             k_assert(false);
+        return CEng1BroadphaseUpdate::Remove;
     } else if(new_intent == MoveIntent::GoToDesiredPosIfOtherDoesntCollide) {
         //Note that GoToDesiredPosIfOtherDoesntCollide is a transient state that is
         //immediately resolved after it is declared, i.e. the only place where this state
@@ -421,33 +400,159 @@ void CollisionEngine1::update_intent_after_collision(int idx,
         if(other_prev_intent == MoveIntent::StayAtCurrentPos) {
             //the other shape hasn't moved, so we have to move back
             (*ceng_data)[idx].set_move_intent(MoveIntent::StayAtCurrentPos);
-            remove_des_from_grid(idx);
-            add_cur_to_grid(idx, add_to);
+            return CEng1BroadphaseUpdate::RemoveAndAddCur;
         } else if(other_prev_intent == MoveIntent::GoToDesiredPos) {
             auto other_new_intent = (*ceng_data)[other_idx].get_move_intent();
 
             if(other_new_intent == MoveIntent::StayAtCurrentPos ||
                other_new_intent == MoveIntent::GoToDesiredPosIfOtherDoesntCollide)
             {
-                if(!des_cur_has_collision(idx, other_idx))
+                if(!des_cur_has_collision(idx, other_idx)) {
                     (*ceng_data)[idx].set_move_intent(MoveIntent::GoToDesiredPos);
-                else {
+                    return CEng1BroadphaseUpdate::None;
+                } else {
                     (*ceng_data)[idx].set_move_intent(MoveIntent::StayAtCurrentPos);
-                    remove_des_from_grid(idx);
-                    add_cur_to_grid(idx, add_to);
+                    return CEng1BroadphaseUpdate::RemoveAndAddCur;
                 }
             } else if(other_new_intent == MoveIntent::GoToDesiredPos) {
                 (*ceng_data)[idx].set_move_intent(MoveIntent::StayAtCurrentPos);
-                remove_des_from_grid(idx);
-                add_cur_to_grid(idx, add_to);
+                return CEng1BroadphaseUpdate::RemoveAndAddCur;
             } else if(other_new_intent == MoveIntent::RemoveShapes) {
                 (*ceng_data)[idx].set_move_intent(MoveIntent::GoToDesiredPos);
+                return CEng1BroadphaseUpdate::None;
             } else
                 k_assert(false);
         } else //shouldn't be able to happen
             k_assert(false);
     } else //we received a bogus move intent or an illegal change (e.g. prev intent=cur, new intent=des)
         k_assert(false);
+
+    return CEng1BroadphaseUpdate::None;
+}
+void CollisionEngine1::update_broadphase(int idx, CEng1BroadphaseUpdate update,
+                                         std::vector<CEng1Collision> *add_to)
+{
+    if(update == CEng1BroadphaseUpdate::Remove)
+        broadphase->remove(idx);
+    else if(update == CEng1BroadphaseUpdate::RemoveAndAddCur) {
+        broadphase->remove(idx);
+        add_cur_to_grid(idx, add_to);
+    }
+}
+///the time (0 to 1) at which a box that's moved by d first touches other, assuming it does
+static float get_AABB_entry_time(const AABB &moving, _MapVec<float> d, const AABB &other)
+{
+    float time = 0;
+    if(d.x > 0)
+        time = std::max(time, (other.x1 - moving.x2) / d.x);
+    else if(d.x < 0)
+        time = std::max(time, (other.x2 - moving.x1) / d.x);
+    if(d.y > 0)
+        time = std::max(time, (other.y1 - moving.y2) / d.y);
+    else if(d.y < 0)
+        time = std::max(time, (other.y2 - moving.y1) / d.y);
+    return std::min(time, 1.0f);
+}
+void CollisionEngine1::find_shape_overlaps_impl(const std::vector<const Polygon*> &shapes,
+                                                const std::vector<_MapVec<float>> *displacements,
+                                                CEng1CollisionFilter filter,
+                                                std::vector<CEng1ShapeHit> *hits)
+{
+    k_expects(!(filter.layer & CEng1CollisionFilter::CUSTOM_CHECK));
+    k_expects(displacements == nullptr || displacements->size() == shapes.size());
+
+    hits->clear();
+    if(shapes.empty())
+        return;
+    if(static_grid_needs_rebuild)
+        rebuild_static_grid();
+
+    int num_threads = 1 + thread_pool->size();
+    pairs.resize(std::max<size_t>(pairs.size(), num_threads));
+    shape_hits_lt.resize(num_threads);
+    swept_shapes_lt.resize(num_threads);
+
+    thread_pool->parallel_for(0, num_threads, 1, [this, num_threads, &shapes, displacements, filter](int t)
+    {
+        size_t shape_idx1 = shapes.size() * (uint64_t)t / num_threads;
+        size_t shape_idx2 = shapes.size() * (uint64_t)(t+1) / num_threads;
+        auto &pairs_t = pairs[t];
+        auto &hits_t = shape_hits_lt[t];
+        auto &swept_t = swept_shapes_lt[t];
+
+        for(size_t i=shape_idx1; i<shape_idx2; i++) {
+            const Polygon *shape = shapes[i];
+            _MapVec<float> d(0, 0);
+            if(displacements != nullptr) {
+                d = (*displacements)[i];
+                auto swept_n = shape->get_num_vertices() + 2;
+                if(swept_t == nullptr || swept_t->get_num_vertices() != swept_n)
+                    swept_t = Polygon::make_with_num_sides(swept_n);
+                //if there's nothing to sweep, the shape itself is fine
+                if(swept_t->remake_as_swept(*shape, d))
+                    shape = swept_t.get();
+            }
+            const auto &start_aabb = shapes[i]->get_AABB();
+            auto add_hit = [&hits_t, &start_aabb, displacements, d, i](const CEng1Obj &other)
+            {
+                float time = displacements == nullptr? 0:
+                             get_AABB_entry_time(start_aabb, d, other.polygon->get_AABB());
+                hits_t.push_back(CEng1ShapeHit{(int)i, other.idx, time});
+            };
+
+            //-1 isn't the owner of anything, so nothing is excluded for having the same owner
+            CEng1Obj obj(shape, -1, 0, filter);
+            size_t first_hit = hits_t.size();
+
+            pairs_t.clear();
+            broadphase->find_overlaps(obj, &pairs_t);
+            for(const auto &pair: pairs_t) {
+                if(obj.polygon->has_overlap(*pair.b->polygon))
+                    add_hit(*pair.b);
+            }
+            for_each_static_overlap(obj, [&obj, &add_hit](const CEng1Obj &other)
+                {
+                    if(obj.polygon->has_overlap(*other.polygon))
+                        add_hit(other);
+                });
+
+            //objects with several shapes can be hit more than once; keep the earliest hit
+            std::sort(hits_t.begin() + first_hit, hits_t.end(), [](const CEng1ShapeHit &a,
+                                                                  const CEng1ShapeHit &b) -> bool
+                {
+                    if(a.idx != b.idx)
+                        return a.idx < b.idx;
+                    return a.time < b.time;
+                });
+            hits_t.erase(std::unique(hits_t.begin() + first_hit, hits_t.end(),
+                                     [](const CEng1ShapeHit &a, const CEng1ShapeHit &b) -> bool
+                                     {
+                                         return a.idx == b.idx;
+                                     }),
+                         hits_t.end());
+            if(displacements != nullptr)
+                std::sort(hits_t.begin() + first_hit, hits_t.end(), CEng1ShapeHit::cmp_time);
+        }
+    });
+
+    //the parts are in order, so this keeps hits sorted
+    for(auto &hits_t: shape_hits_lt) {
+        hits->insert(hits->end(), hits_t.begin(), hits_t.end());
+        hits_t.clear();
+    }
+}
+void CollisionEngine1::find_shape_overlaps(const std::vector<const Polygon*> &shapes,
+                                           CEng1CollisionFilter filter,
+                                           std::vector<CEng1ShapeHit> *hits)
+{
+    find_shape_overlaps_impl(shapes, nullptr, filter, hits);
+}
+void CollisionEngine1::find_swept_shape_overlaps(const std::vector<const Polygon*> &shapes,
+                                                 const std::vector<_MapVec<float>> &displacements,
+                                                 CEng1CollisionFilter filter,
+                                                 std::vector<CEng1ShapeHit> *hits)
+{
+    find_shape_overlaps_impl(shapes, &displacements, filter, hits);
 }
 
 }
@@ -1,13 +1,15 @@
 #pragma once
 
 #include "geo2/ceng1_collision.h"
+#include "geo2/ceng1_contact_table.h"
 #include "geo2/ceng1_data.h"
+#include "geo2/ceng1_polygon_arena.h"
+#include "geo2/ceng1_broadphase.h"
+#include "geo2/ceng1_grid_broadphase.h"
 #include "geo2/map_obj/map_object.h"
 #include "geo2/geometry.h"
 
-#include "kx/fixed_size_array.h"
-
-#include "kx/kx_span.h"
+#include <functional>
 #include <type_traits>
 #include <cstdint>
 #include <memory>
@@ -16,24 +18,6 @@
 
 namespace geo2 {
 
-struct CEng1Obj final
-{
-    const Polygon *polygon;
-    int idx; //index of owner
-    uint16_t shape_id;
-
-    CEng1Obj(const Polygon *polygon_, int idx_, uint16_t shape_id_):
-        polygon(polygon_),
-        idx(idx_),
-        shape_id(shape_id_)
-    {}
-
-    static bool cmp_idx(const CEng1Obj &a, const CEng1Obj &b)
-    {
-        return a.idx < b.idx;
-    }
-};
-
 /** The collision engine is, unsurprisingly, the bottleneck. An issue that arose was
  *  how to deal with Polygon ownership. The simplest solution is to use shared_ptr,
  *  in which case a MapObject and a CEng1Obj can both own a Polygon, but copying
@@ -44,109 +28,112 @@ struct CEng1Obj final
 
 class CollisionEngine1
 {
-    constexpr static int GRID_LEN = 128; //power of 2 is faster cuz mult turns into bitshift
-
-    //fastish spatial partition grid
-    template<class T> class Grid
-    {
-        std::array<std::vector<T>, GRID_LEN * GRID_LEN> vals;
-    public:
-        void reset()
-        {
-            for(auto &cell: vals)
-                cell.clear();
-        }
-        inline std::vector<T>& get_ref(int a, int b)
-        {
-            return vals[a*GRID_LEN + b];
-        }
-        inline const std::vector<T>& get_const_ref(int a, int b) const
-        {
-            return vals[a*GRID_LEN + b];
-        }
-        inline void remove_one_with_idx(int x, int y, int idx)
-        {
-            auto &grid_xy = get_ref(x, y);
-            for(size_t i=0; i<grid_xy.size(); i++) {
-                if(grid_xy[i].idx == idx) {
-                    grid_xy[i] = grid_xy.back();
-                    grid_xy.pop_back();
-                    return;
-                }
-            }
-            //no matches found!
-            k_assert(false);
-        }
-    };
-
-    /*
-    template<class T> class Grid
-    {
-        kx::FixedSizeArray<T> vals;
-        std::array<int, GRID_LEN*GRID_LEN> offset;
-        std::array<int, GRID_LEN*GRID_LEN> cur_size;
-    public:
-        Grid()
-        {}
-        void init_with_max_sizes(kx::kx_span<int> max_sizes)
-        {
-            std::fill(std::begin(cur_size), std::end(cur_size), 0);
-            offset[0] = 0;
-            for(int i=1; i<GRID_LEN*GRID_LEN; i++)
-                offset[i] = offset[i-1] + max_sizes[i-1];
-            vals = decltype(vals)(max_sizes[GRID_LEN*GRID_LEN-1] + offset[GRID_LEN*GRID_LEN-1]);
-        }
-        inline std::vector<T>& get_ref(int a, int b)
-        {
-            return vals[a*GRID_LEN + b];
-        }
-    }
-    */
-
+    //active dynamic objects; static objects are never active, i.e. they never look for collisions
     std::vector<CEng1Obj> active_objs;
 
     std::shared_ptr<class ThreadPool> thread_pool;
 
-    const std::vector<std::shared_ptr<map_obj::MapObject>> *map_objs;
-    std::function<bool(const map_obj::MapObject&, const map_obj::MapObject&)> collision_could_matter;
+    const std::vector<map_obj::MapObject*> *map_objs;
 
     //afaik, the only way we modify ceng_data is calling set_move_intent in update_intent_after_collision
     std::vector<CEng1Data> *ceng_data;
-    Grid<CEng1Obj> grid;
 
-    AABB global_AABB;
-    float grid_rect_w;
-    float grid_rect_h;
-    float max_AABB_w;
-    float max_AABB_h;
+    //dynamic objects only
+    std::unique_ptr<CEng1Broadphase> broadphase;
+    int num_objs; //number of objects the broadphase knows about
+
+    CEng1PolygonArena polygon_arena;
+    CEng1ContactTable contact_table;
+
+    //static objects only; static objects are only ever queried by dynamic objects, so
+    //we never even consider collisions between two static objects
+    CEng1GridBroadphase::StaticGrid<CEng1Obj> static_grid;
+    CEng1GridBroadphase::GridGeometry static_geometry;
+    bool static_grid_needs_rebuild;
+    int max_static_idx; //no static object has a bigger idx
 
-    int x_to_grid_x(float x) const;
-    int y_to_grid_y(float y) const;
-    void remove_cur_from_grid(int idx);
-    void remove_des_from_grid(int idx);
+    //these persist across calls to save memory allocations
+    std::vector<int> moved_to;
+    std::vector<std::vector<CEng1ObjPair>> pairs;
+    std::vector<std::vector<CEng1ShapeHit>> shape_hits_lt;
+    std::vector<std::unique_ptr<Polygon>> swept_shapes_lt;
+
+    void rebuild_static_grid();
     void add_cur_to_grid(int idx, std::vector<CEng1Collision> *collisions);
     void add_des_to_grid(int idx, std::vector<CEng1Collision> *collisions);
-    void add_obj_to_grid(std::vector<CEng1Obj> &obj_vec,
-                         int idx,
-                         std::vector<CEng1Collision> *collisions);
-    void find_and_add_collisions_neq(std::vector<CEng1Collision> *add_to,
-                                     const CEng1Obj &ceng_obj) const;
-    void find_and_add_collisions_gt(std::vector<CEng1Collision> *add_to,
-                                    const CEng1Obj &ceng_obj) const;
+    void add_shape_to_grid(const CEng1Obj &obj, std::vector<CEng1Collision> *collisions);
+    void find_and_add_collisions(std::vector<CEng1Collision> *add_to,
+                                 const std::vector<CEng1ObjPair> &candidates) const;
+    ///the slow path of CEng1CollisionFilter; calls MapObject::collision_could_matter()
+    bool custom_check(const CEng1Obj &a, const CEng1Obj &b) const;
+    ///calls func(other) for every static object whose AABB overlaps ceng_obj's and whose
+    ///filter could matter
+    template<class Func> void for_each_static_overlap(const CEng1Obj &ceng_obj, const Func &func) const;
+    void find_and_add_static_collisions(std::vector<CEng1Collision> *add_to,
+                                        const CEng1Obj &ceng_obj) const;
     bool des_cur_has_collision(int idx1, int idx2) const;
+    ///displacements is null if the shapes don't move
+    void find_shape_overlaps_impl(const std::vector<const Polygon*> &shapes,
+                                  const std::vector<_MapVec<float>> *displacements,
+                                  CEng1CollisionFilter filter,
+                                  std::vector<CEng1ShapeHit> *hits);
 public:
+    ///uses a CEng1GridBroadphase in Persistent mode by default
     CollisionEngine1(std::shared_ptr<ThreadPool> thread_pool_);
 
+    ///forgets about all objects; call this when starting a new level
     void reset();
+    ///the shapes in ceng_data go here, so ceng_data has to be emptied before this is destroyed
+    inline CEng1PolygonArena *get_polygon_arena()
+    {
+        return &polygon_arena;
+    }
+    ///when pairs of objects last touched; the game ages it out every tick
+    inline CEng1ContactTable *get_contact_table()
+    {
+        return &contact_table;
+    }
+    ///can be called at any time (e.g. to pick the best one for a level)
+    void set_broadphase(std::unique_ptr<CEng1Broadphase> broadphase_);
     ///cur_ and des_ must be sorted (for efficiency reasons)
     void set_ceng_data(std::vector<CEng1Data> *data);
-    void set2(const std::vector<std::shared_ptr<map_obj::MapObject>> *map_objs_,
-              std::function<bool(const map_obj::MapObject&,
-                               const map_obj::MapObject&)> collision_could_matter_);
+    ///call this after objects are appended to ceng_data (and init() is called on them)
+    void process_added_objs();
+    ///call this before objects are removed from ceng_data; deleted_idx is sorted and has no
+    ///duplicates, and moves (from get_swap_and_pop_moves()) is how the rest are moved
+    void process_deleted_objs(const std::vector<int> &deleted_idx,
+                              const std::vector<CEng1IdxMove> &moves);
+    void set2(const std::vector<map_obj::MapObject*> *map_objs_);
+    ///collisions are returned with idx1 < idx2, sorted by (idx1, idx2)
     std::vector<CEng1Collision> find_collisions();
-    ///called only after a collision happens
-    void update_intent_after_collision(int idx, MoveIntent prev_intent,
-                                       int other_idx, MoveIntent other_prev_intent,
-                                       std::vector<CEng1Collision> *add_to);
+    /** Called only after a collision happens. This only changes ceng_data[idx] (and reads
+     *  ceng_data[other_idx]), so it can be called for unrelated objects in parallel. The
+     *  returned update has to be passed to update_broadphase() afterwards.
+     */
+    CEng1BroadphaseUpdate update_intent_after_collision(int idx, MoveIntent prev_intent,
+                                                        int other_idx, MoveIntent other_prev_intent);
+    ///not thread safe; collisions found by adding shapes are appended to add_to
+    void update_broadphase(int idx, CEng1BroadphaseUpdate update, std::vector<CEng1Collision> *add_to);
+    /** Finds the objects that overlap each of shapes, which aren't in ceng_data (e.g.
+     *  projectiles, which are simulated in bulk). Call this after collisions are resolved;
+     *  then every object has the shapes it ends the tick with. filter can't have
+     *  CEng1CollisionFilter::CUSTOM_CHECK set because there's no MapObject to ask, and
+     *  objects that want the custom check are treated as if it passed.
+     *  hits is overwritten, sorted by (shape_idx, idx) and has no duplicates.
+     *  A shape that's completely inside an object (or the other way around) counts too,
+     *  even if they aren't convex (see Polygon::has_collision()).
+     */
+    void find_shape_overlaps(const std::vector<const Polygon*> &shapes, CEng1CollisionFilter filter,
+                             std::vector<CEng1ShapeHit> *hits);
+    /** Same as find_shape_overlaps(), but shapes[i] moves by displacements[i], and everything
+     *  it passes over on the way is hit, so small fast shapes can't skip over thin objects
+     *  no matter how long the tick is. The shapes have to be convex.
+     *  hits is sorted by shape_idx and then by the time along the sweep at which the
+     *  shape's AABB first touches the object's, which is exact for axis-aligned walls.
+     */
+    void find_swept_shape_overlaps(const std::vector<const Polygon*> &shapes,
+                                   const std::vector<_MapVec<float>> &displacements,
+                                   CEng1CollisionFilter filter,
+                                   std::vector<CEng1ShapeHit> *hits);
 };
 }
@@ -1,6 +1,7 @@
 #include "geo2/map_obj/floor_type1/test_terrain1.h"
 #include "geo2/game_render_scene_graph.h"
 #include "geo2/game.h"
+#include "geo2/map_obj_type_buckets.h"
 #include "geo2/game_gfx.h"
 #include "geo2/map_obj/map_object.h"
 #include "geo2/collision_engine1.h"
@@ -10,6 +11,7 @@
 #include "geo2/level_gen/test3.h"
 
 #include "geo2/multithread/thread_pool.h"
+#include "geo2/multithread/fork_join_phases.h"
 #include "geo2/timer.h"
 
 #include "kx/gfx/renderer.h"
@@ -19,6 +21,8 @@
 
 #include <SDL2/SDL_scancode.h>
 
+#include <algorithm>
+
 namespace geo2 {
 
 //3600 corresponds to 16x16 tiles on a 1280x720 screen
@@ -26,6 +30,19 @@ namespace geo2 {
 //minimize artifacting around the edges
 constexpr float TILES_PER_SCREEN = 3600;
 constexpr int PREV_MOUSE_X_NOT_SET = -123456;
+//run1 and run3 split map_objs into this many chunks, which the threads take turns taking;
+//this doesn't depend on the number of threads so that the rngs are used the same way
+//everywhere
+constexpr int NUM_TICK_CHUNKS = 64;
+
+//the ids that tick_phases gives the phases, in the order they're added
+enum TickPhase: int {
+    TICK_PHASE_RUN1,
+    TICK_PHASE_COLLISIONS,
+    TICK_PHASE_PROJECTILES,
+    TICK_PHASE_PROJECTILE_HITS,
+    TICK_PHASE_RUN3
+};
 
 void Game::generate_and_start_level(LevelName level_name)
 {
@@ -60,8 +77,16 @@ void Game::generate_and_start_level(LevelName level_name)
     }
 
     prev_mouse_x = PREV_MOUSE_X_NOT_SET;
+    //don't try to catch up on the time it took to generate the level
+    prev_frame_time = kx::Time::NA();
+    unsimulated_time = 0;
 
     map_objs.clear();
+    map_obj_buckets->clear();
+    gfx_only_map_objs.clear();
+    ceng_data.clear();
+    collision_engine->reset();
+    projectiles->clear();
     map_objs_to_add = std::move(level.map_objs);
     map_objs_to_add.push_back(player);
     process_added_map_objs();
@@ -88,6 +113,7 @@ void Game::run_player(double tick_len,
 
     weapon::WeaponRunArgs weapon_args;
     weapon_args.set_map_objs_to_add(&map_objs_to_add);
+    weapon_args.set_projectiles(projectiles.get());
     auto player_pos = player->get_position();
     weapon_args.cursor_pos = cursor_pos;
     weapon_args.tick_len = tick_len;
@@ -120,44 +146,42 @@ void Game::run1(double tick_len)
 
     //multithreaded version takes ~150us
 
-    int num_threads = thread_pool->size() + 1;
-    std::vector<std::future<void>> is_done_futures(num_threads);
-
-    int num_map_objs = map_objs.size();
-
-    map_objs_to_add_lt.resize(num_threads);
-    idx_to_delete_lt.resize(num_threads);
-
-    for(int t=num_threads-1; t>=0; t--) {
-        int idx1 = (num_map_objs * (uint64_t)t) / num_threads;
-        int idx2 = (num_map_objs * (uint64_t)(t+1)) / num_threads;
-        auto task = [this, t, tick_len, idx1, idx2]
-        {
-            map_obj::MapObjRun1Args run1_args;
-            run1_args.tick_len = tick_len;
-            run1_args.set_ceng_data(&ceng_data);
-            run1_args.set_map_objs_to_add(&map_objs_to_add_lt[t]);
-            run1_args.set_rng(&rngs[t]);
-            run1_args.set_idx_to_delete(&idx_to_delete_lt[t]);
-            run1_args.cur_level_time = cur_level_time;
-
-            for(int i=idx1; i<idx2; i++) {
-                run1_args.set_index(i);
-                map_objs[i]->run1_mt(run1_args);
-            }
-        };
-
-        if(t == 0)
-            task();
-        else
-            is_done_futures[t] = thread_pool->add_task(task);
-    }
-
-    for(int t=1; t<num_threads; t++)
-        is_done_futures[t].get();
-
+    map_objs_to_add_lt.resize(NUM_TICK_CHUNKS);
+    idx_to_delete_lt.resize(NUM_TICK_CHUNKS);
+
+    //objects are run one type at a time, so the calls are statically dispatched
+    using map_obj::OverridesRun1Mt;
+    tick_phases->run_phase(TICK_PHASE_RUN1, map_obj_buckets->count<OverridesRun1Mt>(), NUM_TICK_CHUNKS,
+                           [this, tick_len](int chunk, int begin, int end)
+    {
+        map_obj::MapObjRun1Args run1_args;
+        run1_args.tick_len = tick_len;
+        run1_args.set_ceng_data(&ceng_data);
+        run1_args.set_map_objs_to_add(&map_objs_to_add_lt[chunk]);
+        run1_args.set_rng(&rngs[chunk]);
+        run1_args.set_idx_to_delete(&idx_to_delete_lt[chunk]);
+        run1_args.cur_level_time = cur_level_time;
+
+        map_obj_buckets->for_each_in_range<OverridesRun1Mt>(begin, end,
+            [this, &run1_args](auto tag, const int *first, const int *last)
+            {
+                using T = typename decltype(tag)::type;
+                for(auto it = first; it != last; it++) {
+                    run1_args.set_index(*it);
+                    static_cast<T*>(map_objs[*it])->run1_mt(run1_args);
+                }
+            });
+    });
+
+    merge_local_buffers();
+}
+void Game::merge_local_buffers()
+{
+    //merged in chunk order, so the result doesn't depend on which thread ran which chunk;
+    //the new objects are moved, so their reference counts aren't touched
     for(auto &i: map_objs_to_add_lt) {
-        map_objs_to_add.insert(map_objs_to_add.end(), i.begin(), i.end());
+        map_objs_to_add.insert(map_objs_to_add.end(), std::make_move_iterator(i.begin()),
+                               std::make_move_iterator(i.end()));
         i.clear();
     }
     for(auto &i: idx_to_delete_lt) {
@@ -165,61 +189,156 @@ void Game::run1(double tick_len)
         i.clear();
     }
 }
-void Game::run_collision_engine()
+void Game::prepare_collision_engine()
 {
-    using map_obj::MapObject;
-    auto collision_could_matter = [](const MapObject &a, const MapObject &b) -> bool
-                                    {
-                                        auto a_map_obj = (const MapObject*)&a;
-                                        auto b_map_obj = (const MapObject*)&b;
-                                        return a_map_obj->collision_could_matter(*b_map_obj);
-                                    };
-
-    //all reset/set combined are ~50-100us on Test2(40, 40)
-    collision_engine->reset();
     collision_engine->set_ceng_data(&ceng_data);
-    collision_engine->set2(&map_objs, std::move(collision_could_matter));
+    collision_engine->set2(&map_objs.get_objs());
+}
+std::array<CEng1BroadphaseUpdate, 2> Game::handle_collision(const CEng1Collision &collision,
+                                                            std::vector<int> *idx_to_delete_)
+{
+    auto idx1 = collision.idx1;
+    auto idx2 = collision.idx2;
+
+    map_obj::HandleCollisionArgs args;
+    args.set_idx_to_delete(idx_to_delete_);
+    args.set_ceng_data(&ceng_data);
+    args.set_contact_table(collision_engine->get_contact_table());
+    args.set_collision_info(collision);
+    args.set_this(map_objs[idx2]);
+    args.set_other(map_objs[idx1]);
+    args.cur_level_time = cur_level_time;
+    args.set_index(idx2);
+    args.set_other_idx(idx1);
+    //the order is SWAPPED; A->handle_collision(B) results in
+    //B processing the collision and reporting its new intent
+    auto prev_intent1 = ceng_data[idx1].get_move_intent();
+    auto prev_intent2 = ceng_data[idx2].get_move_intent();
+
+    map_objs[idx1]->handle_collision(map_objs[idx2], args);
+    args.swap();
+    map_objs[idx2]->handle_collision(map_objs[idx1], args);
+
+    //these can't be run in parallel because they might depend on each other,
+    //in particular, if MoveIntent::GoToDesiredPosIfOtherDoesntCollide is used.
+    auto update1 = collision_engine->update_intent_after_collision(idx1, prev_intent1,
+                                                                   idx2, prev_intent2);
+    auto update2 = collision_engine->update_intent_after_collision(idx2, prev_intent2,
+                                                                   idx1, prev_intent1);
+
+    map_objs[idx1]->end_handle_collision_block({});
+    map_objs[idx2]->end_handle_collision_block({});
+
+    return {update1, update2};
+}
+void Game::resolve_collisions_serially(std::vector<CEng1Collision> *collisions, size_t begin, size_t end)
+{
+    for(size_t i=begin; i<end; i++) {
+        //copy the collision, because update_broadphase might reallocate collisions
+        auto collision = (*collisions)[i];
+        auto updates = handle_collision(collision, &idx_to_delete);
+        collision_engine->update_broadphase(collision.idx1, updates[0], collisions);
+        collision_engine->update_broadphase(collision.idx2, updates[1], collisions);
+    }
+}
+void Game::resolve_collisions_in_parallel(std::vector<CEng1Collision> *collisions, size_t begin, size_t end)
+{
+    collision_groups.build(*collisions, begin, end, ceng_data);
+    int num_groups = collision_groups.num_groups();
+    if(num_groups < 2) {
+        resolve_collisions_serially(collisions, begin, end);
+        return;
+    }
 
-    //~500-550us on Test2(40, 40)
-    auto collisions = collision_engine->find_collisions();
+    //split the groups into contiguous chunks with roughly the same number of collisions
+    int num_threads = std::min<int>(thread_pool->size() + 1, num_groups);
+    std::vector<int> chunk_begin(num_threads + 1, num_groups);
+    chunk_begin[0] = 0;
+    size_t num_done = 0;
+    for(int g=0, t=1; g<num_groups && t<num_threads; g++) {
+        num_done += collision_groups.get_group(g).size();
+        if(num_done * num_threads >= (end - begin) * t)
+            chunk_begin[t++] = g + 1;
+    }
+
+    broadphase_updates.resize(end - begin);
+    //don't shrink it; run1 and run3 use the same buffers
+    if((int)idx_to_delete_lt.size() < num_threads)
+        idx_to_delete_lt.resize(num_threads);
+
+    thread_pool->parallel_for(0, num_threads, 1, [this, begin, collisions, &chunk_begin](int t)
+    {
+        for(int g=chunk_begin[t]; g<chunk_begin[t+1]; g++) {
+            for(int i: collision_groups.get_group(g))
+                broadphase_updates[i - begin] = handle_collision((*collisions)[i], &idx_to_delete_lt[t]);
+        }
+    });
+
+    //the broadphase is updated in the same order as if everything was resolved serially, so
+    //new collisions are found in the same order too
+    for(size_t i=begin; i<end; i++) {
+        auto collision = (*collisions)[i];
+        collision_engine->update_broadphase(collision.idx1, broadphase_updates[i - begin][0], collisions);
+        collision_engine->update_broadphase(collision.idx2, broadphase_updates[i - begin][1], collisions);
+    }
+
+    merge_local_buffers();
+}
+void Game::run_collision_engine()
+{
+    //below this, spreading the collisions over threads costs more than it saves
+    constexpr size_t MIN_PARALLEL_COLLISIONS = 64;
 
-    //don't use a range-based loop, because collisions may be modified by
-    //update_intent, which would invalidate iterators to it
-    //~0us on Test2(40, 40)
-    for(size_t i=0; i<collisions.size(); i++) {
-        auto idx1 = collisions[i].idx1;
-        auto idx2 = collisions[i].idx2;
+    prepare_collision_engine();
 
-        map_obj::HandleCollisionArgs args;
-        args.set_idx_to_delete(&idx_to_delete);
+    auto collisions = collision_engine->find_collisions();
+
+    //collisions that are found while resolving others are appended, and they're resolved
+    //in the next round (which is also what a single serial loop over collisions would do)
+    size_t round_begin = 0;
+    while(round_begin < collisions.size()) {
+        size_t round_end = collisions.size();
+        if(round_end - round_begin >= MIN_PARALLEL_COLLISIONS && thread_pool->size() > 0)
+            resolve_collisions_in_parallel(&collisions, round_begin, round_end);
+        else
+            resolve_collisions_serially(&collisions, round_begin, round_end);
+        round_begin = round_end;
+    }
+}
+void Game::run_projectiles(double tick_len)
+{
+    projectiles->prepare_move(tick_len);
+    tick_phases->run_phase(TICK_PHASE_PROJECTILES, projectiles->size(), NUM_TICK_CHUNKS,
+                           [this, tick_len]([[maybe_unused]] int chunk, int idx1, int idx2)
+    {
+        projectiles->move(idx1, idx2, tick_len);
+    });
+
+    tick_phases->run_serial_phase(TICK_PHASE_PROJECTILE_HITS, [this]
+    {
+        collision_engine->find_swept_shape_overlaps(projectiles->get_shapes(),
+                                                    projectiles->get_displacements(),
+                                                    ProjectileSystem::get_collision_filter(),
+                                                    &projectile_hits);
+
+        map_obj::HandleProjectileHitArgs args;
         args.set_ceng_data(&ceng_data);
-        args.set_collision_info(collisions[i]);
-        args.set_this(map_objs[idx2].get());
-        args.set_other(map_objs[idx1].get());
         args.cur_level_time = cur_level_time;
-        args.set_index(idx2);
-        args.set_other_idx(idx1);
-        //the order is SWAPPED; A->handle_collision(B) results in
-        //B processing the collision and reporting its new intent
-        auto prev_intent1 = ceng_data[idx1].get_move_intent();
-        auto prev_intent2 = ceng_data[idx2].get_move_intent();
-
-        map_objs[idx1]->handle_collision(map_objs[idx2].get(), args);
-        args.swap();
-        map_objs[idx2]->handle_collision(map_objs[idx1].get(), args);
-
-        //these can't be run in parallel because they might depend on each other,
-        //in particular, if MoveIntent::GoToDesiredPosIfOtherDoesntCollide is used.
-        collision_engine->update_intent_after_collision(idx1, prev_intent1,
-                                                        idx2, prev_intent2,
-                                                        &collisions);
-        collision_engine->update_intent_after_collision(idx2, prev_intent2,
-                                                        idx1, prev_intent1,
-                                                        &collisions);
-
-        map_objs[idx1]->end_handle_collision_block({});
-        map_objs[idx2]->end_handle_collision_block({});
-    }
+
+        //hits are sorted by projectile and then by when they happen in the tick, so a
+        //projectile is used up by the first object on its path that takes it
+        for(const auto &hit: projectile_hits) {
+            if(!projectiles->is_alive(hit.shape_idx))
+                continue;
+            args.set_index(hit.idx);
+            args.damage = projectiles->get_damage(hit.shape_idx);
+            args.team = projectiles->get_team(hit.shape_idx);
+            if(map_objs[hit.idx]->handle_projectile_hit(args))
+                projectiles->kill(hit.shape_idx);
+        }
+
+        projectiles->remove_dead();
+    });
 }
 void Game::run3(double tick_len)
 {
@@ -237,119 +356,96 @@ void Game::run3(double tick_len)
         map_objs[i]->run3_mt(run3_args);
     }
     */
-    int num_threads = thread_pool->size() + 1;
-    std::vector<std::future<void>> is_done_futures(num_threads);
-
-    int num_map_objs = map_objs.size();
-
-    map_objs_to_add_lt.resize(num_threads);
-    idx_to_delete_lt.resize(num_threads);
-
-    for(int t=num_threads-1; t>=0; t--) {
-        int idx1 = (num_map_objs * (uint64_t)t) / num_threads;
-        int idx2 = (num_map_objs * (uint64_t)(t+1)) / num_threads;
-        auto task = [this, t, tick_len, idx1, idx2]
-        {
-            map_obj::MapObjRun3Args run3_args;
-            run3_args.tick_len = tick_len;
-            run3_args.set_ceng_data(&ceng_data);
-            run3_args.set_map_objs_to_add(&map_objs_to_add_lt[t]);
-            run3_args.set_idx_to_delete(&idx_to_delete_lt[t]);
-            run3_args.cur_level_time = cur_level_time;
-            run3_args.set_rng(&rngs[t]);
-
-            for(int i=idx1; i<idx2; i++) {
-                run3_args.set_index(i);
-                map_objs[i]->run3_mt(run3_args);
-            }
-        };
-
-        if(t == 0)
-            task();
-        else
-            is_done_futures[t] = thread_pool->add_task(task);
-    }
-
-    for(int t=1; t<num_threads; t++)
-        is_done_futures[t].get();
-
-    for(auto &i: map_objs_to_add_lt) {
-        map_objs_to_add.insert(map_objs_to_add.end(), i.begin(), i.end());
-        i.clear();
-    }
-    for(auto &i: idx_to_delete_lt) {
-        idx_to_delete.insert(idx_to_delete.end(), i.begin(), i.end());
-        i.clear();
-    }
+    map_objs_to_add_lt.resize(NUM_TICK_CHUNKS);
+    idx_to_delete_lt.resize(NUM_TICK_CHUNKS);
+
+    using map_obj::OverridesRun3Mt;
+    tick_phases->run_phase(TICK_PHASE_RUN3, map_obj_buckets->count<OverridesRun3Mt>(), NUM_TICK_CHUNKS,
+                           [this, tick_len](int chunk, int begin, int end)
+    {
+        map_obj::MapObjRun3Args run3_args;
+        run3_args.tick_len = tick_len;
+        run3_args.set_ceng_data(&ceng_data);
+        run3_args.set_map_objs_to_add(&map_objs_to_add_lt[chunk]);
+        run3_args.set_idx_to_delete(&idx_to_delete_lt[chunk]);
+        run3_args.cur_level_time = cur_level_time;
+        run3_args.set_rng(&rngs[chunk]);
+
+        map_obj_buckets->for_each_in_range<OverridesRun3Mt>(begin, end,
+            [this, &run3_args](auto tag, const int *first, const int *last)
+            {
+                using T = typename decltype(tag)::type;
+                for(auto it = first; it != last; it++) {
+                    run3_args.set_index(*it);
+                    static_cast<T*>(map_objs[*it])->run3_mt(run3_args);
+                }
+            });
+    });
+
+    merge_local_buffers();
 }
 void Game::process_added_map_objs()
 {
     using namespace map_obj;
 
-    #ifdef __GNUC__
+    for(auto &mobj: map_objs_to_add)
+        mobj->set_render_seq(next_render_seq++, {});
+
     //optimization: if a map object doesn't override any of a certain set of functions,
     //then we can label it noncollidable and purely cosmetic and put it in a separate
-    //vector that will only be used during rendering. This hack is only supported by some
-    //compilers.
+    //vector that will only be used during rendering (see map_obj::is_gfx_only)
     size_t new_size = 0;
     for(size_t i=0; i<map_objs_to_add.size(); i++) {
-        const auto &this_obj = *map_objs_to_add[i];
-        //If we add run2_st and sfx as functions, then we should add those into the condition here too.
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Wpedantic"
-        if((void*)(&MapObject::init) == (void*)(this_obj.*(&MapObject::init)) &&
-           (void*)(&MapObject::run1_mt) == (void*)(this_obj.*(&MapObject::run1_mt)) &&
-           (void*)(&MapObject::run3_mt) == (void*)(this_obj.*(&MapObject::run3_mt)))
-        #pragma GCC diagnostic pop
-        {
+        if(MapObjTypeBuckets::is_gfx_only(*map_objs_to_add[i]))
             gfx_only_map_objs.push_back(std::move(map_objs_to_add[i]));
-        } else {
-            map_objs_to_add[new_size] = map_objs_to_add[i];
+        else {
+            map_objs_to_add[new_size] = std::move(map_objs_to_add[i]);
             new_size++;
         }
     }
     map_objs_to_add.resize(new_size);
-    #endif
 
-    //everything in map_objs_to_add is moved to map_objs
+    //everything in map_objs_to_add is moved to map_objs, which gives it a handle before init()
     ceng_data.resize(map_objs.size() + map_objs_to_add.size());
     MapObjInitArgs args;
     args.set_rng(&rngs[0]);
     size_t ceng_data_idx = map_objs.size();
     for(auto &mobj: map_objs_to_add) {
         args.set_ceng_data(&ceng_data[ceng_data_idx]);
-        mobj->init(args);
+        ceng_data[ceng_data_idx].set_polygon_arena(collision_engine->get_polygon_arena());
+        ceng_data[ceng_data_idx].set_collision_filter(mobj->get_collision_filter());
+        map_obj_buckets->add(ceng_data_idx, MapObjTypeBuckets::get_bucket(*mobj));
+        map_objs.insert(std::move(mobj));
+        map_objs[ceng_data_idx]->init(args);
         ceng_data_idx++;
     }
-    map_objs.insert(map_objs.end(), map_objs_to_add.begin(), map_objs_to_add.end());
     map_objs_to_add.clear();
+    collision_engine->process_added_objs();
 }
 void Game::process_deleted_map_objs()
 {
     //-remove all map objects that want to be removed
-    //-note that we should preserve the order to prevent rendering glitches
-    // (if two things have the same priority, then their order in map_objs
-    // determines which one is rendered first, so should keep all relative
-    // orders, (this is a similar concept to stable sort))
+    //-the last objects are moved into the holes (swap-and-pop), so this only touches the
+    // deleted objects and the ones that take their place; the render order doesn't
+    // depend on the order of map_objs (see next_render_seq)
     if(!idx_to_delete.empty()) {
-        int first_idx = std::numeric_limits<decltype(first_idx)>::max();
-        //note that duplicate indices won't cause bugs (yet), but they're messy
-        //so they're not recommended
-        for(const auto &idx: idx_to_delete) {
-            k_assert(idx < (int)map_objs.size());
-            map_objs[idx] = nullptr;
-            first_idx = std::min(first_idx, idx);
-        }
-        size_t after_idx = first_idx;
-        for(size_t i=first_idx+1; i<map_objs.size(); i++) {
-            if(map_objs[i] != nullptr) {
-                ceng_data[after_idx] = std::move(ceng_data[i]);
-                map_objs[after_idx] = std::move(map_objs[i]);
-                after_idx++;
-            }
-        }
-        ceng_data.resize(after_idx);
-        map_objs.resize(after_idx);
+        //note that duplicate indices won't cause bugs, but they're messy so they're
+        //not recommended
+        std::sort(idx_to_delete.begin(), idx_to_delete.end());
+        idx_to_delete.erase(std::unique(idx_to_delete.begin(), idx_to_delete.end()), idx_to_delete.end());
+        k_assert(idx_to_delete.back() < (int)map_objs.size());
+
+        idx_moves.clear();
+        get_swap_and_pop_moves(idx_to_delete, map_objs.size(), &idx_moves);
+        collision_engine->process_deleted_objs(idx_to_delete, idx_moves);
+
+        for(auto move: idx_moves)
+            ceng_data[move.to] = std::move(ceng_data[move.from]);
+        ceng_data.resize(map_objs.size() - idx_to_delete.size());
+        map_obj_buckets->erase(idx_to_delete, idx_moves);
+        collision_engine->get_contact_table()->remove_objs(idx_to_delete, map_objs);
+        //this is where the deleted objects are destroyed
+        map_objs.erase(idx_to_delete, idx_moves);
         idx_to_delete.clear();
     }
 }
@@ -372,6 +468,8 @@ void Game::advance_one_tick(double tick_len,
      *   they don't interact with the collision engine.
      *  -Run the collision engine and find all collisions. Objects process all collisions,
      *   possibly moving back to their original place.
+     *  -Move the projectiles (which aren't MapObjects) and let whatever they passed over
+     *   (at its final position) handle the hits.
      *  -run2_st(); plan to add in the future
      *  -Call run3_mt() on everything. Objects will update their internal positions here.
      *   Objects that tried to move in run1_mt() will likely perform a simple update of
@@ -385,7 +483,9 @@ void Game::advance_one_tick(double tick_len,
     run1(tick_len);
 
     //~400us on Test2(40, 40)
-    run_collision_engine();
+    tick_phases->run_serial_phase(TICK_PHASE_COLLISIONS, [this]{run_collision_engine();});
+
+    run_projectiles(tick_len);
 
     run3(tick_len);
 
@@ -395,12 +495,20 @@ void Game::advance_one_tick(double tick_len,
 }
 //the thread pool size is the number of threads we have - 1 because we should
 //make use of the current thread too to reduce overhead
-Game::Game(kx::Passkey<MasterInstance>):
+Game::Game(kx::Passkey<MasterInstance, GameBenchmark>):
     gfx(new GameGfx({})),
     player(std::make_unique<map_obj::Player_Type1>()),
+    map_obj_buckets(std::make_unique<MapObjTypeBuckets>()),
+    next_render_seq(0),
+    tick_len(1.0 / 1440.0),
+    max_ticks_per_frame(30),
+    prev_frame_time(kx::Time::NA()),
+    unsimulated_time(0),
     thread_pool(std::make_shared<ThreadPool>(std::thread::hardware_concurrency() - 1)),
-    rngs(thread_pool->size() + 1),
-    collision_engine(std::make_unique<CollisionEngine1>(thread_pool))
+    tick_phases(std::make_unique<ForkJoinPhases>(thread_pool)),
+    rngs(NUM_TICK_CHUNKS),
+    collision_engine(std::make_unique<CollisionEngine1>(thread_pool)),
+    projectiles(std::make_unique<ProjectileSystem>())
 {
     /** Note:
      *  In order to make the program deterministic even if it multi-threaded, we have
@@ -412,10 +520,33 @@ Game::Game(kx::Passkey<MasterInstance>):
      *  is empty by the time it wakes up.
      */
 
+    //in the same order as TickPhase
+    tick_phases->add_phase("run1");
+    tick_phases->add_phase("collisions");
+    tick_phases->add_phase("projectiles");
+    tick_phases->add_phase("projectile_hits");
+    tick_phases->add_phase("run3");
+
+    collision_engine->set_ceng_data(&ceng_data);
     generate_and_start_level(LevelName::Test3);
 }
 Game::~Game()
-{}
+{
+    //the shapes are in the collision engine's arena, which is destroyed first
+    ceng_data.clear();
+}
+void Game::set_tick_rate(double ticks_per_sec)
+{
+    k_expects(ticks_per_sec > 0);
+    //keep the same fraction of a tick in the accumulator
+    unsimulated_time *= (1.0 / ticks_per_sec) / tick_len;
+    tick_len = 1.0 / ticks_per_sec;
+}
+void Game::set_max_ticks_per_frame(int max_ticks)
+{
+    k_expects(max_ticks >= 1);
+    max_ticks_per_frame = max_ticks;
+}
 
 inline float lerp(double a, double b, double t)
 {
@@ -426,8 +557,6 @@ std::shared_ptr<kx::gfx::Texture> Game::run(const LibraryPointers &libraries,
                                             GameRenderSceneGraph *render_scene_graph,
                                             int render_w, int render_h)
 {
-    constexpr int TICKS_PER_FRAME = 10;
-
     auto gfx_library = libraries.gfx_library;
 
     //using lerped mouse positions allows for smoother laser beams when rapidly moving the mouse
@@ -440,23 +569,46 @@ std::shared_ptr<kx::gfx::Texture> Game::run(const LibraryPointers &libraries,
 
     float tile_len = std::sqrt(render_w * render_h / TILES_PER_SCREEN);
 
-    for(int i=0; i<TICKS_PER_FRAME; i++) {
-        //~1300us on Test2(40, 40)
-        float simulated_mouse_x = lerp(prev_mouse_x, mouse_x, (i+1)/((double)TICKS_PER_FRAME));
-        float simulated_mouse_y = lerp(prev_mouse_y, mouse_y, (i+1)/((double)TICKS_PER_FRAME));
-
-        auto offset = MapVec(simulated_mouse_x - 0.5f*render_w,
-                             simulated_mouse_y - 0.5f*render_h)
-                             / tile_len;
-
-        advance_one_tick(1.0 / 1440.0,
-                         player->get_position() + offset,
-                         gfx_library->get_mouse_state(),
-                         gfx_library->get_keyboard_state());
+    //the first frame (of a level) simulates one tick
+    auto now = kx::Time::now();
+    if(prev_frame_time == kx::Time::NA())
+        unsimulated_time += tick_len;
+    else
+        unsimulated_time += (now - prev_frame_time).to_double(kx::Time::Length::second);
+    prev_frame_time = now;
+
+    int num_ticks;
+    double ticks_due = std::floor(unsimulated_time / tick_len);
+    if(ticks_due > max_ticks_per_frame) {
+        //drop the whole ticks we can't catch up on, but keep the fraction of a tick, so
+        //tick_interp doesn't jump
+        num_ticks = max_ticks_per_frame;
+        unsimulated_time = num_ticks * tick_len + std::fmod(unsimulated_time, tick_len);
+    } else {
+        num_ticks = ticks_due;
     }
+    unsimulated_time = std::max(unsimulated_time - num_ticks * tick_len, 0.0);
+
+    if(num_ticks > 0) {
+        //the workers are needed several times per tick, so they shouldn't fall asleep in between
+        auto hot_section = tick_phases->keep_hot();
+        for(int i=0; i<num_ticks; i++) {
+            float simulated_mouse_x = lerp(prev_mouse_x, mouse_x, (i+1)/((double)num_ticks));
+            float simulated_mouse_y = lerp(prev_mouse_y, mouse_y, (i+1)/((double)num_ticks));
+
+            auto offset = MapVec(simulated_mouse_x - 0.5f*render_w,
+                                 simulated_mouse_y - 0.5f*render_h)
+                                 / tile_len;
+
+            advance_one_tick(tick_len,
+                             player->get_position() + offset,
+                             gfx_library->get_mouse_state(),
+                             gfx_library->get_keyboard_state());
+        }
 
-    prev_mouse_x = mouse_x;
-    prev_mouse_y = mouse_y;
+        prev_mouse_x = mouse_x;
+        prev_mouse_y = mouse_y;
+    }
 
     //a few hundred ms (integrated GPU, 1920x1080, Test3)
     GameGfxRenderArgs render_args;
@@ -467,12 +619,15 @@ std::shared_ptr<kx::gfx::Texture> Game::run(const LibraryPointers &libraries,
     render_args.render_w = render_w;
     render_args.render_h = render_h;
     render_args.tile_len = tile_len;
-    render_args.map_objs = &map_objs;
+    render_args.map_objs = &map_objs.get_objs();
     render_args.gfx_only_map_objs = &gfx_only_map_objs;
+    render_args.projectiles = projectiles.get();
     render_args.ceng_data = &ceng_data;
     render_args.player = player.get();
     render_args.rngs = &rngs;
     render_args.cur_level_time = cur_level_time;
+    //what's left in the accumulator is how far we are into the next tick
+    render_args.tick_interp = std::min(unsimulated_time / tick_len, 1.0);
 
     auto ret = gfx->render(render_args);
     return ret;
@@ -1,17 +1,23 @@
 #pragma once
 
 #include "geo2/map_obj/unit/player_type1.h"
+#include "geo2/ceng1_broadphase.h"
 #include "geo2/ceng1_collision.h"
+#include "geo2/ceng1_collision_groups.h"
 #include "geo2/ceng1_data.h"
 #include "geo2/rng.h"
 #include "geo2/library_pointers.h"
 #include "geo2/level.h"
+#include "geo2/map_obj_slot_map.h"
+#include "geo2/projectile_system.h"
 
 #include "kx/gfx/renderer.h"
 #include "kx/gfx/kwindow.h"
+#include "kx/time.h"
 
 #include <memory>
 #include <vector>
+#include <array>
 #include <cstdint>
 
 namespace geo2 {
@@ -22,7 +28,14 @@ class Game final
 
     std::shared_ptr<map_obj::Player_Type1> player;
     std::vector<std::shared_ptr<map_obj::MapObject>> gfx_only_map_objs;
-    std::vector<std::shared_ptr<map_obj::MapObject>> map_objs;
+    //map_objs[i] goes with ceng_data[i]
+    MapObjSlotMap map_objs;
+    //run1 and run3 go through map_objs by type, in this order
+    std::unique_ptr<class MapObjTypeBuckets> map_obj_buckets;
+    //map objects are numbered in the order they're added, which is the order they're
+    //rendered in when their groups have the same priority (and shader); their order in
+    //map_objs changes when something is deleted
+    uint64_t next_render_seq;
 
     LevelName cur_level_name;
     int64_t cur_level_tick;
@@ -32,7 +45,16 @@ class Game final
     int prev_mouse_x;
     int prev_mouse_y;
 
+    //the simulation runs in fixed ticks of tick_len seconds, as many as fit into the real
+    //time that has passed (but at most max_ticks_per_frame per frame, so a slow frame can't
+    //make the next one even slower); the rest carries over to the next frame
+    double tick_len;
+    int max_ticks_per_frame;
+    kx::Time prev_frame_time;
+    double unsimulated_time;
+
     std::shared_ptr<class ThreadPool> thread_pool;
+    std::unique_ptr<class ForkJoinPhases> tick_phases;
 
     std::vector<StandardRNG> rngs;
 
@@ -41,8 +63,13 @@ class Game final
     std::vector<std::vector<std::shared_ptr<map_obj::MapObject>>> map_objs_to_add_lt;
     std::vector<int> idx_to_delete;
     std::vector<std::vector<int>> idx_to_delete_lt;
+    std::vector<CEng1IdxMove> idx_moves;
     std::vector<CEng1Data> ceng_data;
     std::unique_ptr<class CollisionEngine1> collision_engine;
+    CEng1CollisionGroups collision_groups;
+    std::vector<std::array<CEng1BroadphaseUpdate, 2>> broadphase_updates;
+    std::unique_ptr<ProjectileSystem> projectiles;
+    std::vector<CEng1ShapeHit> projectile_hits;
 
     void generate_and_start_level(LevelName level_name);
 
@@ -51,7 +78,20 @@ class Game final
                     kx::gfx::mouse_state_t mouse_state,
                     kx::gfx::keyboard_state_t keyboard_state);
     void run1(double tick_len);
+    ///moves everything in map_objs_to_add_lt and idx_to_delete_lt to the shared vectors
+    void merge_local_buffers();
+    void prepare_collision_engine();
+    ///runs handle_collision on both objects and updates their intents, which only touches
+    ///the two objects, so collisions in different CEng1CollisionGroups can run in parallel
+    std::array<CEng1BroadphaseUpdate, 2> handle_collision(const CEng1Collision &collision,
+                                                          std::vector<int> *idx_to_delete_);
+    ///resolves collisions[begin] ... collisions[end-1]; new collisions are appended
+    void resolve_collisions_serially(std::vector<CEng1Collision> *collisions, size_t begin, size_t end);
+    void resolve_collisions_in_parallel(std::vector<CEng1Collision> *collisions, size_t begin, size_t end);
     void run_collision_engine();
+    ///moves the projectiles to where they are at the end of the tick and lets the objects
+    ///they hit there handle the hits
+    void run_projectiles(double tick_len);
     void run3(double tick_len);
     void process_added_map_objs();
     void process_deleted_map_objs();
@@ -60,8 +100,9 @@ class Game final
                           MapCoord cursor_pos,
                           kx::gfx::mouse_state_t mouse_state,
                           kx::gfx::keyboard_state_t keyboard_state);
+    friend class GameBenchmark;
 public:
-    Game(kx::Passkey<class MasterInstance>);
+    Game(kx::Passkey<class MasterInstance, class GameBenchmark>);
     ~Game();
 
     ///noncopyable and nonmovable for safety
@@ -70,6 +111,11 @@ public:
     Game(Game&&) = delete;
     Game &operator = (Game&&) = delete;
 
+    ///the default is 1440 ticks/s
+    void set_tick_rate(double ticks_per_sec);
+    ///the default is 30; if more ticks than that are due, the game slows down instead
+    void set_max_ticks_per_frame(int max_ticks);
+
     std::shared_ptr<kx::gfx::Texture> run(const LibraryPointers &libraries,
                                           kx::gfx::KWindowRunning *kwin_r,
                                           GameRenderSceneGraph *render_scene_graph,
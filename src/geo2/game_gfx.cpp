@@ -2,6 +2,7 @@
 #include "geo2/map_obj/map_object.h"
 #include "geo2/map_obj/map_obj_args.h"
 #include "geo2/map_obj/unit/player_type1.h"
+#include "geo2/projectile_system.h"
 #include "geo2/texture_utils.h"
 
 namespace geo2 {
@@ -147,37 +148,35 @@ class GameGfx::Impl
 
     void render_hitboxes(const GameGfxRenderArgs &args, const map_obj::MapObjRenderArgs &map_obj_args)
     {
-        auto hitbox_op_group = std::make_shared<RenderOpGroup>(0);
-        auto add_lines = [&hitbox_op_group, &args, &map_obj_args]
+        auto shader = args.render_scene_graph->shaders.get("line");
+        auto add_lines = [shader, &map_obj_args]
                          (const Polygon *polygon, [[maybe_unused]] int shape_id)
                         {
                             for(size_t i=1; i<=polygon->get_num_vertices(); i++) {
-                                auto shader = args.render_scene_graph->shaders.get("line");
-                                auto op = std::make_unique<RenderOpShader>(*shader);
-                                auto iu_map = op->map_instance_uniform(0);
-                                kx::kx_span<float> op_iu((float*)iu_map.begin(), (float*)iu_map.end());
-
                                 auto v0 = polygon->get_vertex(i-1);
                                 auto v1 = polygon->get_vertex(i);
-                                op_iu[0] = map_obj_args.x_to_ndc(v0.x);
-                                op_iu[1] = map_obj_args.y_to_ndc(v0.y);
-                                op_iu[2] = map_obj_args.x_to_ndc(v1.x);
-                                op_iu[3] = map_obj_args.y_to_ndc(v1.y);
+                                float x1 = map_obj_args.x_to_ndc(v0.x);
+                                float y1 = map_obj_args.y_to_ndc(v0.y);
+                                float x2 = map_obj_args.x_to_ndc(v1.x);
+                                float y2 = map_obj_args.y_to_ndc(v1.y);
 
-                                if(map_obj_args.is_x_line_ndc_in_view(op_iu[0], op_iu[2]) &&
-                                   map_obj_args.is_y_line_ndc_in_view(op_iu[1], op_iu[3]))
+                                if(map_obj_args.is_x_line_ndc_in_view(x1, x2) &&
+                                   map_obj_args.is_y_line_ndc_in_view(y1, y2))
                                 {
+                                    auto op_iu = map_obj_args.add_op(*shader);
+                                    op_iu[0] = x1;
+                                    op_iu[1] = y1;
+                                    op_iu[2] = x2;
+                                    op_iu[3] = y2;
                                     op_iu[4] = 0.1;
                                     op_iu[5] = 2.0;
                                     op_iu[6] = 2.0;
                                     op_iu[7] = 0.95;
-
-                                    hitbox_op_group->add_op(std::move(op));
                                 }
                             }
                         };
 
-        op_groups.push_back(hitbox_op_group);
+        args.render_scene_graph->get_op_arena()->begin_group(0, 0);
 
         for(auto &d: *args.ceng_data) {
             if(d.get_move_intent() == MoveIntent::StayAtCurrentPos) {
@@ -187,7 +186,7 @@ class GameGfx::Impl
             }
         }
 
-        args.render_scene_graph->render_and_clear_vec(&op_groups, args.kwin_r, args.render_w, args.render_h);
+        args.render_scene_graph->render_and_clear(args.kwin_r, args.render_w, args.render_h);
     }
 public:
     PersistentTextureTarget render_func_return_texture;
@@ -338,23 +337,28 @@ public:
         kx::gfx::Rect camera;
         camera.w = args.render_w / args.tile_len;
         camera.h = args.render_h / args.tile_len;
-        auto player_pos = args.player->get_position();
+        auto player_pos = args.player->get_interpolated_position(args.tick_interp);
         camera.x = player_pos.x - 0.5f * camera.w;
         camera.y = player_pos.y - 0.5f * camera.h;
         map_obj_args.set_camera(camera);
         map_obj_args.pixels_per_tile_len = args.tile_len;
         map_obj_args.cur_level_time = args.cur_level_time;
+        map_obj_args.tick_interp = args.tick_interp;
         map_obj_args.set_rng(&(*args.rngs)[0]);
-        map_obj_args.set_op_groups_vec(&op_groups);
+        map_obj_args.set_op_arena(args.render_scene_graph->get_op_arena());
 
         for(auto &map_obj: *args.map_objs) {
+            map_obj_args.set_render_seq(map_obj->get_render_seq());
             map_obj->add_render_ops(map_obj_args);
         }
         for(auto &map_obj: *args.gfx_only_map_objs) {
+            map_obj_args.set_render_seq(map_obj->get_render_seq());
             map_obj->add_render_ops(map_obj_args);
         }
+        map_obj_args.set_render_seq(0);
+        args.projectiles->add_render_ops(map_obj_args);
 
-        args.render_scene_graph->render_and_clear_vec(&op_groups, args.kwin_r, args.render_w, args.render_h);
+        args.render_scene_graph->render_and_clear(args.kwin_r, args.render_w, args.render_h);
 
         if(args.flags & GameGfxRenderArgs::FLAG_SHOW_HITBOXES)
             render_hitboxes(args, map_obj_args);
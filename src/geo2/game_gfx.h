@@ -13,6 +13,7 @@ class KWindowRunning;
 namespace geo2 {
 class Xorshift64RNG;
 class CEng1Data;
+class ProjectileSystem;
 
 namespace map_obj {
 class MapObject;
@@ -30,12 +31,15 @@ struct GameGfxRenderArgs
     int render_w;
     int render_h;
     float tile_len;
-    std::vector<std::shared_ptr<map_obj::MapObject>> *map_objs;
+    const std::vector<map_obj::MapObject*> *map_objs;
     std::vector<std::shared_ptr<map_obj::MapObject>> *gfx_only_map_objs;
+    ProjectileSystem *projectiles;
     std::vector<CEng1Data> *ceng_data;
     map_obj::Player_Type1 *player;
     std::vector<Xorshift64RNG> *rngs;
     double cur_level_time;
+    ///see MapObjRenderArgs::tick_interp
+    double tick_interp;
 };
 
 class GameGfx
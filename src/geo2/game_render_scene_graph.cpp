@@ -24,7 +24,16 @@ class ShadersLoader
         auto vert = rdr->make_vert_shader(PATH + (std::string)path + ".vert");
         auto frag = rdr->make_frag_shader(PATH + (std::string)path + ".frag");
         auto program = rdr->make_shader_program(*vert, *frag);
-        auto shader = std::make_unique<IShader>(std::move(program), max_instances, draw_mode, count);
+        //the same shader with its block as an SSB, so batches can be much bigger
+        std::shared_ptr<kx::gfx::ShaderProgram> ssbo_program;
+        if(rdr->supports_SSBOs()) {
+            auto vert_ssbo = rdr->make_vert_shader(PATH + (std::string)path + "_ssbo.vert");
+            auto frag_ssbo = rdr->make_frag_shader(PATH + (std::string)path + "_ssbo.frag");
+            ssbo_program = rdr->make_shader_program(*vert_ssbo, *frag_ssbo);
+        }
+        int id = shaders_map->size();
+        auto shader = std::make_unique<IShader>(std::move(program), id, max_instances, draw_mode, count,
+                                                ssbo_program);
         shader->add_UB("block1", 0, ub_size * 4 * sizeof(float));
         shaders_map->emplace(name, std::move(shader));
     }
@@ -118,9 +127,11 @@ void GameRenderSceneGraph::Fonts::init(kx::gfx::FontLibrary *font_library,
 {
     using namespace kx::gfx;
     fonts_map.emplace("default",
-                      std::make_unique<FontAtlas>(rdr, font_library->get_font(FontLibrary::FONT_BLACK_CHANCERY).get()));
+                      std::make_unique<FontAtlas>(rdr, font_library->get_font(FontLibrary::FONT_BLACK_CHANCERY).get(),
+                                                  fonts_map.size()));
     fonts_map.emplace("black_chancery",
-                      std::make_unique<FontAtlas>(rdr, font_library->get_font(FontLibrary::FONT_BLACK_CHANCERY).get()));
+                      std::make_unique<FontAtlas>(rdr, font_library->get_font(FontLibrary::FONT_BLACK_CHANCERY).get(),
+                                                  fonts_map.size()));
 }
 const FontAtlas *GameRenderSceneGraph::Fonts::get(std::string_view name) const
 {
@@ -4,155 +4,256 @@
 #include <immintrin.h>
 #include <cstring>
 #include <cstdlib>
+#include <new>
+#include <atomic>
+#include <vector>
+#include <algorithm>
 
-//#define USE_POLYGON_ALLOCATOR
+#define USE_POLYGON_ALLOCATOR
 
 namespace geo2 {
 
 inline constexpr uint32_t get_polygon_d_len(uint32_t n)
 {
-    return 8 * ((n + 7) / 8) + 1;
+    //room for the repeated first vertex, rounded up to whole registers so that every
+    //array starts on a 32 byte boundary
+    return 8 * ((n + 8) / 8);
 }
 inline constexpr size_t get_polygon_size(uint32_t n)
 {
-    return sizeof(Polygon) + sizeof(float) * 2 * get_polygon_d_len(n);
+    //the vertices and the edge normals
+    return sizeof(Polygon) + sizeof(float) * 4 * get_polygon_d_len(n);
 }
 
+/** Polygons with up to 39 vertices (so every polygon with 1-32 sides) come from slabs,
+ *  one per size class (every 8 vertices need the same amount of memory, and 32 is the
+ *  first of the last class, as there has to be room for the repeated first vertex). Every thread keeps a magazine of free blocks for each
+ *  class, so most allocations and deallocations don't touch anything shared; the shared
+ *  free list and the slabs are only locked to refill or drain half a magazine at a time.
+ *  Blocks are freed into the magazine of whichever thread frees them, so it doesn't matter
+ *  which thread allocated them. The slabs grow a chunk at a time and are never given back.
+ */
 class PolygonAllocator
 {
-    static constexpr auto ALL_ONES = std::numeric_limits<uint64_t>::max();
-    static_assert(__builtin_popcountll(ALL_ONES) == 64);
-
-    static constexpr size_t POLYGONS_PER_LEVEL = 1<<16;
-
-    static constexpr size_t LEVEL_POLYGON_SIZE_BYTES[] {
-        get_polygon_size(0*8 + 1),
-        get_polygon_size(1*8 + 1),
-        get_polygon_size(2*8 + 1),
-        get_polygon_size(3*8 + 1)
+public:
+    static constexpr uint32_t MAX_N = 39;
+    static constexpr int NUM_CLASSES = (MAX_N + 1) / 8;
+    static constexpr size_t ALIGNMENT = 32;
+private:
+    static constexpr uint32_t MAGAZINE_SIZE = 64;
+    static constexpr size_t BLOCKS_PER_CHUNK = 1024;
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
     };
-
-    static constexpr size_t LEVEL_SIZE_BYTES[] {
-        POLYGONS_PER_LEVEL * LEVEL_POLYGON_SIZE_BYTES[0],
-        POLYGONS_PER_LEVEL * LEVEL_POLYGON_SIZE_BYTES[1],
-        POLYGONS_PER_LEVEL * LEVEL_POLYGON_SIZE_BYTES[2],
-        POLYGONS_PER_LEVEL * LEVEL_POLYGON_SIZE_BYTES[3]
+    struct SizeClass
+    {
+        kx::Spinlock<> lock;
+        size_t block_size;
+        FreeBlock *free_list = nullptr;
+        uint8_t *chunk_cur = nullptr;
+        uint8_t *chunk_end = nullptr;
+        size_t num_blocks = 0;
+        //the polygons counted by the magazines are added to this
+        int64_t num_live = 0;
     };
-
-    static constexpr size_t CUM_LEVEL_SIZE_BYTES[] {
-        0,
-        LEVEL_SIZE_BYTES[0],
-        LEVEL_SIZE_BYTES[0] + LEVEL_SIZE_BYTES[1],
-        LEVEL_SIZE_BYTES[0] + LEVEL_SIZE_BYTES[1] + LEVEL_SIZE_BYTES[2]
+    struct Magazine
+    {
+        void *blocks[MAGAZINE_SIZE];
+        uint32_t size;
+        //allocations - deallocations since the last refill or drain; only the owning
+        //thread writes it, so it doesn't need atomic increments, but get_stats() reads it
+        std::atomic<int64_t> live_delta;
+
+        inline void add_live(int64_t delta)
+        {
+            live_delta.store(live_delta.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
     };
-
-    void *base_addr;
-    //0 bit = in use, 1 bit = free
-    uint64_t L1;
-    uint64_t L2[64];
-    uint64_t L3[64][64];
-    kx::Spinlock<> lock;
-public:
-    PolygonAllocator()
+    //this has to be trivially destructible so that it can still be used after the thread's
+    //destructors ran (e.g. by static Polygons that get destroyed after main() returns)
+    struct ThreadCache
     {
-        for(int i=0; i<4; i++) {
-            for(int j=1; j<8; j++)
-                k_assert(get_polygon_size(i*8 + j) == get_polygon_size(i*8 + j + 1));
+        Magazine magazines[NUM_CLASSES];
+        bool registered;
+        bool flushed;
+    };
+    struct ThreadCacheFlusher
+    {
+        ~ThreadCacheFlusher()
+        {
+            get()->flush_thread_cache();
         }
+    };
 
-        size_t num_bytes = 0;
+    SizeClass classes[NUM_CLASSES];
+    std::atomic<int64_t> num_large_live;
+    //the caches of the threads that are still running, for get_stats()
+    kx::Spinlock<> thread_caches_lock;
+    std::vector<ThreadCache*> thread_caches;
 
-        for(int i=0; i<4; i++)
-            num_bytes += LEVEL_SIZE_BYTES[i];
+    static thread_local ThreadCache thread_cache;
+    static thread_local ThreadCacheFlusher thread_cache_flusher;
 
-        base_addr = std::malloc(num_bytes);
-        if((uintptr_t)base_addr % 16 != 0)
-            kx::log_error("bad PolygonAllocator buffer alignment (needs to be a multiple of 16)");
+    static constexpr int get_class(uint32_t n)
+    {
+        return n / 8;
+    }
+    ///the lock has to be held
+    void *take_block(SizeClass *c)
+    {
+        if(c->free_list != nullptr) {
+            auto ret = c->free_list;
+            c->free_list = ret->next;
+            return ret;
+        }
+        if(c->chunk_cur == c->chunk_end) {
+            auto chunk_size = BLOCKS_PER_CHUNK * c->block_size;
+            c->chunk_cur = (uint8_t*)::operator new(chunk_size, std::align_val_t(ALIGNMENT));
+            c->chunk_end = c->chunk_cur + chunk_size;
+            c->num_blocks += BLOCKS_PER_CHUNK;
+        }
+        auto ret = c->chunk_cur;
+        c->chunk_cur += c->block_size;
+        return ret;
+    }
+    ///the lock has to be held
+    void give_block(SizeClass *c, void *ptr)
+    {
+        auto block = (FreeBlock*)ptr;
+        block->next = c->free_list;
+        c->free_list = block;
+    }
+    void refill(int class_idx, Magazine *magazine)
+    {
+        if(!thread_cache.registered) {
+            //makes sure the flusher gets constructed, and so destroyed, in this thread
+            (void)&thread_cache_flusher;
+            auto lg = thread_caches_lock.get_lock_guard();
+            thread_caches.push_back(&thread_cache);
+            thread_cache.registered = true;
+        }
 
-        L1 = ALL_ONES;
-        std::fill(std::begin(L2), std::end(L2), ALL_ONES);
-        for(auto &level: L3)
-            std::fill(std::begin(level), std::end(level), ALL_ONES);
+        auto c = &classes[class_idx];
+        auto lg = c->lock.get_lock_guard();
+        c->num_live += magazine->live_delta.load(std::memory_order_relaxed);
+        magazine->live_delta.store(0, std::memory_order_relaxed);
+        while(magazine->size < MAGAZINE_SIZE / 2)
+            magazine->blocks[magazine->size++] = take_block(c);
+    }
+    void drain(int class_idx, Magazine *magazine, uint32_t keep)
+    {
+        auto c = &classes[class_idx];
+        auto lg = c->lock.get_lock_guard();
+        c->num_live += magazine->live_delta.load(std::memory_order_relaxed);
+        magazine->live_delta.store(0, std::memory_order_relaxed);
+        while(magazine->size > keep)
+            give_block(c, magazine->blocks[--magazine->size]);
     }
-    ~PolygonAllocator()
+    void flush_thread_cache()
     {
-        /* //unfortunately, we can't rely on the order of static object destruction;
-           //i.e. perhaps this destructor is called before some static Polygons are destroyed
-        auto lg = lock.get_lock_guard();
-        k_expects(L1 == ALL_ONES); //if this is the case, all polygons have been freed
-        */
-        std::free(base_addr);
+        auto lg = thread_caches_lock.get_lock_guard();
+        for(int i=0; i<NUM_CLASSES; i++)
+            drain(i, &thread_cache.magazines[i], 0);
+        thread_caches.erase(std::find(thread_caches.begin(), thread_caches.end(), &thread_cache));
+        thread_cache.flushed = true;
+    }
+public:
+    PolygonAllocator():
+        num_large_live(0)
+    {
+        for(int i=0; i<NUM_CLASSES; i++) {
+            //round up so that every block in a chunk is aligned
+            auto size = get_polygon_size(i*8 + 7);
+            classes[i].block_size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+            for(int j=std::max(i*8, 1); j<i*8 + 8; j++)
+                k_assert(get_polygon_size(j) == size);
+        }
     }
     void *allocate(uint32_t n)
     {
-        if(__builtin_expect(n<=0 || n>32, 0)) {
-            kx::log_error("PolygonAllocator got polygon with bad size (n = " + kx::to_str(n) + ")");
-            return nullptr;
+        if(n > MAX_N) {
+            num_large_live.fetch_add(1, std::memory_order_relaxed);
+            return ::operator new(get_polygon_size(n), std::align_val_t(ALIGNMENT));
         }
-        auto level = (n-1)/8;
-
-        auto lg = lock.get_lock_guard();
-
-        auto relevant_L1 = (L1 & (((1ULL<<16) - 1) << (level*16)));
-        if(__builtin_expect(relevant_L1 == 0, 0)) {
-            kx::log_error("PolygonAllocator ran out of memory (level = " + kx::to_str(level) + ")");
-            return nullptr;
+        auto class_idx = get_class(n);
+        if(__builtin_expect(thread_cache.flushed, 0)) {
+            auto c = &classes[class_idx];
+            auto lg = c->lock.get_lock_guard();
+            c->num_live++;
+            return take_block(c);
         }
-
-        auto L1_bit = __builtin_ctzll(relevant_L1);
-        auto L2_bit = __builtin_ctzll(L2[L1_bit]);
-        auto L3_bit = __builtin_ctzll(L3[L1_bit][L2_bit]);
-
-        L3[L1_bit][L2_bit] ^= (1ULL << L3_bit);
-        L2[L1_bit] ^= (((uint64_t)(L3[L1_bit][L2_bit] == 0)) << L2_bit);
-        L1 ^= (((uint64_t)(L2[L1_bit] == 0)) << L1_bit);
-
-        auto ret_addr = (uintptr_t)base_addr;
-        ret_addr += CUM_LEVEL_SIZE_BYTES[level];
-        ret_addr += (64*64) * (L1_bit >> (level*16)) * LEVEL_POLYGON_SIZE_BYTES[level];
-        ret_addr += 64 * L2_bit * LEVEL_POLYGON_SIZE_BYTES[level];
-        ret_addr += L3_bit * LEVEL_POLYGON_SIZE_BYTES[level];
-        return (void*)ret_addr;
+        auto magazine = &thread_cache.magazines[class_idx];
+        if(__builtin_expect(magazine->size == 0, 0))
+            refill(class_idx, magazine);
+        magazine->add_live(1);
+        return magazine->blocks[--magazine->size];
     }
-    void deallocate(void *ptr)
+    void deallocate(void *ptr, uint32_t n)
     {
-        auto offset = (uintptr_t)ptr - (uintptr_t)base_addr;
-
-        int L1_offset = 0;
-
-        int level = 0;
-        for(level=0; level<3; level++) {
-            if(offset < LEVEL_SIZE_BYTES[level]) {
-                break;
-            }
-            offset -= LEVEL_SIZE_BYTES[level];
-            L1_offset += 16;
+        if(n > MAX_N) {
+            num_large_live.fetch_sub(1, std::memory_order_relaxed);
+            ::operator delete(ptr, std::align_val_t(ALIGNMENT));
+            return;
         }
-        offset /= LEVEL_POLYGON_SIZE_BYTES[level];
-
-        auto L1_bit = L1_offset + offset / (64*64);
-        auto L2_bit = (offset / 64) % 64;
-        auto L3_bit = offset % 64;
-
-        auto lg = lock.get_lock_guard();
+        auto class_idx = get_class(n);
+        if(__builtin_expect(thread_cache.flushed, 0)) {
+            auto c = &classes[class_idx];
+            auto lg = c->lock.get_lock_guard();
+            c->num_live--;
+            give_block(c, ptr);
+            return;
+        }
+        auto magazine = &thread_cache.magazines[class_idx];
+        if(__builtin_expect(magazine->size == MAGAZINE_SIZE, 0))
+            drain(class_idx, magazine, MAGAZINE_SIZE / 2);
+        magazine->add_live(-1);
+        magazine->blocks[magazine->size++] = ptr;
+    }
+    PolygonAllocatorStats get_stats()
+    {
+        PolygonAllocatorStats ret;
+        auto caches_lg = thread_caches_lock.get_lock_guard();
+        for(int i=0; i<NUM_CLASSES; i++) {
+            auto &c = classes[i];
+            auto lg = c.lock.get_lock_guard();
+            ret.classes[i].max_n = i*8 + 7;
+            ret.classes[i].block_size = c.block_size;
+            ret.classes[i].num_blocks = c.num_blocks;
+            ret.classes[i].num_live = c.num_live;
+            for(auto cache: thread_caches)
+                ret.classes[i].num_live += cache->magazines[i].live_delta.load(std::memory_order_relaxed);
+        }
+        ret.num_large_live = num_large_live.load(std::memory_order_relaxed);
+        return ret;
+    }
 
-        L3[L1_bit][L2_bit] |= (1ULL << L3_bit);
-        L2[L1_bit] |= (1ULL << L2_bit);
-        L1 |= (1ULL << L1_bit);
+    ///never destroyed, as static Polygons can be destroyed after any other static object
+    static PolygonAllocator *get()
+    {
+        static PolygonAllocator *alloc = new PolygonAllocator();
+        return alloc;
     }
 };
 
-inline PolygonAllocator *get_polygon_allocator()
+thread_local PolygonAllocator::ThreadCache PolygonAllocator::thread_cache;
+thread_local PolygonAllocator::ThreadCacheFlusher PolygonAllocator::thread_cache_flusher;
+
+static_assert(PolygonAllocator::NUM_CLASSES == PolygonAllocatorStats::NUM_CLASSES);
+
+PolygonAllocatorStats get_polygon_allocator_stats()
 {
-    static PolygonAllocator alloc;
-    return &alloc;
+    #ifdef USE_POLYGON_ALLOCATOR
+    return PolygonAllocator::get()->get_stats();
+    #else
+    return PolygonAllocatorStats{};
+    #endif
 }
-//Declaring this ensures that the static field in the above function will be constructed
-//by the time main starts, which is good because it prevents data races
-auto dummy_polygon = Polygon::make_with_num_sides(1);
 
 //not necessary, but good for performance and ensures we've checked every field
-static_assert(sizeof(Polygon) == 20); //20 = sizeof(int) + sizeof(AABB)
+static_assert(sizeof(Polygon) == 32); //32 = sizeof(int) + sizeof(AABB) + sizeof(bool) + padding to the alignment
+static_assert(alignof(Polygon) == PolygonAllocator::ALIGNMENT);
 
 uint32_t Polygon::get_d_len(uint32_t n)
 {
@@ -160,16 +261,17 @@ uint32_t Polygon::get_d_len(uint32_t n)
 }
 void *Polygon::operator new([[maybe_unused]] size_t bytes, uint32_t n)
 {
-    #ifdef USE_POLYGON_ALLOCATOR
-    return get_polygon_allocator()->allocate(n);
-    #else
     //n==0 shouldn't happen in general; there are also functions here that assume >0 vertices
     k_expects(n > 0);
-    return ::operator new(get_polygon_size(n));
+    #ifdef USE_POLYGON_ALLOCATOR
+    return PolygonAllocator::get()->allocate(n);
+    #else
+    return ::operator new(get_polygon_size(n), std::align_val_t(alignof(Polygon)));
     #endif
 }
 Polygon::Polygon(uint32_t num_sides):
-    n(num_sides)
+    n(num_sides),
+    convex(false)
 {}
 template<class T> Polygon::Polygon(kx::kx_span<_MapCoord<T>> vertices):
     n(vertices.size())
@@ -193,6 +295,7 @@ template<class T> Polygon::Polygon(kx::kx_span<_MapCoord<T>> vertices):
     }
 
     calc_aabb();
+    calc_normals();
 }
 void Polygon::calc_aabb()
 {
@@ -211,64 +314,107 @@ void Polygon::calc_aabb()
         aabb.combine(c);
     }
 }
+void Polygon::calc_normals()
+{
+    auto d_len = get_d_len(n);
+    auto verts = get_verts();
+    auto normals = get_normals();
+
+    //twice the signed area tells whether the vertices go clockwise or counterclockwise
+    float area2 = 0;
+    for(uint32_t i=0; i<n; i++)
+        area2 += verts[i] * verts[d_len + i+1] - verts[i+1] * verts[d_len + i];
+    float sign = area2 >= 0? 1: -1;
+
+    for(uint32_t i=0; i<n; i++) {
+        normals[i] = sign * (verts[d_len + i+1] - verts[d_len + i]);
+        normals[d_len + i] = sign * (verts[i] - verts[i+1]);
+    }
+    for(uint32_t i=n; i<d_len; i++) {
+        normals[i] = normals[i - n];
+        normals[d_len + i] = normals[d_len + i - n];
+    }
+
+    //convex if it always turns the same way and only goes around once, which we know if
+    //the direction of the edges only changes between left and right twice (this rules out
+    //things like pentagrams); collinear vertices are fine
+    convex = n >= 3 && area2 != 0;
+    int x_dir_changes = 0;
+    float prev_dx = 0;
+    for(uint32_t i=0; convex && i<=n; i++) {
+        //i == n is edge 0 again, to count the change from the last edge to the first one
+        auto cur = i % n;
+        auto next = (cur + 1) % n;
+        auto next_next = (cur + 2) % n;
+        float dx = verts[next] - verts[cur];
+        float dy = verts[d_len + next] - verts[d_len + cur];
+        float dx2 = verts[next_next] - verts[next];
+        float dy2 = verts[d_len + next_next] - verts[d_len + next];
+        if(sign * (dx * dy2 - dy * dx2) < 0)
+            convex = false;
+        if(dx != 0) {
+            if(prev_dx != 0 && (dx > 0) != (prev_dx > 0))
+                x_dir_changes++;
+            prev_dx = dx;
+        }
+    }
+    if(x_dir_changes > 2)
+        convex = false;
+}
 void Polygon::translate_internal(float dx, float dy)
 {
     //use d_len, not n, as we have to move duplicated vertices too
     auto d_len = get_d_len(n);
-    k_expects(d_len % 8 == 1);
+    k_expects(d_len % 8 == 0);
 
     auto verts = get_verts();
 
-    verts[0] += dx;
-    verts[d_len] += dy;
-
     auto mm_dx = _mm256_set1_ps(dx);
     auto mm_dy = _mm256_set1_ps(dy);
 
-    for(uint32_t i=1; i<d_len; i+=8) {
-        auto mm_x = _mm256_loadu_ps(verts + i);
-        auto mm_y = _mm256_loadu_ps(verts + d_len + i);
+    for(uint32_t i=0; i<d_len; i+=8) {
+        auto mm_x = _mm256_load_ps(verts + i);
+        auto mm_y = _mm256_load_ps(verts + d_len + i);
 
         mm_x += mm_dx;
         mm_y += mm_dy;
 
-        _mm256_storeu_ps(verts + i, mm_x);
-        _mm256_storeu_ps(verts + d_len + i, mm_y);
+        _mm256_store_ps(verts + i, mm_x);
+        _mm256_store_ps(verts + d_len + i, mm_y);
     }
 }
 void Polygon::rotate_about_origin_internal(float theta)
 {
     auto d_len = get_d_len(n);
-    k_expects(d_len % 8 == 1);
-
-    auto verts = get_verts();
+    k_expects(d_len % 8 == 0);
 
     //use d_len, not n, as we have to move duplicated vertices too
     auto cos_theta = std::cos(theta);
     auto sin_theta = std::sin(theta);
 
-    {
-        auto cur_x = verts[0];
-        auto cur_y = verts[d_len];
-        verts[0] = cur_x * cos_theta - cur_y * sin_theta;
-        verts[d_len] = cur_x * sin_theta + cur_y * cos_theta;
-    }
-
     auto mm_cos_theta = _mm256_set1_ps(cos_theta);
     auto mm_sin_theta = _mm256_set1_ps(sin_theta);
 
-    for(uint32_t i=1; i<d_len; i+=8) {
-        auto mm_x = _mm256_loadu_ps(verts + i);
-        auto mm_y = _mm256_loadu_ps(verts + d_len + i);
+    //the normals rotate the same way as the vertices (and a rotation doesn't change
+    //whether the polygon is convex)
+    for(auto xy: {get_verts(), get_normals()}) {
+        for(uint32_t i=0; i<d_len; i+=8) {
+            auto mm_x = _mm256_load_ps(xy + i);
+            auto mm_y = _mm256_load_ps(xy + d_len + i);
 
-        _mm256_storeu_ps(verts + i, mm_x * mm_cos_theta - mm_y * mm_sin_theta);
-        _mm256_storeu_ps(verts + d_len + i, mm_x * mm_sin_theta + mm_y * mm_cos_theta);
+            _mm256_store_ps(xy + i, mm_x * mm_cos_theta - mm_y * mm_sin_theta);
+            _mm256_store_ps(xy + d_len + i, mm_x * mm_sin_theta + mm_y * mm_cos_theta);
+        }
     }
 }
 inline float *Polygon::get_verts() const
 {
     return (float*)((uint8_t*)this + sizeof(*this));
 }
+inline float *Polygon::get_normals() const
+{
+    return get_verts() + 2 * get_d_len(n);
+}
 uint32_t Polygon::get_num_vertices() const
 {
     return n;
@@ -276,17 +422,20 @@ uint32_t Polygon::get_num_vertices() const
 void Polygon::operator delete(void *ptr)
 {
     #ifdef USE_POLYGON_ALLOCATOR
-    get_polygon_allocator()->deallocate(ptr);
+    //the destructor is trivial, so n is still there
+    PolygonAllocator::get()->deallocate(ptr, static_cast<Polygon*>(ptr)->n);
     #else
-    ::operator delete(ptr);
+    ::operator delete(ptr, std::align_val_t(alignof(Polygon)));
     #endif
 }
 std::unique_ptr<Polygon> Polygon::copy() const
 {
     std::unique_ptr<Polygon> ret(new (n) Polygon(n));
     ret->aabb = aabb;
+    ret->convex = convex;
     auto d_len = get_d_len(n);
-    std::copy(get_verts(), get_verts() + 2*d_len, ret->get_verts());
+    //the normals are right after the vertices
+    std::copy(get_verts(), get_verts() + 4*d_len, ret->get_verts());
     return ret;
 }
 void Polygon::copy_from(const Polygon &other)
@@ -296,7 +445,8 @@ void Polygon::copy_from(const Polygon &other)
     auto d_len = get_d_len(n);
 
     aabb = other.aabb;
-    std::copy(other.get_verts(), other.get_verts() + 2*d_len, get_verts());
+    convex = other.convex;
+    std::copy(other.get_verts(), other.get_verts() + 4*d_len, get_verts());
 }
 void Polygon::translate(float dx, float dy)
 {
@@ -350,6 +500,7 @@ template<class T> void Polygon::remake(kx::kx_span<_MapCoord<T>> vertices)
     }
 
     calc_aabb();
+    calc_normals();
 }
 
 template void Polygon::remake<float>(kx::kx_span<_MapCoord<float>> vertices);
@@ -363,6 +514,12 @@ _MapCoord<float> Polygon::get_vertex(size_t idx) const
     return _MapCoord<float>(verts[idx], verts[d_len + idx]);
 }
 bool Polygon::has_collision(const Polygon &other) const
+{
+    if(convex && other.convex)
+        return has_collision_sat(other);
+    return has_edge_crossing(other);
+}
+bool Polygon::has_edge_crossing(const Polygon &other) const
 {
     //TODO: ensure reflexivity, e.g. ensure a.has_collision(b) == b.has_collision(a).
     //Perhaps this might not always hold due to floating point inaccuracies; the
@@ -412,13 +569,14 @@ bool Polygon::has_collision(const Polygon &other) const
         const auto Rx = _mm256_set1_ps(this_verts[i] - this_verts[i-1]);
         const auto Ry = _mm256_set1_ps(this_verts[this_d_len + i] - this_verts[this_d_len + i-1]);
 
-        for(uint32_t j=1; j<other_d_len; j+=8) {
+        for(uint32_t j=0; j<other_n; j+=8) {
 
-            auto Qx = _mm256_loadu_ps(other_verts + j-1);
-            auto Qy = _mm256_loadu_ps(other_verts + other_d_len + j-1);
+            auto Qx = _mm256_load_ps(other_verts + j);
+            auto Qy = _mm256_load_ps(other_verts + other_d_len + j);
 
-            auto Sx = _mm256_loadu_ps(other_verts + j) - Qx;
-            auto Sy = _mm256_loadu_ps(other_verts + other_d_len + j) - Qy;
+            //the ends of the edges are one vertex further, so these can't be aligned
+            auto Sx = _mm256_loadu_ps(other_verts + j+1) - Qx;
+            auto Sy = _mm256_loadu_ps(other_verts + other_d_len + j+1) - Qy;
 
             auto Ry_times_Sx = Ry * Sx;
 
@@ -451,17 +609,237 @@ bool Polygon::has_collision(const Polygon &other) const
             auto u_good = _mm256_and_ps(u_ge_0, u_le_1);
 
             auto good = _mm256_and_ps(t_good, u_good);
-            if(_mm256_movemask_ps(good))
+            //if the last chunk ends at d_len, its last lane goes past the x coordinates
+            //into the y ones, so only look at the lanes of real edges
+            int edges = other_n - j >= 8 ? 0xFF : (1 << (other_n - j)) - 1;
+            if(_mm256_movemask_ps(good) & edges)
                 return true;
         }
     }
 
     return false;
 }
+bool Polygon::has_separating_edge(const Polygon &a, const Polygon &b)
+{
+    //true if every vertex of b is on the outer side of (or on) some edge of a; 8 edges
+    //of a are kept in registers while we go through b's vertices, so there's only one
+    //branch per 8 edges
+    auto a_d_len = get_d_len(a.n);
+    auto b_d_len = get_d_len(b.n);
+    auto a_verts = a.get_verts();
+    auto a_normals = a.get_normals();
+    auto b_verts = b.get_verts();
+    const auto mm0 = _mm256_set1_ps(0);
+
+    //the padding at the end of a's vertices and normals repeats edges, so it doesn't
+    //matter that the last chunk can go past n
+    for(uint32_t i=0; i<a.n; i+=8) {
+        const auto Px = _mm256_load_ps(a_verts + i);
+        const auto Py = _mm256_load_ps(a_verts + a_d_len + i);
+        const auto Nx = _mm256_load_ps(a_normals + i);
+        const auto Ny = _mm256_load_ps(a_normals + a_d_len + i);
+
+        //a repeated vertex makes an edge with no length, which can't separate anything
+        auto inside = _mm256_and_ps(_mm256_cmp_ps(Nx, mm0, _CMP_EQ_OQ),
+                                    _mm256_cmp_ps(Ny, mm0, _CMP_EQ_OQ));
+        for(uint32_t j=0; j<b.n; j++) {
+            auto Qx = _mm256_set1_ps(b_verts[j]) - Px;
+            auto Qy = _mm256_set1_ps(b_verts[b_d_len + j]) - Py;
+            //positive if the vertex is outside the edge
+            auto dist = _mm256_fmadd_ps(Qx, Nx, Qy * Ny);
+            inside = _mm256_or_ps(inside, _mm256_cmp_ps(dist, mm0, _CMP_LT_OQ));
+        }
+        if(_mm256_movemask_ps(inside) != 0xFF)
+            return true;
+    }
+    return false;
+}
+bool Polygon::has_collision_sat(const Polygon &other) const
+{
+    k_expects(convex && other.convex);
+
+    if(!this->get_AABB().overlaps(other.get_AABB()))
+        return false;
+
+    //Unlike has_edge_crossing(), this is symmetric: a.has_collision_sat(b) does exactly
+    //the same calculations as b.has_collision_sat(a), just in a different order.
+    //It's also much cheaper: there's no division, and every edge only has to be
+    //compared to the other polygon's vertices, not to all of its edges.
+    return !has_separating_edge(*this, other) && !has_separating_edge(other, *this);
+}
+uint64_t Polygon::has_collision_many(kx::kx_span<const Polygon* const> others) const
+{
+    k_expects(others.size() <= 64);
+
+    uint64_t ret = 0;
+
+    //the fast path only works if all of this fits in one register
+    if(!convex || n > 8) {
+        for(size_t k=0; k<others.size(); k++)
+            ret |= (uint64_t)has_collision(*others[k]) << k;
+        return ret;
+    }
+
+    auto d_len = get_d_len(n);
+    auto verts = get_verts();
+    auto normals = get_normals();
+    const auto mm0 = _mm256_set1_ps(0);
+
+    //this is has_collision_sat() with everything about this loaded once; the floating
+    //point operations are the same, so the results are exactly the same too
+    const auto Px = _mm256_load_ps(verts);
+    const auto Py = _mm256_load_ps(verts + d_len);
+    const auto Nx = _mm256_load_ps(normals);
+    const auto Ny = _mm256_load_ps(normals + d_len);
+    const auto zero_normal = _mm256_and_ps(_mm256_cmp_ps(Nx, mm0, _CMP_EQ_OQ),
+                                           _mm256_cmp_ps(Ny, mm0, _CMP_EQ_OQ));
+    __m256 Bx[8];
+    __m256 By[8];
+    for(uint32_t i=0; i<n; i++) {
+        Bx[i] = _mm256_set1_ps(verts[i]);
+        By[i] = _mm256_set1_ps(verts[d_len + i]);
+    }
+
+    for(size_t k=0; k<others.size(); k++) {
+        const auto &other = *others[k];
+        if(!aabb.overlaps(other.aabb))
+            continue;
+        if(!other.convex) {
+            ret |= (uint64_t)has_edge_crossing(other) << k;
+            continue;
+        }
+
+        auto other_d_len = get_d_len(other.n);
+        auto other_verts = other.get_verts();
+        auto other_normals = other.get_normals();
+
+        //our edges against the other's vertices
+        auto inside = zero_normal;
+        for(uint32_t j=0; j<other.n; j++) {
+            auto Qx = _mm256_set1_ps(other_verts[j]) - Px;
+            auto Qy = _mm256_set1_ps(other_verts[other_d_len + j]) - Py;
+            auto dist = _mm256_fmadd_ps(Qx, Nx, Qy * Ny);
+            inside = _mm256_or_ps(inside, _mm256_cmp_ps(dist, mm0, _CMP_LT_OQ));
+        }
+        if(_mm256_movemask_ps(inside) != 0xFF)
+            continue;
+
+        //the other's edges against our vertices, which are already broadcast
+        if(other.n > 8) {
+            ret |= (uint64_t)!has_separating_edge(other, *this) << k;
+            continue;
+        }
+        const auto Ox = _mm256_load_ps(other_verts);
+        const auto Oy = _mm256_load_ps(other_verts + other_d_len);
+        const auto ONx = _mm256_load_ps(other_normals);
+        const auto ONy = _mm256_load_ps(other_normals + other_d_len);
+        auto other_inside = _mm256_and_ps(_mm256_cmp_ps(ONx, mm0, _CMP_EQ_OQ),
+                                          _mm256_cmp_ps(ONy, mm0, _CMP_EQ_OQ));
+        for(uint32_t i=0; i<n; i++) {
+            auto Qx = Bx[i] - Ox;
+            auto Qy = By[i] - Oy;
+            auto dist = _mm256_fmadd_ps(Qx, ONx, Qy * ONy);
+            other_inside = _mm256_or_ps(other_inside, _mm256_cmp_ps(dist, mm0, _CMP_LT_OQ));
+        }
+        bool separated = _mm256_movemask_ps(other_inside) != 0xFF;
+        ret |= (uint64_t)!separated << k;
+    }
+    return ret;
+}
+bool Polygon::contains_point(_MapCoord<float> p) const
+{
+    if(p.x < aabb.x1 || p.x > aabb.x2 || p.y < aabb.y1 || p.y > aabb.y2)
+        return false;
+
+    bool inside = false;
+    auto prev = get_vertex(0);
+    for(uint32_t i=1; i<=n; i++) {
+        auto cur = get_vertex(i);
+        if((prev.y > p.y) != (cur.y > p.y)) {
+            float x_at_p = prev.x + (p.y - prev.y) * (cur.x - prev.x) / (cur.y - prev.y);
+            if(p.x < x_at_p)
+                inside = !inside;
+        }
+        prev = cur;
+    }
+    return inside;
+}
+bool Polygon::has_overlap(const Polygon &other) const
+{
+    if(!get_AABB().overlaps(other.get_AABB()))
+        return false;
+    if(convex && other.convex)
+        return has_collision_sat(other);
+    //if no edges cross, then either they're apart or one is inside the other, in which
+    //case any vertex of the inner one is inside the outer one
+    return has_edge_crossing(other) ||
+           other.contains_point(get_vertex(0)) ||
+           contains_point(other.get_vertex(0));
+}
+bool Polygon::remake_as_swept(const Polygon &convex_shape, _MapVec<float> d)
+{
+    //enough for anything the collision engine deals with
+    constexpr uint32_t MAX_SWEPT_VERTICES = 64;
+
+    auto shape_n = convex_shape.get_num_vertices();
+    if(n != shape_n + 2 || n > MAX_SWEPT_VERTICES || (d.x == 0 && d.y == 0))
+        return false;
+
+    //twice the signed area tells whether the vertices go clockwise or counterclockwise
+    float area2 = 0;
+    for(uint32_t i=0; i<shape_n; i++) {
+        auto v0 = convex_shape.get_vertex(i);
+        auto v1 = convex_shape.get_vertex(i+1);
+        area2 += v0.x * v1.y - v1.x * v0.y;
+    }
+    if(area2 == 0)
+        return false;
+
+    //an edge faces forward if its outward normal points along d
+    bool front[MAX_SWEPT_VERTICES];
+    int num_changes = 0;
+    for(uint32_t i=0; i<shape_n; i++) {
+        auto edge = convex_shape.get_vertex(i+1) - convex_shape.get_vertex(i);
+        front[i] = (area2 > 0? -edge.cross_prod(d): edge.cross_prod(d)) > 0;
+    }
+    for(uint32_t i=0; i<shape_n; i++)
+        num_changes += front[i] != front[(i + shape_n - 1) % shape_n];
+    //a convex shape has exactly one run of forward facing edges
+    if(num_changes != 2)
+        return false;
+
+    _MapCoord<float> swept_verts[MAX_SWEPT_VERTICES];
+    uint32_t num_verts = 0;
+    for(uint32_t i=0; i<shape_n; i++) {
+        //vertex i is between edge i-1 and edge i
+        auto v = convex_shape.get_vertex(i);
+        bool prev_front = front[(i + shape_n - 1) % shape_n];
+        if(!prev_front)
+            swept_verts[num_verts++] = v;
+        if(prev_front || front[i])
+            swept_verts[num_verts++] = v + d;
+        if(prev_front && !front[i])
+            swept_verts[num_verts++] = v;
+    }
+    k_assert(num_verts == n);
+
+    remake(kx::kx_span<_MapCoord<float>>(swept_verts, swept_verts + num_verts));
+    return true;
+}
 std::unique_ptr<Polygon> Polygon::make_with_num_sides(uint32_t num_sides)
 {
     return std::unique_ptr<Polygon>(new (num_sides) Polygon(num_sides));
 }
+size_t Polygon::get_size_with_num_sides(uint32_t num_sides)
+{
+    return get_polygon_size(num_sides);
+}
+Polygon *Polygon::make_with_num_sides_at(void *mem, uint32_t num_sides)
+{
+    k_expects(num_sides > 0);
+    //the global placement new, as the class has its own operator new
+    return ::new (mem) Polygon(num_sides);
+}
 template<class T> std::unique_ptr<Polygon> Polygon::make(kx::kx_span<_MapCoord<T>> vertices)
 {
     std::unique_ptr<Polygon> ret(new (vertices.size()) Polygon(vertices));
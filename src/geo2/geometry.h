@@ -3,6 +3,7 @@
 #include "kx/kx_span.h"
 
 #include <memory>
+#include <array>
 #include <type_traits>
 #include <algorithm>
 #include <cmath>
@@ -241,16 +242,43 @@ enum class MoveIntent: uint8_t {
     GoToDesiredPosIfOtherDoesntCollide
 };
 
+/** How much memory Polygons use, for each size class of the allocator. Everything is 0
+ *  if the allocator is disabled.
+ */
+struct PolygonAllocatorStats final
+{
+    static constexpr int NUM_CLASSES = 5;
+    struct SizeClass
+    {
+        ///for polygons with up to max_n vertices
+        uint32_t max_n = 0;
+        size_t block_size = 0;
+        ///blocks allocated from the system so far, in use or not
+        size_t num_blocks = 0;
+        int64_t num_live = 0;
+    };
+    std::array<SizeClass, NUM_CLASSES> classes;
+    ///polygons that are too big for any class, which go straight to operator new
+    int64_t num_large_live = 0;
+};
+PolygonAllocatorStats get_polygon_allocator_stats();
+
 /** This is a polygon class that uses AVX2
  *  The first coordinate will be repeated (this saves a mod instruction
  *  when looping over all edges). It's possible, but not guaranteed,
  *  that other coordinates will too. This means that, in a polygon P with
  *  n vertices, P[i] is valid for 0 <= i <= n (note that <= n instead of < n).
+ *  The outward normal of every edge (not normalized) is stored after the vertices, along
+ *  with whether the polygon is convex, so that convex polygons can use the separating
+ *  axis test instead of intersecting every pair of edges.
+ *  Polygons are 32 byte aligned and so is every array of x or y coordinates after them,
+ *  so whole registers can be loaded and stored with aligned instructions.
  */
-class Polygon final
+class alignas(32) Polygon final
 {
     AABB aabb;
     uint32_t n;
+    bool convex;
 
     static uint32_t get_d_len(uint32_t n);
 
@@ -262,8 +290,14 @@ class Polygon final
     void calc_aabb();
     void translate_internal(float dx, float dy);
     void rotate_about_origin_internal(float theta);
+    ///sets the normals and convex from the vertices
+    void calc_normals();
+    ///half of has_collision_sat(): whether some edge of a has all of b on its outer side
+    static bool has_separating_edge(const Polygon &a, const Polygon &b);
 
     inline float *get_verts() const;
+    ///x of the normal of edge i (from vertex i to i+1) is at [i], y is at [d_len + i]
+    inline float *get_normals() const;
 public:
     uint32_t get_num_vertices() const;
     static constexpr size_t offset_of_aabb()
@@ -295,7 +329,42 @@ public:
 
     ///0 <= idx <= n (note the <= n instead of < n)
     _MapCoord<float> get_vertex(size_t idx) const;
+    ///false if the vertices go in both directions, or if there are fewer than 3 of them
+    inline bool is_convex() const
+    {
+        return convex;
+    }
+    /** Uses has_collision_sat() if both polygons are convex, and has_edge_crossing()
+     *  otherwise; the polygons touching doesn't count either way. Note that this means
+     *  one convex polygon being completely inside the other counts, but the same isn't
+     *  true if one of them isn't convex.
+     */
     bool has_collision(const Polygon &other) const;
+    ///checks every edge of this against every edge of other
+    bool has_edge_crossing(const Polygon &other) const;
+    /** Separating axis test, both polygons have to be convex. They overlap unless every
+     *  vertex of one is on the outer side of (or on) the line through some edge of the
+     *  other. Up to 8 edges are tested at once, so for polygons with up to 8 vertices
+     *  this is O(n + m), and there's no division like in has_edge_crossing().
+     */
+    bool has_collision_sat(const Polygon &other) const;
+    /** Bit k of the result is has_collision(*others[k]), for up to 64 others. If this is
+     *  convex and has up to 8 vertices, its edges and vertices are loaded into registers
+     *  once and every other convex polygon's vertices and edges are streamed past them.
+     */
+    uint64_t has_collision_many(kx::kx_span<const Polygon* const> others) const;
+    ///crossing number test; points exactly on an edge can go either way
+    bool contains_point(_MapCoord<float> p) const;
+    ///has_collision(), plus the case where one polygon is completely inside the other even
+    ///if they aren't convex
+    bool has_overlap(const Polygon &other) const;
+    /** Makes this the area convex_shape passes over while it's moved by d (the Minkowski
+     *  sum of convex_shape and the segment from 0 to d). That has 2 more vertices than
+     *  convex_shape: the two vertices where the shape's outline stops facing forward are
+     *  doubled. Returns false and leaves this alone if n isn't convex_shape's n + 2, or if
+     *  d is 0 or the shape is degenerate, so there's nothing to sweep.
+     */
+    bool remake_as_swept(const Polygon &convex_shape, _MapVec<float> d);
 
     inline const AABB &get_AABB() const
     {
@@ -303,6 +372,13 @@ public:
     }
 
     static std::unique_ptr<Polygon> make_with_num_sides(uint32_t num_sides);
+    ///how many bytes a polygon with num_sides vertices takes up
+    static size_t get_size_with_num_sides(uint32_t num_sides);
+    /** Like make_with_num_sides(), but the polygon is put into mem, which has to be at least
+     *  get_size_with_num_sides(num_sides) bytes and aligned like a Polygon. It can't be
+     *  deleted; the memory can just be reused (or freed) when it isn't needed anymore.
+     */
+    static Polygon *make_with_num_sides_at(void *mem, uint32_t num_sides);
     template<class T> static std::unique_ptr<Polygon> make(kx::kx_span<_MapCoord<T>> vertices);
     template<class T> static std::unique_ptr<Polygon> make(const std::vector<T> &coords);
 };
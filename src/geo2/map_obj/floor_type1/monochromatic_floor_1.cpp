@@ -12,28 +12,28 @@ MonochromaticFloor_1::MonochromaticFloor_1(const MapRect &position_,
 {}
 void MonochromaticFloor_1::add_render_ops(const MapObjRenderArgs &args)
 {
-    if(op == nullptr) {
-        op = std::make_shared<RenderOpShader>(*args.shaders->get("monoc_floor_1"));
-        op_group = std::make_shared<RenderOpGroup>(args.get_floor_render_priority());
-        op_group->add_op(op);
-        auto iu_map = op->map_instance_uniform(0);
-        op_iu = {(float*)iu_map.begin(), (float*)iu_map.end()};
-    }
-
-    op_iu[0] = args.x_to_ndc(position.x);
-    op_iu[1] = args.y_to_ndc(position.y);
-    op_iu[2] = args.x_to_ndc(position.x + position.w);
-    op_iu[3] = args.y_to_ndc(position.y + position.h);
+    if(shader == nullptr)
+        shader = args.shaders->get("monoc_floor_1");
 
-    op_iu[4] = color.r;
-    op_iu[5] = color.g;
-    op_iu[6] = color.b;
-    op_iu[7] = color.a;
+    float x1 = args.x_to_ndc(position.x);
+    float y1 = args.y_to_ndc(position.y);
+    float x2 = args.x_to_ndc(position.x + position.w);
+    float y2 = args.y_to_ndc(position.y + position.h);
 
-    if(args.is_x_line_ndc_in_view(op_iu[0], op_iu[2]) &&
-       args.is_y_line_ndc_in_view(op_iu[1], op_iu[3]))
+    if(args.is_x_line_ndc_in_view(x1, x2) &&
+       args.is_y_line_ndc_in_view(y1, y2))
     {
-        args.add_op_group(op_group);
+        args.begin_op_group(args.get_floor_render_priority());
+        auto op_iu = args.add_op(*shader);
+        op_iu[0] = x1;
+        op_iu[1] = y1;
+        op_iu[2] = x2;
+        op_iu[3] = y2;
+
+        op_iu[4] = color.r;
+        op_iu[5] = color.g;
+        op_iu[6] = color.b;
+        op_iu[7] = color.a;
     }
 }
 
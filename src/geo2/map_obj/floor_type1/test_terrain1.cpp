@@ -23,16 +23,14 @@ void TestTerrain1::add_render_ops(const MapObjRenderArgs &args)
     args.rdr->set_color(LinearColor(10 * position.x, 10 * position.y, 0.0, 1.0));
     args.rdr->fill_rect_nc(dst);*/
 
-    if(op == nullptr) {
-        op = std::make_shared<RenderOpShader>(*args.shaders->get("test_terrain_1"));
-        op_group = std::make_shared<RenderOpGroup>(args.get_floor_render_priority());
-        op_group->add_op(op);
-        auto iu_map = op->map_instance_uniform(0);
-        op_iu = {(float*)iu_map.begin(), (float*)iu_map.end()};
-    }
+    if(shader == nullptr)
+        shader = args.shaders->get("test_terrain_1");
 
     Rect dst(position.x, position.y, 1.0f, 1.0f);
 
+    args.begin_op_group(args.get_floor_render_priority());
+    auto op_iu = args.add_op(*shader);
+
     op_iu[0] = args.x_to_ndc(dst.x);
     op_iu[1] = args.y_to_ndc(dst.y);
     op_iu[2] = args.x_to_ndc(dst.x + dst.w);
@@ -41,8 +39,6 @@ void TestTerrain1::add_render_ops(const MapObjRenderArgs &args)
     op_iu[5] = 0.5f;
     op_iu[6] = 0.0f;
     op_iu[7] = 1.0f;
-
-    args.add_op_group(op_group);
 }
 
 }}
@@ -4,6 +4,7 @@
 #include "geo2/render_args.h"
 #include "geo2/ceng1_data.h"
 #include "geo2/ceng1_collision.h"
+#include "geo2/ceng1_contact_table.h"
 #include "geo2/rng_args.h"
 
 #include "kx/fixed_size_array.h"
@@ -43,6 +44,12 @@ public:
     {
         data->set_move_intent(new_intent);
     }
+    ///only call this if the object will always stay at its current position and never
+    ///modify its current position shapes after init()
+    inline void set_static(bool static_obj) const
+    {
+        data->set_static(static_obj);
+    }
     inline void set_ceng_data(CEng1Data *data_)
     {
         data = data_;
@@ -114,14 +121,8 @@ public:
     CEng1DataMutatorAttorney(CEng1DataMutatorAttorney&&) = delete;
     CEng1DataMutatorAttorney & operator = (CEng1DataMutatorAttorney&&) = delete;
 
-    inline void add_current_pos_polygon_with_num_sides(uint32_t num_sides) const
-    {
-        (*ceng_data)[idx].add_current_pos_polygon_with_num_sides(num_sides);
-    }
-    inline void add_desired_pos_polygon_with_num_sides(uint32_t num_sides) const
-    {
-        (*ceng_data)[idx].add_desired_pos_polygon_with_num_sides(num_sides);
-    }
+    //no adding polygons here: objects run in parallel and the polygon arena isn't thread
+    //safe, so shapes can only be added in init() (see MapObjInitArgs)
     inline Polygon *get_sole_current_pos() const
     {
         return (*ceng_data)[idx].get_sole_current_pos();
@@ -187,6 +188,7 @@ class HandleCollisionArgs: public CEng1DataReaderAttorney
     class MapObject *other;
     CEng1Collision collision_info;
     int other_idx;
+    CEng1ContactTable *contact_table;
 
 protected:
     HandleCollisionArgs(const HandleCollisionArgs &other) = default;
@@ -209,6 +211,16 @@ public:
     {
         collision_info = collision_info_;
     }
+    inline void set_contact_table(CEng1ContactTable *contact_table_)
+    {
+        contact_table = contact_table_;
+    }
+    ///see CEng1ContactTable::record_contact(); "this" touched other at cur_level_time
+    inline bool record_contact(double *prev_time) const
+    {
+        return contact_table->record_contact(this_->get_handle(), other->get_handle(),
+                                             cur_level_time, prev_time);
+    }
     inline void set_move_intent(MoveIntent new_intent) const
     {
         (*ceng_data)[idx].set_move_intent(new_intent);
@@ -230,6 +242,27 @@ public:
     }
 };
 
+///a projectile from ProjectileSystem hit the object at idx; projectile hits are resolved
+///serially after the collision engine is done
+class HandleProjectileHitArgs final: public CEng1DataReaderAttorney
+{
+public:
+    double damage;
+    Team team;
+
+    HandleProjectileHitArgs() = default;
+
+    HandleProjectileHitArgs(const HandleProjectileHitArgs&) = delete;
+    HandleProjectileHitArgs & operator = (const HandleProjectileHitArgs&) = delete;
+    HandleProjectileHitArgs(HandleProjectileHitArgs&&) = delete;
+    HandleProjectileHitArgs & operator = (HandleProjectileHitArgs&&) = delete;
+
+    inline void set_move_intent(MoveIntent new_intent) const
+    {
+        (*ceng_data)[idx].set_move_intent(new_intent);
+    }
+};
+
 class MapObjRun3Args final: public CEng1DataReaderAttorney, public MapObjRunArgs, public RNG_Args
 {
 public:
@@ -262,7 +295,7 @@ class EndHandleCollisionBlockArgs final
 
 class MapObjRenderArgs final: public CEng1DataMutatorAttorney, public RenderArgs, public RNG_Args
 {
-    std::vector<std::shared_ptr<RenderOpGroup>> *op_groups;
+    uint64_t render_seq = 0;
 
     /*inline kx::gfx::Rect to_cam_nc(const MapRect &rect) const
     {
@@ -274,6 +307,10 @@ class MapObjRenderArgs final: public CEng1DataMutatorAttorney, public RenderArgs
         return ret;
     }*/
 public:
+    ///how far the frame is between the state before the last tick (0) and the current
+    ///state (1); things that move should be drawn in between
+    double tick_interp;
+
     MapObjRenderArgs() = default;
 
     MapObjRenderArgs(const MapObjRenderArgs&) = delete;
@@ -281,13 +318,15 @@ public:
     MapObjRenderArgs(MapObjRenderArgs&&) = delete;
     MapObjRenderArgs & operator = (MapObjRenderArgs&&) = delete;
 
-    inline void add_op_group(const std::shared_ptr<RenderOpGroup> &op_group) const
+    ///the ops added after this are rendered together, in order, with the given priority
+    inline void begin_op_group(float priority) const
     {
-        op_groups->push_back(op_group);
+        op_arena->begin_group(priority, render_seq);
     }
-    inline void set_op_groups_vec(std::vector<std::shared_ptr<RenderOpGroup>> *op_groups_)
+    ///the render seq of the map object whose ops are being added
+    inline void set_render_seq(uint64_t seq)
     {
-        op_groups = op_groups_;
+        render_seq = seq;
     }
     inline float get_proj_render_priority() const
     {
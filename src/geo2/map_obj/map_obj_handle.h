@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+namespace geo2 { namespace map_obj {
+
+/** Refers to a map object in the level (see MapObjSlotMap). Unlike an index into map_objs,
+ *  a handle stays the same for as long as the object is in the level, and unlike a
+ *  pointer, it never refers to another object after the object is deleted, even if
+ *  the memory or the slot gets reused.
+ *  The low SLOT_BITS bits are the slot and the rest are the slot's generation.
+ */
+class MapObjHandle final
+{
+    uint32_t value;
+public:
+    static constexpr int SLOT_BITS = 20;
+    static constexpr uint32_t MAX_SLOTS = 1u << SLOT_BITS;
+    static constexpr uint32_t MAX_GENERATION = (1u << (32 - SLOT_BITS)) - 1;
+    ///no object ever has this handle
+    static constexpr uint32_t NULL_VALUE = 0xffffffff;
+
+    constexpr MapObjHandle():
+        value(NULL_VALUE)
+    {}
+    constexpr MapObjHandle(uint32_t slot, uint32_t generation):
+        value((generation << SLOT_BITS) | slot)
+    {}
+
+    inline uint32_t get_slot() const
+    {
+        return value & (MAX_SLOTS - 1);
+    }
+    inline uint32_t get_generation() const
+    {
+        return value >> SLOT_BITS;
+    }
+    inline uint32_t get_value() const
+    {
+        return value;
+    }
+    inline bool is_null() const
+    {
+        return value == NULL_VALUE;
+    }
+
+    inline bool operator == (MapObjHandle other) const
+    {
+        return value == other.value;
+    }
+    inline bool operator != (MapObjHandle other) const
+    {
+        return value != other.value;
+    }
+    inline bool operator < (MapObjHandle other) const
+    {
+        return value < other.value;
+    }
+};
+
+}}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "geo2/map_obj/map_object.h"
+#include "geo2/map_obj/floor_type1/monochromatic_floor_1.h"
+#include "geo2/map_obj/floor_type1/test_terrain1.h"
+#include "geo2/map_obj/wall_type1/monochromatic_wall_1.h"
+#include "geo2/map_obj/unit/hexfly_1.h"
+#include "geo2/map_obj/unit/pig_1.h"
+#include "geo2/map_obj/unit/player_type1.h"
+#include "geo2/map_obj/unit/spotted_pig_1.h"
+
+#include <type_traits>
+
+namespace geo2 { namespace map_obj {
+
+template<class... Ts> struct MapObjTypeList
+{
+    static constexpr int size = sizeof...(Ts);
+};
+
+/** The concrete map object types that Game updates without virtual calls. They have to
+ *  be final, so calls through a T* are statically dispatched. Objects of any other type
+ *  still work; they're updated through virtual calls, and whether they're render-only is
+ *  checked at run time like before (only with GCC; otherwise they're always simulated).
+ */
+using ConcreteMapObjTypes = MapObjTypeList<Player_Type1,
+                                           Hexfly_1,
+                                           Pig_1,
+                                           Spotted_Pig_1,
+                                           MonochromaticWall_1,
+                                           MonochromaticFloor_1,
+                                           TestTerrain1>;
+
+//&T::f has type void (MapObject::*)(...) iff neither T nor any class in between overrides f
+template<class T> constexpr bool overrides_init =
+    !std::is_same_v<decltype(&T::init), void (MapObject::*)(const MapObjInitArgs&)>;
+template<class T> constexpr bool overrides_run1_mt =
+    !std::is_same_v<decltype(&T::run1_mt), void (MapObject::*)(const MapObjRun1Args&)>;
+template<class T> constexpr bool overrides_run3_mt =
+    !std::is_same_v<decltype(&T::run3_mt), void (MapObject::*)(const MapObjRun3Args&)>;
+
+//for MapObjTypeBuckets
+template<class T> struct OverridesRun1Mt: std::bool_constant<overrides_run1_mt<T>> {};
+template<class T> struct OverridesRun3Mt: std::bool_constant<overrides_run3_mt<T>> {};
+
+///objects that don't do anything except render don't have to be simulated at all
+template<class T> constexpr bool is_gfx_only =
+    !overrides_init<T> && !overrides_run1_mt<T> && !overrides_run3_mt<T>;
+
+}}
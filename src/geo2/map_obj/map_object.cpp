@@ -18,7 +18,15 @@ void MapObject::add_render_ops([[maybe_unused]] const MapObjRenderArgs &args)
 {}
 void MapObject::end_handle_collision_block([[maybe_unused]] const EndHandleCollisionBlockArgs &args)
 {}
+bool MapObject::handle_projectile_hit([[maybe_unused]] const HandleProjectileHitArgs &args)
+{
+    return false;
+}
 
+CEng1CollisionFilter MapObject::get_collision_filter() const
+{
+    return CEng1CollisionFilter();
+}
 bool MapObject::collision_could_matter([[maybe_unused]] const MapObject &other) const
 {
     return true;
@@ -34,6 +42,10 @@ Team MapObject::get_team() const
 }
 
 //CosmeticMapObj
+CEng1CollisionFilter CosmeticMapObj::get_collision_filter() const
+{
+    return CEng1CollisionFilter(CEng1CollisionFilter::LAYER_COSMETIC, CEng1CollisionFilter::ALL_LAYERS);
+}
 void CosmeticMapObj::handle_collision(MapObject *other, const HandleCollisionArgs &args)
 {
     other->handle_collision(this, args);
@@ -1,6 +1,14 @@
 #pragma once
 
+#include "geo2/ceng1_collision_filter.h"
 #include "geo2/geometry.h"
+#include "geo2/map_obj/map_obj_handle.h"
+
+#include "kx/util.h"
+
+#include <cstdint>
+
+namespace geo2 {class Game; class MapObjSlotMap;}
 
 namespace geo2 { namespace map_obj {
 
@@ -19,12 +27,15 @@ class MapObjRun3Args;
 class MapObjRenderArgs;
 class HandleCollisionArgs;
 class EndHandleCollisionBlockArgs;
+class HandleProjectileHitArgs;
 
 #define HANDLE_COLLISION_FUNC_DECLARATION(T) \
     void handle_collision(class T *other, const HandleCollisionArgs &args)
 
 class MapObject
 {
+    MapObjHandle handle;
+    uint64_t render_seq = 0;
 public:
     MapObject() = default;
 
@@ -44,6 +55,11 @@ public:
     virtual void run3_mt(const MapObjRun3Args &args);
     virtual void add_render_ops(const MapObjRenderArgs &args);
 
+    ///called once before init(); the default filter collides with everything
+    virtual CEng1CollisionFilter get_collision_filter() const;
+    ///only called if the filter has CEng1CollisionFilter::CUSTOM_CHECK set, so this is
+    ///the slow path for when layers aren't enough; it can be called while collisions are
+    ///being handled, so it shouldn't depend on anything handle_collision changes;
     ///default return value = true
     virtual bool collision_could_matter(const MapObject &other) const;
 
@@ -52,7 +68,10 @@ public:
      *  double dispatch.
      */
     virtual void handle_collision(MapObject *other, const HandleCollisionArgs &args) = 0;
-    ///for the below functions, "this" handles the collision and reports its intent
+    /** For the below functions, "this" handles the collision and reports its intent.
+     *  Collisions that don't share an object can be handled in parallel, so these may only
+     *  change "this" and "other", and they must not change static objects at all.
+     */
     virtual HANDLE_COLLISION_FUNC_DECLARATION(CosmeticMapObj);
     virtual HANDLE_COLLISION_FUNC_DECLARATION(Wall_Type1) = 0;
     virtual HANDLE_COLLISION_FUNC_DECLARATION(Unit) = 0;
@@ -60,7 +79,31 @@ public:
 
     virtual void end_handle_collision_block(const EndHandleCollisionBlockArgs &args);
 
+    ///called when a projectile from ProjectileSystem overlaps this; returns whether the
+    ///projectile is used up; default return value = false (the projectile goes through)
+    virtual bool handle_projectile_hit(const HandleProjectileHitArgs &args);
+
     virtual Team get_team() const;
+
+    ///null until this is added to the level
+    inline MapObjHandle get_handle() const
+    {
+        return handle;
+    }
+    inline void set_handle(MapObjHandle handle_, kx::Passkey<MapObjSlotMap>)
+    {
+        handle = handle_;
+    }
+    ///when this was added to the level relative to the other map objects; render op
+    ///groups with the same priority and shader are rendered in this order
+    inline uint64_t get_render_seq() const
+    {
+        return render_seq;
+    }
+    inline void set_render_seq(uint64_t seq, kx::Passkey<Game>)
+    {
+        render_seq = seq;
+    }
 };
 
 /** Note that cosmetic map objects CAN collide with things; it's just that something
@@ -69,6 +112,9 @@ public:
  */
 class CosmeticMapObj: public MapObject
 {
+public:
+    CEng1CollisionFilter get_collision_filter() const override;
+private:
     void handle_collision(MapObject *other, const HandleCollisionArgs &args) override;
     HANDLE_COLLISION_FUNC_DECLARATION(Wall_Type1) override;
     HANDLE_COLLISION_FUNC_DECLARATION(Unit) override;
@@ -4,7 +4,7 @@
 
 namespace geo2 { namespace map_obj {
 
-BasicProj_1::BasicProj_1(const std::shared_ptr<MapObject> &owner_,
+BasicProj_1::BasicProj_1(const MapObject &owner_,
                          double damage_,
                          double lifespan_,
                          MapCoord pos_,
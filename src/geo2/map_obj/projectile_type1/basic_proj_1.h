@@ -13,7 +13,7 @@ protected:
     MapCoord desired_position;
     MapVec velocity;
 
-    BasicProj_1(const std::shared_ptr<MapObject> &owner_,
+    BasicProj_1(const MapObject &owner_,
                 double damage_,
                 double lifespan_,
                 MapCoord pos_,
@@ -4,10 +4,11 @@
 
 namespace geo2 { namespace map_obj {
 
-Projectile_Type1::Projectile_Type1(const std::shared_ptr<MapObject> &owner_):
-    owner(owner_),
-    team(owner_->get_team())
+Projectile_Type1::Projectile_Type1(const MapObject &owner_):
+    owner(owner_.get_handle()),
+    team(owner_.get_team())
 {
+    k_expects(!owner.is_null());
     k_expects(team != Team::NotSet);
 }
 
@@ -40,6 +41,12 @@ void Projectile_Type1::end_handle_collision_block([[maybe_unused]] const EndHand
 {
     alive_status.end_current_time_block();
 }
+CEng1CollisionFilter Projectile_Type1::get_collision_filter() const
+{
+    //projectiles go through each other
+    return CEng1CollisionFilter(CEng1CollisionFilter::LAYER_PROJECTILE,
+                                CEng1CollisionFilter::LAYER_WALL | CEng1CollisionFilter::LAYER_UNIT);
+}
 bool Projectile_Type1::is_dead() const
 {
     return alive_status.is_dead();
@@ -8,11 +8,12 @@ namespace geo2 { namespace map_obj {
 class Projectile_Type1: public MapObject
 {
 protected:
-    std::weak_ptr<MapObject> owner;
+    MapObjHandle owner;
     Team team;
     AliveStatus alive_status;
 
-    Projectile_Type1(const std::shared_ptr<MapObject> &owner_);
+    ///owner_ has to be in the level already
+    Projectile_Type1(const MapObject &owner_);
 public:
     virtual ~Projectile_Type1() = default;
 
@@ -22,6 +23,7 @@ public:
     HANDLE_COLLISION_FUNC_DECLARATION(Projectile_Type1) override;
 
     void end_handle_collision_block(const EndHandleCollisionBlockArgs &args) override;
+    CEng1CollisionFilter get_collision_filter() const override;
 
     bool is_dead() const;
     Team get_team() const override;
@@ -53,6 +53,8 @@ constexpr double MAX_ANGULAR_ACCEL = 40;
 
 void Hexfly_1::run1_mt([[maybe_unused]] const MapObjRun1Args &args)
 {
+    save_prev_position();
+
     if(alive_status.is_dead()) {
         if(is_completely_faded_out(args.cur_level_time))
             args.delete_me();
@@ -107,14 +109,10 @@ void Hexfly_1::run3_mt([[maybe_unused]] const MapObjRun3Args &args)
 
 void Hexfly_1::add_render_ops(const MapObjRenderArgs &args)
 {
-    if(op_group == nullptr) {
-        op_group = std::make_shared<RenderOpGroup>(args.get_NPC_render_priority());
-        for(int i=0; i<8; i++) {
-            ops[i] = std::make_shared<RenderOpShader>(*args.shaders->get("hexfly_1"));
-            op_group->add_op(ops[i]);
-            auto iu_map = ops[i]->map_instance_uniform(0);
-            op_ius[i] = {(float*)iu_map.begin(), (float*)iu_map.end()};
-        }
+    auto render_position = get_interpolated_position(args.tick_interp);
+
+    if(shader == nullptr) {
+        shader = args.shaders->get("hexfly_1");
 
         //no borders yet
         for(int i=0; i<6; i++) {
@@ -142,10 +140,10 @@ void Hexfly_1::add_render_ops(const MapObjRenderArgs &args)
 
         auto cur_shape = base_shape->copy();
         cur_shape->rotate_about_origin_and_translate(movement_algo.get_current_angle(),
-                                                     current_position - MapCoord::ORIGIN);
+                                                     render_position - MapCoord::ORIGIN);
         for(int i=0; i<6; i++) {
-            op_ius[i][0] = args.x_to_ndc(current_position.x);
-            op_ius[i][1] = args.y_to_ndc(current_position.y);
+            op_ius[i][0] = args.x_to_ndc(render_position.x);
+            op_ius[i][1] = args.y_to_ndc(render_position.y);
             auto v1 = cur_shape->get_vertex(i);
             auto v2 = cur_shape->get_vertex(i+1);
             op_ius[i][2] = args.x_to_ndc(v1.x);
@@ -180,9 +178,9 @@ void Hexfly_1::add_render_ops(const MapObjRenderArgs &args)
             auto v1 = v0 + wing_rot_mat * d_v0_v1;
             auto v2 = v0 + wing_rot_mat * d_v0_v2;
 
-            auto v0_rot = current_position + rot_mat * v0;
-            auto v1_rot = current_position + rot_mat * v1;
-            auto v2_rot = current_position + rot_mat * v2;
+            auto v0_rot = render_position + rot_mat * v0;
+            auto v1_rot = render_position + rot_mat * v1;
+            auto v2_rot = render_position + rot_mat * v2;
 
             op_ius[i][0] = args.x_to_ndc(v0_rot.x);
             op_ius[i][1] = args.y_to_ndc(v0_rot.y);
@@ -197,7 +195,9 @@ void Hexfly_1::add_render_ops(const MapObjRenderArgs &args)
         }
     }
 
-    args.add_op_group(op_group);
+    args.begin_op_group(args.get_NPC_render_priority());
+    for(const auto &op_iu: op_ius)
+        args.add_op(*shader, op_iu);
 }
 double Hexfly_1::get_collision_damage() const
 {
@@ -16,9 +16,8 @@ class Hexfly_1 final: public Unit
     float side_len;
     double wing_freq;
 
-    std::array<std::shared_ptr<RenderOpShader>, 8> ops;
-    std::array<kx::kx_span<float>, 8> op_ius;
-    std::shared_ptr<RenderOpGroup> op_group;
+    const IShader *shader = nullptr;
+    std::array<std::array<float, 24>, 8> op_ius{};
 
     float eye_w;
     float eye_h;
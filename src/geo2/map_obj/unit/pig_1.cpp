@@ -67,6 +67,8 @@ constexpr double MAX_ANGULAR_ACCEL = 40;
 
 void Pig_1::run1_mt([[maybe_unused]] const MapObjRun1Args &args)
 {
+    save_prev_position();
+
     if(alive_status.is_dead()) {
         if(is_completely_faded_out(args.cur_level_time))
             args.delete_me();
@@ -121,14 +123,10 @@ void Pig_1::run3_mt([[maybe_unused]] const MapObjRun3Args &args)
 
 void Pig_1::add_render_ops(const MapObjRenderArgs &args)
 {
-    if(op_group == nullptr) {
-        op_group = std::make_shared<RenderOpGroup>(args.get_NPC_render_priority());
-        for(int i=0; i<5; i++) {
-            ops[i] = std::make_shared<RenderOpShader>(*args.shaders->get("pig_1"));
-            op_group->add_op(ops[i]);
-            auto iu_map = ops[i]->map_instance_uniform(0);
-            op_ius[i] = {(float*)iu_map.begin(), (float*)iu_map.end()};
-        }
+    auto render_position = get_interpolated_position(args.tick_interp);
+
+    if(shader == nullptr) {
+        shader = args.shaders->get("pig_1");
 
         auto adjusted_border_thickness = args.to_whole_pixels(BORDER_THICKNESS);
 
@@ -167,9 +165,9 @@ void Pig_1::add_render_ops(const MapObjRenderArgs &args)
 
     auto rot_mat = Matrix2::make_rotation_matrix(movement_algo.get_current_angle());
     for(int i=0; i<=2; i++) {
-        auto v0_rot = current_position + rot_mat * (v0[i]);
-        auto v1_rot = current_position + rot_mat * (v0[i] + MapVec(PART_W[i], 0));
-        auto v2_rot = current_position + rot_mat * (v0[i] + MapVec(0, PART_H[i]));
+        auto v0_rot = render_position + rot_mat * (v0[i]);
+        auto v1_rot = render_position + rot_mat * (v0[i] + MapVec(PART_W[i], 0));
+        auto v2_rot = render_position + rot_mat * (v0[i] + MapVec(0, PART_H[i]));
 
         op_ius[i][0] = args.x_to_ndc(v0_rot.x);
         op_ius[i][1] = args.y_to_ndc(v0_rot.y);
@@ -182,9 +180,9 @@ void Pig_1::add_render_ops(const MapObjRenderArgs &args)
     //upper eye
     {
         MapVec eye_v0(X_BEGIN + PART_W[0] + eye_x_offset, -eye_y_offset);
-        auto v0_rot = current_position + rot_mat * (eye_v0);
-        auto v1_rot = current_position + rot_mat * (eye_v0 + MapVec(eye_w, 0));
-        auto v2_rot = current_position + rot_mat * (eye_v0 + MapVec(0, -eye_h));
+        auto v0_rot = render_position + rot_mat * (eye_v0);
+        auto v1_rot = render_position + rot_mat * (eye_v0 + MapVec(eye_w, 0));
+        auto v2_rot = render_position + rot_mat * (eye_v0 + MapVec(0, -eye_h));
 
         op_ius[3][0] = args.x_to_ndc(v0_rot.x);
         op_ius[3][1] = args.y_to_ndc(v0_rot.y);
@@ -197,9 +195,9 @@ void Pig_1::add_render_ops(const MapObjRenderArgs &args)
     //lower eye
     {
         MapVec eye_v0(X_BEGIN + PART_W[0] + eye_x_offset, eye_y_offset);
-        auto v0_rot = current_position + rot_mat * (eye_v0);
-        auto v1_rot = current_position + rot_mat * (eye_v0 + MapVec(eye_w, 0));
-        auto v2_rot = current_position + rot_mat * (eye_v0 + MapVec(0, eye_h));
+        auto v0_rot = render_position + rot_mat * (eye_v0);
+        auto v1_rot = render_position + rot_mat * (eye_v0 + MapVec(eye_w, 0));
+        auto v2_rot = render_position + rot_mat * (eye_v0 + MapVec(0, eye_h));
 
         op_ius[4][0] = args.x_to_ndc(v0_rot.x);
         op_ius[4][1] = args.y_to_ndc(v0_rot.y);
@@ -216,7 +214,9 @@ void Pig_1::add_render_ops(const MapObjRenderArgs &args)
         *reinterpret_cast<kx::gfx::LinearColor*>(&op_ius[i][16]) = border_color;
     }
 
-    args.add_op_group(op_group);
+    args.begin_op_group(args.get_NPC_render_priority());
+    for(const auto &op_iu: op_ius)
+        args.add_op(*shader, op_iu);
 }
 double Pig_1::get_collision_damage() const
 {
@@ -14,9 +14,8 @@ class Pig_1 final: public Unit
 {
     unit_movement::Algo1 movement_algo;
 
-    std::array<std::shared_ptr<RenderOpShader>, 5> ops;
-    std::array<kx::kx_span<float>, 5> op_ius;
-    std::shared_ptr<RenderOpGroup> op_group;
+    const IShader *shader = nullptr;
+    std::array<std::array<float, 20>, 5> op_ius{};
 
     float eye_w;
     float eye_h;
@@ -21,6 +21,7 @@ Player_Type1::Player_Type1():
 void Player_Type1::start_new_level(MapCoord pos, kx::Passkey<Game>)
 {
     current_position = pos;
+    prev_position = pos;
     weapons[cur_weapon_idx]->start_new_level({});
 }
 void Player_Type1::run_special(const PlayerRunSpecialArgs &args, kx::Passkey<Game>)
@@ -183,6 +184,8 @@ void Player_Type1::init([[maybe_unused]] const MapObjInitArgs &args)
 constexpr double PLAYER_SIDE_LEN = 1.6;
 void Player_Type1::run1_mt(const MapObjRun1Args &args)
 {
+    save_prev_position();
+
     constexpr auto PSL = PLAYER_SIDE_LEN;
 
     MapCoord cur_v[]{{current_position.x - 0.5*PSL, current_position.y - 0.5*PSL},
@@ -224,14 +227,10 @@ const LinearColor DEFAULT_OUTSIDE_COLOR(0.05f, 0.05f, 0.05f, 0.9f);
 
 void Player_Type1::add_render_ops(const MapObjRenderArgs &args)
 {
-    if(op1 == nullptr) {
-        op_group = std::make_shared<RenderOpGroup>(args.get_player_render_priority());
-        op1 = std::make_shared<RenderOpShader>(*args.shaders->get("outlined_tri"));
-        op2 = std::make_shared<RenderOpShader>(*args.shaders->get("outlined_tri"));
-        auto iu_map = op1->map_instance_uniform(0);
-        op_iu1 = {(float*)iu_map.begin(), (float*)iu_map.end()};
-        iu_map = op2->map_instance_uniform(0);
-        op_iu2 = {(float*)iu_map.begin(), (float*)iu_map.end()};
+    auto render_position = get_interpolated_position(args.tick_interp);
+
+    if(shader == nullptr) {
+        shader = args.shaders->get("outlined_tri");
 
         float BORDER_SIZE = args.to_whole_pixels(0.07f * PLAYER_SIDE_LEN) / PLAYER_SIDE_LEN;
 
@@ -251,29 +250,28 @@ void Player_Type1::add_render_ops(const MapObjRenderArgs &args)
     *reinterpret_cast<LinearColor*>(&op_iu2[12]) = inside_color;
     *reinterpret_cast<LinearColor*>(&op_iu2[16]) = outside_color;
 
-    op_iu1[0] = args.x_to_ndc(current_position.x - 0.5*PLAYER_SIDE_LEN);
-    op_iu1[1] = args.y_to_ndc(current_position.y + 0.5*PLAYER_SIDE_LEN);
-    op_iu1[2] = args.x_to_ndc(current_position.x - 0.5*PLAYER_SIDE_LEN);
-    op_iu1[3] = args.y_to_ndc(current_position.y - 0.5*PLAYER_SIDE_LEN);
-    op_iu1[4] = args.x_to_ndc(current_position.x + 0.5*PLAYER_SIDE_LEN);
-    op_iu1[5] = args.y_to_ndc(current_position.y - 0.5*PLAYER_SIDE_LEN);
+    op_iu1[0] = args.x_to_ndc(render_position.x - 0.5*PLAYER_SIDE_LEN);
+    op_iu1[1] = args.y_to_ndc(render_position.y + 0.5*PLAYER_SIDE_LEN);
+    op_iu1[2] = args.x_to_ndc(render_position.x - 0.5*PLAYER_SIDE_LEN);
+    op_iu1[3] = args.y_to_ndc(render_position.y - 0.5*PLAYER_SIDE_LEN);
+    op_iu1[4] = args.x_to_ndc(render_position.x + 0.5*PLAYER_SIDE_LEN);
+    op_iu1[5] = args.y_to_ndc(render_position.y - 0.5*PLAYER_SIDE_LEN);
 
     op_iu2[0] = op_iu1[0];
     op_iu2[1] = op_iu1[1];
-    op_iu2[2] = args.x_to_ndc(current_position.x + 0.5*PLAYER_SIDE_LEN);
-    op_iu2[3] = args.y_to_ndc(current_position.y + 0.5*PLAYER_SIDE_LEN);
+    op_iu2[2] = args.x_to_ndc(render_position.x + 0.5*PLAYER_SIDE_LEN);
+    op_iu2[3] = args.y_to_ndc(render_position.y + 0.5*PLAYER_SIDE_LEN);
     op_iu2[4] = op_iu1[4];
     op_iu2[5] = op_iu1[5];
 
-    args.add_op_group(op_group);
-    op_group->clear();
-    op_group->add_op(op1);
-    op_group->add_op(op2);
+    args.begin_op_group(args.get_player_render_priority());
+    args.add_op(*shader, op_iu1);
+    args.add_op(*shader, op_iu2);
 
     weapon::WeaponRenderArgs weapon_render_args;
     weapon_render_args.set_render_args((RenderArgs)args);
-    weapon_render_args.set_op_group(op_group.get());
     weapon_render_args.angle = weapon_angle;
+    weapon_render_args.owner_position = render_position;
     weapon_render_args.render_priority = args.get_player_render_priority();
 
     weapons[cur_weapon_idx]->render(weapon_render_args);
@@ -3,7 +3,9 @@
 #include "geo2/map_obj/unit/unit.h"
 #include "geo2/weapon/weapon.h"
 
-namespace geo2 {class RenderOpGroup; class RenderOpShader; class Game;}
+#include <array>
+
+namespace geo2 {class IShader; class Game;}
 
 namespace geo2 { namespace map_obj {
 
@@ -32,11 +34,9 @@ class Player_Type1 final:
     int up_pressed_tick_count;
     int down_pressed_tick_count;
 
-    std::shared_ptr<RenderOpShader> op1;
-    std::shared_ptr<RenderOpShader> op2;
-    std::shared_ptr<RenderOpGroup> op_group;
-    kx::kx_span<float> op_iu1;
-    kx::kx_span<float> op_iu2;
+    const IShader *shader = nullptr;
+    std::array<float, 20> op_iu1{};
+    std::array<float, 20> op_iu2{};
 
     double weapon_angle;
     double max_mana;
@@ -34,6 +34,7 @@ LinearColor Unit::apply_color_mod(const LinearColor &color, double cur_level_tim
 Unit::Unit(Team team_, MapCoord position_, double health_):
     last_damaged_at_time(-1e9),
     current_position(position_),
+    prev_position(position_),
     team(team_),
     max_health(health_),
     health(health_)
@@ -57,14 +58,14 @@ void Unit::handle_unit_collision(Unit *other, const HandleUnitCollisionArgs &arg
     if(!are_enemies(team, other->get_team()))
         return;
 
-    auto other_in_map = last_collision_damage_time.find(other);
-    if(other_in_map == last_collision_damage_time.end()) {
-        last_collision_damage_time.emplace(other, args.cur_level_time);
+    //the first contact does full damage, and after that the damage is per second of contact
+    //(up to COLLISION_DAMAGE_COLOR_LEN seconds' worth, however long the units were apart)
+    double prev_time;
+    if(!args.record_contact(&prev_time))
         health -= other->get_collision_damage();
-    } else {
+    else {
         health -= other->get_collision_damage() *
-                  std::min(COLLISION_DAMAGE_COLOR_LEN, args.cur_level_time - other_in_map->second);
-        other_in_map->second = args.cur_level_time;
+                  std::min(COLLISION_DAMAGE_COLOR_LEN, args.cur_level_time - prev_time);
     }
 
     if(other->get_collision_damage() > 0) {
@@ -139,6 +140,28 @@ void Unit::end_handle_collision_block([[maybe_unused]] const EndHandleCollisionB
 {
     alive_status.end_current_time_block();
 }
+bool Unit::handle_projectile_hit(const HandleProjectileHitArgs &args)
+{
+    if(is_dead() || !are_enemies(get_team(), args.team))
+        return false;
+
+    if(args.damage > 0) {
+        health -= args.damage;
+        last_damaged_at_time = args.cur_level_time;
+
+        //this isn't in a collision block, so there's no JustDied step
+        if(health <= 0) {
+            alive_status.set_status_to_dead();
+            death_time = args.cur_level_time;
+            args.set_move_intent(MoveIntent::RemoveShapes);
+        }
+    }
+    return true;
+}
+CEng1CollisionFilter Unit::get_collision_filter() const
+{
+    return CEng1CollisionFilter(CEng1CollisionFilter::LAYER_UNIT, CEng1CollisionFilter::ALL_LAYERS);
+}
 double Unit::get_collision_damage() const
 {
     return 0;
@@ -6,13 +6,10 @@
 
 #include "kx/gfx/renderer_types.h"
 
-#include <map>
-
 namespace geo2 { namespace map_obj {
 
 class Unit: public MapObject
 {
-    std::map<Unit*, double> last_collision_damage_time;
     double last_damaged_at_time;
 protected:
     //make ctors explicit to prevent accidental implicit casts from HandleCollisionArgs
@@ -46,6 +43,8 @@ protected:
     };
 
     MapCoord current_position;
+    ///where the unit was at the start of the last tick, for rendering between ticks
+    MapCoord prev_position;
     Team team;
     AliveStatus alive_status;
     double max_health;
@@ -55,6 +54,12 @@ protected:
     kx::gfx::LinearColor apply_color_mod(const kx::gfx::LinearColor &color,
                                          double cur_level_time) const;
 
+    ///call this at the start of run1_mt(), before current_position can change
+    inline void save_prev_position()
+    {
+        prev_position = current_position;
+    }
+
     void handle_wall_collision(Wall_Type1 *other, const HandleWallCollisionArgs &args);
     void handle_unit_collision(Unit *other, const HandleUnitCollisionArgs &args);
     void handle_proj_collision(Projectile_Type1 *other, const HandleProjCollisionArgs &args);
@@ -77,10 +82,17 @@ public:
     HANDLE_COLLISION_FUNC_DECLARATION(Projectile_Type1) override;
 
     void end_handle_collision_block(const EndHandleCollisionBlockArgs &args) override;
+    bool handle_projectile_hit(const HandleProjectileHitArgs &args) override;
+    CEng1CollisionFilter get_collision_filter() const override;
 
     virtual double get_collision_damage() const; ///defaults to 0
 
     MapCoord get_position() const;
+    ///interp = 0 is the start of the last tick, and interp = 1 is now
+    inline MapCoord get_interpolated_position(double interp) const
+    {
+        return prev_position + (current_position - prev_position) * interp;
+    }
     bool is_dead() const;
     bool is_completely_faded_out(double cur_level_time) const;
 
@@ -15,11 +15,18 @@ void Wall_Type1::init(const MapObjInitArgs &args)
     auto polygon_this = Polygon::make(kx::kx_span<MapCoord>(std::begin(verts), std::end(verts)));
     args.add_current_pos_polygon_with_num_sides(4);
     args.get_sole_current_pos()->copy_from(*polygon_this);
+    args.set_static(true);
 }
 void Wall_Type1::run1_mt(const MapObjRun1Args &args)
 {
     args.set_move_intent(MoveIntent::StayAtCurrentPos);
 }
+CEng1CollisionFilter Wall_Type1::get_collision_filter() const
+{
+    //walls don't move, so they don't care about other walls
+    return CEng1CollisionFilter(CEng1CollisionFilter::LAYER_WALL,
+                                CEng1CollisionFilter::LAYER_UNIT | CEng1CollisionFilter::LAYER_PROJECTILE);
+}
 void Wall_Type1::handle_collision(MapObject *other, const HandleCollisionArgs &args)
 {
     other->handle_collision(this, args);
@@ -27,17 +34,23 @@ void Wall_Type1::handle_collision(MapObject *other, const HandleCollisionArgs &a
 void Wall_Type1::handle_collision([[maybe_unused]] Wall_Type1 *other,
                                         [[maybe_unused]] const HandleCollisionArgs &args)
 {
-    args.set_move_intent(MoveIntent::StayAtCurrentPos);
+    //walls are static, so they're always at StayAtCurrentPos already; don't write it
+    //again, since collisions with the same wall can be handled in parallel
 }
 void Wall_Type1::handle_collision([[maybe_unused]] Unit *other,
                                         [[maybe_unused]] const HandleCollisionArgs &args)
 {
-    args.set_move_intent(MoveIntent::StayAtCurrentPos);
+
 }
 void Wall_Type1::handle_collision([[maybe_unused]] Projectile_Type1 *other,
                                         [[maybe_unused]] const HandleCollisionArgs &args)
 {
-    args.set_move_intent(MoveIntent::StayAtCurrentPos);
+
+}
+bool Wall_Type1::handle_projectile_hit([[maybe_unused]] const HandleProjectileHitArgs &args)
+{
+    //walls stop every projectile
+    return true;
 }
 
 }}
@@ -15,11 +15,14 @@ public:
     virtual ~Wall_Type1() = default;
     void init(const MapObjInitArgs &args) override;
     void run1_mt(const MapObjRun1Args &args) override;
+    CEng1CollisionFilter get_collision_filter() const override final;
 
     void handle_collision(MapObject *other, const HandleCollisionArgs &args) override final;
     HANDLE_COLLISION_FUNC_DECLARATION(Wall_Type1) override final;
     HANDLE_COLLISION_FUNC_DECLARATION(Unit) override final;
     HANDLE_COLLISION_FUNC_DECLARATION(Projectile_Type1) override final;
+
+    bool handle_projectile_hit(const HandleProjectileHitArgs &args) override final;
 };
 
 }}
@@ -0,0 +1,68 @@
+#include "geo2/map_obj_slot_map.h"
+#include "geo2/map_obj/map_object.h"
+
+#include "kx/debug.h"
+
+namespace geo2 {
+
+using map_obj::MapObjHandle;
+
+void MapObjSlotMap::free_slot(uint32_t slot)
+{
+    slots[slot].obj = nullptr;
+    slots[slot].idx = -1;
+    //retired slots aren't put back, so their last handle can't come back either
+    if(slots[slot].generation + 1 < MapObjHandle::MAX_GENERATION) {
+        slots[slot].generation++;
+        free_slots.push_back(slot);
+    }
+}
+void MapObjSlotMap::clear()
+{
+    //the slots are kept, so handles from the previous level don't alias new objects
+    for(auto handle: handles)
+        free_slot(handle.get_slot());
+    objs.clear();
+    handles.clear();
+}
+MapObjHandle MapObjSlotMap::insert(std::shared_ptr<map_obj::MapObject> obj)
+{
+    k_expects(obj != nullptr);
+
+    uint32_t slot;
+    if(!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    } else {
+        k_assert(slots.size() < MapObjHandle::MAX_SLOTS);
+        slot = slots.size();
+        slots.push_back(Slot{nullptr, 0, -1});
+    }
+
+    MapObjHandle handle(slot, slots[slot].generation);
+    obj->set_handle(handle, {});
+    objs.push_back(obj.get());
+    handles.push_back(handle);
+    slots[slot].obj = std::move(obj);
+    slots[slot].idx = objs.size() - 1;
+    return handle;
+}
+void MapObjSlotMap::erase(const std::vector<int> &deleted_idx, const std::vector<CEng1IdxMove> &moves)
+{
+    if(deleted_idx.empty())
+        return;
+
+    k_expects(deleted_idx.back() < (int)objs.size());
+
+    for(int idx: deleted_idx)
+        free_slot(handles[idx].get_slot());
+    for(auto move: moves) {
+        objs[move.to] = objs[move.from];
+        handles[move.to] = handles[move.from];
+        slots[handles[move.to].get_slot()].idx = move.to;
+    }
+    objs.resize(objs.size() - deleted_idx.size());
+    handles.resize(objs.size());
+}
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "geo2/ceng1_broadphase.h"
+#include "geo2/map_obj/map_obj_handle.h"
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace geo2 {
+
+namespace map_obj {class MapObject;}
+
+/** Owns the map objects in the level. They're stored densely as plain pointers, in the
+ *  same order as ceng_data, so the hot loops don't touch any reference counts, and every
+ *  object also gets a slot whose handle stays valid until the object is deleted.
+ *  Slots are reused after their generation is bumped; a slot whose generation runs out is
+ *  never used again, so a handle can't ever refer to the wrong object.
+ */
+class MapObjSlotMap final
+{
+    struct Slot
+    {
+        std::shared_ptr<map_obj::MapObject> obj; //null if the slot is free
+        uint32_t generation;
+        int idx; //index of obj in objs
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> free_slots;
+    std::vector<map_obj::MapObject*> objs;
+    std::vector<map_obj::MapObjHandle> handles; //handles[i] belongs to objs[i]
+
+    void free_slot(uint32_t slot);
+public:
+    MapObjSlotMap() = default;
+
+    ///nonmovable because the collision engine holds a pointer to get_objs()
+    MapObjSlotMap(MapObjSlotMap&&) = delete;
+    MapObjSlotMap &operator = (MapObjSlotMap&&) = delete;
+
+    inline size_t size() const
+    {
+        return objs.size();
+    }
+    inline bool empty() const
+    {
+        return objs.empty();
+    }
+    inline map_obj::MapObject *operator [] (size_t idx) const
+    {
+        return objs[idx];
+    }
+    inline const std::vector<map_obj::MapObject*> &get_objs() const
+    {
+        return objs;
+    }
+    inline map_obj::MapObjHandle get_handle(size_t idx) const
+    {
+        return handles[idx];
+    }
+    ///returns -1 if the object was deleted
+    inline int get_idx(map_obj::MapObjHandle handle) const
+    {
+        if(handle.is_null() || handle.get_slot() >= slots.size())
+            return -1;
+        const auto &slot = slots[handle.get_slot()];
+        if(slot.generation != handle.get_generation() || slot.obj == nullptr)
+            return -1;
+        return slot.idx;
+    }
+    ///returns nullptr if the object was deleted
+    inline map_obj::MapObject *get(map_obj::MapObjHandle handle) const
+    {
+        int idx = get_idx(handle);
+        return idx >= 0? objs[idx]: nullptr;
+    }
+
+    ///deletes every object; handles to them stay invalid
+    void clear();
+    ///appends obj and tells it its handle
+    map_obj::MapObjHandle insert(std::shared_ptr<map_obj::MapObject> obj);
+    ///deleted_idx is sorted and has no duplicates, and moves come from get_swap_and_pop_moves()
+    void erase(const std::vector<int> &deleted_idx, const std::vector<CEng1IdxMove> &moves);
+};
+
+}
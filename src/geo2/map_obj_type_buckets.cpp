@@ -0,0 +1,90 @@
+#include "geo2/map_obj_type_buckets.h"
+
+#include <typeinfo>
+
+namespace geo2 {
+
+using map_obj::MapObject;
+
+template<class... Ts> static int get_bucket_impl(const MapObject &obj, map_obj::MapObjTypeList<Ts...>)
+{
+    static_assert((std::is_final_v<Ts> && ...), "calls through T* have to be statically dispatched");
+
+    int bucket = 0;
+    //this only happens when objects are added, so RTTI is fine
+    ((typeid(obj) == typeid(Ts)? true: (bucket++, false)) || ...);
+    return bucket;
+}
+///the types in the other bucket aren't known at compile time, so this compares the vtable
+///entries instead, which only some compilers support; with the rest, they're always simulated
+static bool is_gfx_only_at_runtime([[maybe_unused]] const MapObject &obj)
+{
+    #ifdef __GNUC__
+    //If we add run2_st and sfx as functions, then we should add those into the condition here too.
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wpedantic"
+    return (void*)(&MapObject::init) == (void*)(obj.*(&MapObject::init)) &&
+           (void*)(&MapObject::run1_mt) == (void*)(obj.*(&MapObject::run1_mt)) &&
+           (void*)(&MapObject::run3_mt) == (void*)(obj.*(&MapObject::run3_mt));
+    #pragma GCC diagnostic pop
+    #else
+    return false;
+    #endif
+}
+template<class... Ts> static bool is_gfx_only_impl(const MapObject &obj, int bucket, map_obj::MapObjTypeList<Ts...>)
+{
+    constexpr bool gfx_only[] = {map_obj::is_gfx_only<Ts>..., false};
+    if(bucket < (int)sizeof...(Ts))
+        return gfx_only[bucket];
+    return is_gfx_only_at_runtime(obj);
+}
+
+int MapObjTypeBuckets::get_bucket(const MapObject &obj)
+{
+    return get_bucket_impl(obj, Types{});
+}
+bool MapObjTypeBuckets::is_gfx_only(const MapObject &obj)
+{
+    return is_gfx_only_impl(obj, get_bucket(obj), Types{});
+}
+void MapObjTypeBuckets::clear()
+{
+    for(auto &bucket: buckets)
+        bucket.clear();
+    bucket_of.clear();
+    pos_in_bucket.clear();
+}
+void MapObjTypeBuckets::add(int idx, int bucket)
+{
+    k_expects(idx == (int)bucket_of.size());
+    k_expects(bucket >= 0 && bucket < NUM_BUCKETS);
+
+    bucket_of.push_back(bucket);
+    pos_in_bucket.push_back(buckets[bucket].size());
+    buckets[bucket].push_back(idx);
+}
+void MapObjTypeBuckets::erase(const std::vector<int> &deleted_idx, const std::vector<CEng1IdxMove> &moves)
+{
+    if(deleted_idx.empty())
+        return;
+
+    k_expects(deleted_idx.back() < (int)bucket_of.size());
+
+    //swap-and-pop within the buckets too
+    for(int idx: deleted_idx) {
+        auto &bucket = buckets[bucket_of[idx]];
+        int pos = pos_in_bucket[idx];
+        bucket[pos] = bucket.back();
+        pos_in_bucket[bucket[pos]] = pos;
+        bucket.pop_back();
+    }
+    for(auto move: moves) {
+        bucket_of[move.to] = bucket_of[move.from];
+        pos_in_bucket[move.to] = pos_in_bucket[move.from];
+        buckets[bucket_of[move.to]][pos_in_bucket[move.to]] = move.to;
+    }
+    bucket_of.resize(bucket_of.size() - deleted_idx.size());
+    pos_in_bucket.resize(bucket_of.size());
+}
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "geo2/ceng1_broadphase.h"
+#include "geo2/map_obj/map_obj_types.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace geo2 {
+
+/** Groups the indices of the map objects (into map_objs/ceng_data) by concrete type, so
+ *  they can be updated one type at a time with statically dispatched loops instead of a
+ *  virtual call per object, with the types interleaved. Bucket i holds the i-th type of
+ *  map_obj::ConcreteMapObjTypes, and the last bucket holds every object of another type.
+ *  The order only depends on which objects were added and deleted, so it's deterministic.
+ */
+class MapObjTypeBuckets final
+{
+public:
+    using Types = map_obj::ConcreteMapObjTypes;
+    static constexpr int NUM_BUCKETS = Types::size + 1;
+    static constexpr int OTHER_BUCKET = Types::size;
+
+    template<class T> struct TypeTag
+    {
+        using type = T;
+    };
+private:
+    std::array<std::vector<int>, NUM_BUCKETS> buckets;
+    //by idx
+    std::vector<uint8_t> bucket_of;
+    std::vector<int> pos_in_bucket;
+
+    template<class Func, class... Ts, size_t... Is>
+    static inline void visit_bucket_impl(int bucket, const Func &func, map_obj::MapObjTypeList<Ts...>,
+                                         std::index_sequence<Is...>)
+    {
+        ((bucket == (int)Is? func(TypeTag<Ts>{}): void()), ...);
+        if(bucket == OTHER_BUCKET)
+            func(TypeTag<map_obj::MapObject>{});
+    }
+    template<class Func, class... Ts>
+    static inline void visit_bucket(int bucket, const Func &func, map_obj::MapObjTypeList<Ts...> types)
+    {
+        visit_bucket_impl(bucket, func, types, std::index_sequence_for<Ts...>{});
+    }
+public:
+    ///the bucket that obj goes in
+    static int get_bucket(const map_obj::MapObject &obj);
+    ///whether obj only has to be rendered, which is decided by map_obj::is_gfx_only, or at
+    ///run time for the other bucket
+    static bool is_gfx_only(const map_obj::MapObject &obj);
+
+    void clear();
+    ///idx has to be the number of objects so far
+    void add(int idx, int bucket);
+    ///deleted_idx is sorted and has no duplicates, and moves come from get_swap_and_pop_moves()
+    void erase(const std::vector<int> &deleted_idx, const std::vector<CEng1IdxMove> &moves);
+
+    /** Pred<T>::value says whether objects of type T take part (the other bucket always
+     *  does). This is the number of objects that do, which are numbered in bucket order.
+     */
+    template<template<class> class Pred> int count() const
+    {
+        int ret = 0;
+        for(int b=0; b<NUM_BUCKETS; b++) {
+            visit_bucket(b, [this, b, &ret](auto tag)
+                {
+                    using T = typename decltype(tag)::type;
+                    if constexpr(std::is_same_v<T, map_obj::MapObject> || Pred<T>::value)
+                        ret += buckets[b].size();
+                }, Types{});
+        }
+        return ret;
+    }
+    /** Calls func(TypeTag<T>{}, first, last) for the objects numbered [begin, end) (see
+     *  count()), one bucket at a time; [first, last) are their indices, and they're all
+     *  of type T, or T is MapObject for the other bucket.
+     */
+    template<template<class> class Pred, class Func>
+    void for_each_in_range(int begin, int end, const Func &func) const
+    {
+        int bucket_begin = 0;
+        for(int b=0; b<NUM_BUCKETS && bucket_begin < end; b++) {
+            visit_bucket(b, [this, b, begin, end, &bucket_begin, &func](auto tag)
+                {
+                    using T = typename decltype(tag)::type;
+                    if constexpr(std::is_same_v<T, map_obj::MapObject> || Pred<T>::value) {
+                        int bucket_end = bucket_begin + buckets[b].size();
+                        int first = std::max(begin, bucket_begin);
+                        int last = std::min(end, bucket_end);
+                        if(first < last)
+                            func(tag, buckets[b].data() + (first - bucket_begin),
+                                 buckets[b].data() + (last - bucket_begin));
+                        bucket_begin = bucket_end;
+                    }
+                }, Types{});
+        }
+    }
+};
+
+}
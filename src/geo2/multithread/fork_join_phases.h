@@ -0,0 +1,123 @@
+#pragma once
+
+#include "geo2/multithread/thread_pool.h"
+#include "geo2/timer.h"
+
+#include "kx/debug.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace geo2 {
+
+/** Runs the phases of a tick (run1, run3, ...) on a ThreadPool and keeps track of how
+ *  long each of them takes.
+ *  A phase splits its items into a fixed number of contiguous chunks, and the pool hands
+ *  the chunks out dynamically, so a thread that gets cheap objects (projectiles) takes
+ *  chunks from one that got expensive ones (units). Since the chunks don't depend on the
+ *  number of threads, per-chunk state (rngs, output buffers) makes a phase deterministic.
+ *  Every phase is a barrier: run_phase() returns once all of its chunks are done.
+ */
+class ForkJoinPhases final
+{
+public:
+    struct PhaseStats
+    {
+        const char *name;
+        int64_t num_runs = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+
+        inline double get_avg_us() const
+        {
+            return num_runs == 0? 0: total_ns / (1000.0 * num_runs);
+        }
+    };
+    ///keeps the workers spinning between phases for as long as it's alive
+    class HotSection final
+    {
+        ThreadPool *thread_pool;
+    public:
+        HotSection(ThreadPool *thread_pool_):
+            thread_pool(thread_pool_)
+        {
+            thread_pool->begin_keep_awake();
+        }
+        ~HotSection()
+        {
+            thread_pool->end_keep_awake();
+        }
+        HotSection(const HotSection&) = delete;
+        HotSection &operator = (const HotSection&) = delete;
+    };
+private:
+    std::shared_ptr<ThreadPool> thread_pool;
+    std::vector<PhaseStats> phase_stats;
+
+    inline void add_time(int phase, uint64_t ns)
+    {
+        auto &stats = phase_stats[phase];
+        stats.num_runs++;
+        stats.total_ns += ns;
+        stats.max_ns = std::max(stats.max_ns, ns);
+    }
+public:
+    ForkJoinPhases(std::shared_ptr<ThreadPool> thread_pool_):
+        thread_pool(std::move(thread_pool_))
+    {}
+
+    ///returns the id that's passed to run_phase()
+    inline int add_phase(const char *name)
+    {
+        phase_stats.push_back(PhaseStats{name});
+        return phase_stats.size() - 1;
+    }
+    ///the workers don't go to sleep while the returned object is alive (e.g. for all the
+    ///ticks of a frame)
+    [[nodiscard]] inline HotSection keep_hot()
+    {
+        return HotSection(thread_pool.get());
+    }
+    /** Calls fn(chunk, begin, end) for every chunk in [0, num_chunks), where
+     *  [begin, end) is the chunk's part of [0, num_items), and returns once all of
+     *  them are done. Chunks can be empty if there are fewer items than chunks.
+     */
+    template<class Func> void run_phase(int phase, int num_items, int num_chunks, const Func &fn)
+    {
+        k_expects(phase >= 0 && phase < (int)phase_stats.size());
+        k_expects(num_chunks >= 1);
+
+        Timer timer;
+        timer.start();
+        thread_pool->parallel_for(0, num_chunks, 1, [num_items, num_chunks, &fn](int chunk)
+        {
+            int begin = (num_items * (int64_t)chunk) / num_chunks;
+            int end = (num_items * (int64_t)(chunk+1)) / num_chunks;
+            fn(chunk, begin, end);
+        });
+        add_time(phase, timer.elapsed_ns());
+    }
+    ///for phases that run on the calling thread (and may parallelize on their own)
+    template<class Func> void run_serial_phase(int phase, const Func &fn)
+    {
+        k_expects(phase >= 0 && phase < (int)phase_stats.size());
+
+        Timer timer;
+        timer.start();
+        fn();
+        add_time(phase, timer.elapsed_ns());
+    }
+    inline const std::vector<PhaseStats> &get_phase_stats() const
+    {
+        return phase_stats;
+    }
+    inline void reset_phase_stats()
+    {
+        for(auto &stats: phase_stats)
+            stats = PhaseStats{stats.name};
+    }
+};
+
+}
@@ -1,216 +1,280 @@
 #pragma once
 
 #include "kx/multithread/spinlock.h"
-#include "kx/atomic/queue.h"
+#include "kx/log.h"
+#include "kx/util.h"
 
+#include <xmmintrin.h>
+#include <algorithm>
 #include <vector>
 #include <thread>
-#include <future>
 #include <condition_variable>
 #include <mutex>
-#include <optional>
-#include <queue>
+#include <atomic>
+#include <memory>
+#include <exception>
 
 namespace geo2 {
 
+/** A work-stealing thread pool. parallel_for() splits a range into chunks, deals them out
+ *  to per-worker deques, and the calling thread helps until every chunk is done; idle
+ *  workers steal chunks from the other deques. Nothing is allocated per call, and there
+ *  are no futures.
+ *  Workers spin for a bit after running out of work before they go to sleep, because we
+ *  call parallel_for() several times per tick and waking a sleeping thread is slow.
+ *  parallel_for() must not be called from two threads at once or from inside itself.
+ */
 class ThreadPool
 {
-    struct Task
-    {
-        std::promise<void> ret;
-        std::function<void()> task_fn;
+    //roughly tens of microseconds; a tick is ~700us, and there are a few calls per tick
+    static constexpr int SPIN_ITERATIONS = 1 << 12;
 
-        Task(std::promise<void> &&ret_, const std::function<void()> &task_fn_):
-            ret(std::move(ret_)),
-            task_fn(task_fn_)
-        {}
+    struct Job
+    {
+        const void *fn;
+        void (*run)(const void *fn, int begin, int end);
+        std::atomic<int> num_chunks_left;
+        //set by the first chunk that throws; the rest of the chunks are skipped then
+        std::atomic<bool> failed;
+        std::exception_ptr error;
     };
+    struct Chunk
+    {
+        Job *job;
+        int begin;
+        int end;
+    };
+    ///the owner pops from the back, and thieves steal from the front
+    struct alignas(64) WorkerDeque
+    {
+        kx::Spinlock<kx::SpinlockWaitStrategy::mm_pause> lock;
+        std::vector<Chunk> chunks;
+        size_t head = 0;
+    };
+
     std::vector<std::thread> threads;
-    kx::AtomicQueue<Task> tasks;
+    //deques[0] belongs to the thread that calls parallel_for(), and deques[i] to threads[i-1]
+    std::unique_ptr<WorkerDeque[]> deques;
+    std::atomic<int> num_queued_chunks;
+
+    std::mutex sleep_mtx;
+    std::condition_variable sleep_cv;
+    std::atomic<uint64_t> generation; //incremented every time work is added
+    std::atomic<int> num_sleeping;
+    std::atomic<int> num_keep_awake;
+    std::atomic<bool> should_quit;
 
-    void run_thread()
+    template<class Func> static void run_chunk(const void *fn, int begin, int end)
     {
-        while(true) {
-            ///a null function is the quit signal
-            auto task = tasks.poll_blocking();
-
-            if(task.task_fn) {
-                task.task_fn();
-                task.ret.set_value();
-            } else
-                break;
-        }
+        const auto &func = *static_cast<const Func*>(fn);
+        for(int i=begin; i<end; i++)
+            func(i);
     }
-public:
-    ThreadPool(int n)
+    bool pop_back(int deque_idx, Chunk *chunk)
     {
-        if(n < 1) {
-
-            kx::log_warning("ThreadPool with <1 thread constructed. ThreadPool will have 0 threads. "
-                            "Note: This machine has " +
-                            kx::to_str(std::thread::hardware_concurrency()) + " threads");
+        auto &deque = deques[deque_idx];
+        std::lock_guard lg(deque.lock);
+        if(deque.head == deque.chunks.size())
+            return false;
+        *chunk = deque.chunks.back();
+        deque.chunks.pop_back();
+        if(deque.head == deque.chunks.size()) {
+            deque.chunks.clear();
+            deque.head = 0;
         }
-        threads.resize(n);
-        for(int i=0; i<n; i++)
-            threads[i] = std::thread([this]{run_thread();});
+        return true;
     }
-    ~ThreadPool()
+    bool steal(int deque_idx, Chunk *chunk)
     {
-        ///add enough null functions for all threads to get one
-        for(size_t i=0; i<threads.size(); i++) {
-            tasks.push({{}, {}});
+        auto &deque = deques[deque_idx];
+        //don't wait for the lock; someone else is already there, so try another deque
+        if(!deque.lock.try_lock())
+            return false;
+        bool found = deque.head < deque.chunks.size();
+        if(found) {
+            *chunk = deque.chunks[deque.head];
+            deque.head++;
+            if(deque.head == deque.chunks.size()) {
+                deque.chunks.clear();
+                deque.head = 0;
+            }
         }
-
-        for(size_t i=0; i<threads.size(); i++)
-            threads[i].join();
+        deque.lock.unlock();
+        return found;
     }
-    ///can't be copied
-    ThreadPool(const ThreadPool&) = delete;
-    ThreadPool &operator = (const ThreadPool&) = delete;
+    ///returns true if a chunk was run
+    bool run_one_chunk(int deque_idx)
+    {
+        if(num_queued_chunks.load(std::memory_order_acquire) == 0)
+            return false;
 
-    ///too lazy to add move support rn
-    ThreadPool(ThreadPool&&) = delete;
-    ThreadPool &operator = (ThreadPool&&) = delete;
+        Chunk chunk;
+        bool found = pop_back(deque_idx, &chunk);
+        for(int i=1; !found && i<=(int)threads.size(); i++)
+            found = steal((deque_idx + i) % (threads.size() + 1), &chunk);
+        if(!found)
+            return false;
 
-    [[nodiscard]] std::future<void> add_task(const std::function<void()> &to_add)
-    {
-        std::promise<void> ret;
-        auto fut = ret.get_future();
-        ///don't add null functions; they serve as a special signal
-        if(to_add)
-            tasks.push(Task(std::move(ret), to_add));
-        else
-            ret.set_value(); ///fill the promise ourselves (because no worker thread will)
-        return fut;
-    }
-    size_t size() const
-    {
-        return threads.size();
+        num_queued_chunks.fetch_sub(1, std::memory_order_relaxed);
+        //an exception can't just unwind out of here: on a worker it would terminate, and
+        //on the calling thread it would destroy the job while other threads still have
+        //its chunks. The calling thread rethrows it once every chunk is done.
+        if(!chunk.job->failed.load(std::memory_order_relaxed)) {
+            try {
+                chunk.job->run(chunk.job->fn, chunk.begin, chunk.end);
+            } catch(...) {
+                if(!chunk.job->failed.exchange(true))
+                    chunk.job->error = std::current_exception();
+            }
+        }
+        //the job may be destroyed as soon as this hits 0, so don't touch it afterwards
+        chunk.job->num_chunks_left.fetch_sub(1, std::memory_order_release);
+        return true;
     }
-};
-
-/*
-class SpinThreadPool
-{
-    struct Task
+    void run_thread(int deque_idx)
     {
-        std::promise<void> ret;
-        std::function<void()> task_fn;
-
-        Task()
-        {}
-        Task(std::promise<void> &&ret_, const std::function<void()> &task_fn_):
-            ret(std::move(ret_)),
-            task_fn(task_fn_)
-        {}
-    };
-    std::vector<std::thread> threads;
-
-    std::mutex mtx;
-    std::condition_variable cv;
-
-    std::atomic<bool> should_spin;
-    std::atomic<bool> should_quit;
-    std::atomic<int> num_tasks;
-
-    kx::Spinlock<kx::SpinlockWaitStrategy::mm_pause> task_lock;
-    std::queue<Task> tasks;
+        uint64_t last_generation = generation.load(std::memory_order_acquire);
+        int num_spins = 0;
+        while(!should_quit.load(std::memory_order_acquire)) {
+            if(run_one_chunk(deque_idx)) {
+                num_spins = 0;
+                continue;
+            }
+            if(num_spins < SPIN_ITERATIONS || num_keep_awake.load(std::memory_order_relaxed) > 0) {
+                _mm_pause();
+                num_spins++;
+                continue;
+            }
 
-    void run_thread()
+            //num_sleeping is incremented before we look at generation, and parallel_for()
+            //increments generation before it looks at num_sleeping, so at least one of us
+            //sees the other's change and we can't miss a wakeup
+            std::unique_lock lk(sleep_mtx);
+            num_sleeping.fetch_add(1);
+            sleep_cv.wait(lk, [this, last_generation]
+                              {
+                                  return generation.load() != last_generation || should_quit.load();
+                              });
+            num_sleeping.fetch_sub(1);
+            last_generation = generation.load(std::memory_order_acquire);
+            num_spins = 0;
+        }
+    }
+    void wake_sleeping_threads()
     {
-        while(true) {
-            ///wait until we're told to spin or quit
+        generation.fetch_add(1);
+        if(num_sleeping.load() > 0) {
             {
-                std::unique_lock lk(mtx);
-                cv.wait(lk, [this]{return should_spin.load(std::memory_order_relaxed) ||
-                                          should_quit.load(std::memory_order_relaxed);});
-            }
-
-            if(should_quit.load(std::memory_order_relaxed))
-                break;
-
-            while(true) {
-                std::optional<Task> task;
-                ///keep spinning until there's a task in the queue OR we're told
-                ///to stop spinning
-                while(num_tasks.load(std::memory_order_relaxed)==0 &&
-                      should_spin.load(std::memory_order_relaxed))
-                {
-                    _mm_pause();
-                }
-
-                {
-                    auto lg = task_lock.get_lock_guard();
-                    if(tasks.size() > 0) {
-                        task = std::move(tasks.front());
-                        tasks.pop();
-                        num_tasks.fetch_sub(1, std::memory_order_relaxed);
-                    }
-                }
-
-                if(task) {
-                    task->task_fn();
-                    task->ret.set_value();
-                }
-
-                if(!should_spin.load(std::memory_order_relaxed))
-                    break;
+                //makes sure that a thread that is about to sleep is either already
+                //waiting or will see the new generation
+                std::lock_guard lg(sleep_mtx);
             }
+            sleep_cv.notify_all();
         }
     }
 public:
-    SpinThreadPool(int n):
-        should_spin(false),
-        should_quit(false),
-        num_tasks(0)
+    ThreadPool(int n):
+        num_queued_chunks(0),
+        generation(0),
+        num_sleeping(0),
+        num_keep_awake(0),
+        should_quit(false)
     {
         if(n < 1) {
-
-            kx::log_warning("SpinThreadPool with <1 thread constructed. Upping thread count to 1."
+            kx::log_warning("ThreadPool with <1 thread constructed. ThreadPool will have 0 threads. "
                             "Note: This machine has " +
                             kx::to_str(std::thread::hardware_concurrency()) + " threads");
-            n = 1;
+            n = 0;
         }
+        deques = std::make_unique<WorkerDeque[]>(n + 1);
         threads.resize(n);
         for(int i=0; i<n; i++)
-            threads[i] = std::thread([this]{run_thread();});
+            threads[i] = std::thread([this, i]{run_thread(i + 1);});
     }
-    ~SpinThreadPool()
+    ~ThreadPool()
     {
-        should_spin.store(false, std::memory_order_relaxed);
-        should_quit.store(true, std::memory_order_relaxed);
-        cv.notify_all();
-
-        for(size_t i=0; i<threads.size(); i++)
-            threads[i].join();
+        should_quit.store(true);
+        wake_sleeping_threads();
+        for(auto &thread: threads)
+            thread.join();
     }
     ///can't be copied
-    SpinThreadPool(const SpinThreadPool&) = delete;
-    SpinThreadPool &operator = (const SpinThreadPool&) = delete;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool &operator = (const ThreadPool&) = delete;
 
     ///too lazy to add move support rn
-    SpinThreadPool(SpinThreadPool&&) = delete;
-    SpinThreadPool &operator = (SpinThreadPool&&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool &operator = (ThreadPool&&) = delete;
+
+    /** Calls fn(i) for every i in [begin, end), in chunks of (at most) grain consecutive
+     *  indices, and returns once all of them are done. Which thread runs a chunk isn't
+     *  deterministic, so if fn needs per-thread state, make one index per part instead
+     *  (e.g. parallel_for(0, size() + 1, 1, ...)).
+     *  If fn throws, the chunks that haven't started yet are skipped, and the first
+     *  exception is rethrown here once the others are done.
+     */
+    template<class Func> void parallel_for(int begin, int end, int grain, const Func &fn)
+    {
+        if(begin >= end)
+            return;
+        k_expects(grain >= 1);
 
-    void set_spin(bool val)
+        int num_chunks = (end - begin + grain - 1) / grain;
+        if(num_chunks == 1 || threads.empty()) {
+            run_chunk<Func>(&fn, begin, end);
+            return;
+        }
+
+        Job job;
+        job.fn = &fn;
+        job.run = run_chunk<Func>;
+        job.num_chunks_left.store(num_chunks, std::memory_order_relaxed);
+        job.failed.store(false, std::memory_order_relaxed);
+        //count the chunks before anyone can take them, so this never goes below 0
+        num_queued_chunks.fetch_add(num_chunks, std::memory_order_relaxed);
+
+        //deal out contiguous runs of chunks; the owner pops from the back, so push them in
+        //reverse to have each thread go through its run in order
+        int num_deques = threads.size() + 1;
+        for(int d=0; d<num_deques; d++) {
+            int chunk1 = (int64_t)num_chunks * d / num_deques;
+            int chunk2 = (int64_t)num_chunks * (d+1) / num_deques;
+            auto &deque = deques[d];
+            std::lock_guard lg(deque.lock);
+            for(int c=chunk2-1; c>=chunk1; c--) {
+                int chunk_begin = begin + c*grain;
+                deque.chunks.push_back(Chunk{&job, chunk_begin, std::min(end, chunk_begin + grain)});
+            }
+        }
+        wake_sleeping_threads();
+
+        //help out until everything is done
+        while(job.num_chunks_left.load(std::memory_order_acquire) > 0) {
+            if(!run_one_chunk(0))
+                _mm_pause();
+        }
+        if(job.error)
+            std::rethrow_exception(job.error);
+    }
+    /** While there are more calls to begin_keep_awake() than to end_keep_awake(), idle
+     *  workers spin instead of going to sleep, so parallel_for() doesn't have to wake them
+     *  up. This burns CPU, so only do it around code that calls parallel_for() a lot.
+     */
+    void begin_keep_awake()
     {
-        should_spin.store(val, std::memory_order_relaxed);
-        cv.notify_all();
+        num_keep_awake.fetch_add(1, std::memory_order_relaxed);
+        wake_sleeping_threads();
     }
-    [[nodiscard]] std::future<void> add_task(const std::function<void()> &to_add)
+    void end_keep_awake()
     {
-        std::promise<void> ret;
-        auto fut = ret.get_future();
-        auto lg = task_lock.get_lock_guard();
-        tasks.push(Task(std::move(ret), to_add));
-        num_tasks.fetch_add(1, std::memory_order_relaxed);
-        return fut;
+        k_expects(num_keep_awake.load() > 0);
+        num_keep_awake.fetch_sub(1, std::memory_order_relaxed);
     }
+    ///the number of worker threads, not counting the thread that calls parallel_for()
     size_t size() const
     {
         return threads.size();
     }
 };
-*/
 
 }
@@ -0,0 +1,177 @@
+#include "geo2/projectile_system.h"
+#include "geo2/map_obj/map_obj_args.h"
+#include "geo2/render_op.h"
+
+#include <immintrin.h>
+#include <cmath>
+
+namespace geo2 {
+
+constexpr auto SIDE_LEN = 0.3;
+
+//an equilateral triangle centered on the origin
+constexpr float BASE_VERT_X[] = {-0.5 * SIDE_LEN, 0.5 * SIDE_LEN, 0.0};
+constexpr float BASE_VERT_Y[] = {SIDE_LEN * 1.0 / 3.0 * 0.8660254037844386,
+                                 SIDE_LEN * 1.0 / 3.0 * 0.8660254037844386,
+                                 -SIDE_LEN * 2.0 / 3.0 * 0.8660254037844386};
+
+ProjectileSystem::ProjectileSystem()
+{}
+ProjectileSystem::~ProjectileSystem()
+{}
+
+CEng1CollisionFilter ProjectileSystem::get_collision_filter()
+{
+    //projectiles go through each other
+    return CEng1CollisionFilter(CEng1CollisionFilter::LAYER_PROJECTILE,
+                                CEng1CollisionFilter::LAYER_WALL | CEng1CollisionFilter::LAYER_UNIT);
+}
+void ProjectileSystem::spawn(const ProjectileSpawnInfo &info)
+{
+    pos_x.push_back(info.pos.x);
+    pos_y.push_back(info.pos.y);
+    vel_x.push_back(info.velocity.x);
+    vel_y.push_back(info.velocity.y);
+    life_left.push_back(info.lifespan);
+    damage.push_back(info.damage);
+    team.push_back(info.team);
+    inner_color.push_back(info.inner_color);
+    outer_color.push_back(info.outer_color);
+
+    float c = std::cos(info.rot);
+    float s = std::sin(info.rot);
+    for(int v=0; v<NUM_VERTICES; v++) {
+        vert_dx[v].push_back(c * BASE_VERT_X[v] - s * BASE_VERT_Y[v]);
+        vert_dy[v].push_back(s * BASE_VERT_X[v] + c * BASE_VERT_Y[v]);
+    }
+}
+void ProjectileSystem::clear()
+{
+    pos_x.clear();
+    pos_y.clear();
+    vel_x.clear();
+    vel_y.clear();
+    life_left.clear();
+    damage.clear();
+    team.clear();
+    inner_color.clear();
+    outer_color.clear();
+    for(int v=0; v<NUM_VERTICES; v++) {
+        vert_dx[v].clear();
+        vert_dy[v].clear();
+    }
+    shapes.clear();
+    displacements.clear();
+}
+void ProjectileSystem::prepare_move(double tick_len)
+{
+    last_tick_len = tick_len;
+    while(shape_pool.size() < size())
+        shape_pool.push_back(Polygon::make_with_num_sides(NUM_VERTICES));
+    shapes.resize(size());
+    displacements.resize(size());
+}
+void ProjectileSystem::move(int begin, int end, double tick_len)
+{
+    k_expects(shape_pool.size() >= size() && shapes.size() == size());
+
+    //the shapes start where the projectiles are now; the collision engine sweeps them
+    for(int i = begin; i < end; i++) {
+        std::array<_MapCoord<float>, NUM_VERTICES> verts;
+        for(int v=0; v<NUM_VERTICES; v++)
+            verts[v] = _MapCoord<float>(pos_x[i] + vert_dx[v][i], pos_y[i] + vert_dy[v][i]);
+        shape_pool[i]->remake(kx::kx_span<_MapCoord<float>>(verts.data(), verts.data() + NUM_VERTICES));
+        shapes[i] = shape_pool[i].get();
+        displacements[i] = _MapVec<float>(vel_x[i] * (float)tick_len, vel_y[i] * (float)tick_len);
+    }
+
+    int i = begin;
+    auto mm_dt = _mm256_set1_ps(tick_len);
+    for(; i + 8 <= end; i += 8) {
+        auto x = _mm256_loadu_ps(&pos_x[i]);
+        auto y = _mm256_loadu_ps(&pos_y[i]);
+        auto vx = _mm256_loadu_ps(&vel_x[i]);
+        auto vy = _mm256_loadu_ps(&vel_y[i]);
+        auto life = _mm256_loadu_ps(&life_left[i]);
+        _mm256_storeu_ps(&pos_x[i], _mm256_add_ps(x, _mm256_mul_ps(vx, mm_dt)));
+        _mm256_storeu_ps(&pos_y[i], _mm256_add_ps(y, _mm256_mul_ps(vy, mm_dt)));
+        _mm256_storeu_ps(&life_left[i], _mm256_sub_ps(life, mm_dt));
+    }
+    for(; i < end; i++) {
+        pos_x[i] += vel_x[i] * (float)tick_len;
+        pos_y[i] += vel_y[i] * (float)tick_len;
+        life_left[i] -= tick_len;
+    }
+}
+void ProjectileSystem::remove_dead()
+{
+    k_expects(shapes.size() == size());
+
+    size_t new_size = 0;
+    for(size_t i=0; i<size(); i++) {
+        if(!is_alive(i))
+            continue;
+        if(new_size != i) {
+            pos_x[new_size] = pos_x[i];
+            pos_y[new_size] = pos_y[i];
+            vel_x[new_size] = vel_x[i];
+            vel_y[new_size] = vel_y[i];
+            life_left[new_size] = life_left[i];
+            damage[new_size] = damage[i];
+            team[new_size] = team[i];
+            inner_color[new_size] = inner_color[i];
+            outer_color[new_size] = outer_color[i];
+            for(int v=0; v<NUM_VERTICES; v++) {
+                vert_dx[v][new_size] = vert_dx[v][i];
+                vert_dy[v][new_size] = vert_dy[v][i];
+            }
+            //the shape is still needed for rendering
+            std::swap(shape_pool[new_size], shape_pool[i]);
+            shapes[new_size] = shape_pool[new_size].get();
+            displacements[new_size] = displacements[i];
+        }
+        new_size++;
+    }
+
+    pos_x.resize(new_size);
+    pos_y.resize(new_size);
+    vel_x.resize(new_size);
+    vel_y.resize(new_size);
+    life_left.resize(new_size);
+    damage.resize(new_size);
+    team.resize(new_size);
+    inner_color.resize(new_size);
+    outer_color.resize(new_size);
+    for(int v=0; v<NUM_VERTICES; v++) {
+        vert_dx[v].resize(new_size);
+        vert_dy[v].resize(new_size);
+    }
+    shapes.resize(new_size);
+    displacements.resize(new_size);
+}
+void ProjectileSystem::add_render_ops(const map_obj::MapObjRenderArgs &args)
+{
+    auto shader = args.shaders->get("laser_proj_1");
+    args.begin_op_group(args.get_proj_render_priority());
+
+    for(size_t i=0; i<shapes.size(); i++) {
+        //the shape is a tick behind, which doesn't matter for culling
+        if(!args.is_AABB_in_view(shapes[i]->get_AABB()))
+            continue;
+
+        auto op_iu = args.add_op(*shader);
+
+        //position, moved back towards where the projectile was before the last tick
+        float back = (1 - args.tick_interp) * last_tick_len;
+        float x = pos_x[i] - vel_x[i] * back;
+        float y = pos_y[i] - vel_y[i] * back;
+        for(int v=0; v<NUM_VERTICES; v++) {
+            op_iu[v*2] = args.x_to_ndc(x + vert_dx[v][i]);
+            op_iu[v*2 + 1] = args.y_to_ndc(y + vert_dy[v][i]);
+        }
+        *reinterpret_cast<kx::gfx::LinearColor*>(&op_iu[8]) = inner_color[i];
+        *reinterpret_cast<kx::gfx::LinearColor*>(&op_iu[12]) = outer_color[i];
+    }
+}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "geo2/geometry.h"
+#include "geo2/ceng1_collision_filter.h"
+#include "geo2/map_obj/map_object.h"
+
+#include "kx/gfx/renderer_types.h"
+#include "kx/util.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+namespace geo2 {
+
+namespace map_obj {class MapObjRenderArgs;}
+
+struct ProjectileSpawnInfo final
+{
+    MapCoord pos;
+    MapVec velocity;
+    double damage;
+    double lifespan;
+    ///rotation of the triangle about its center
+    double rot;
+    kx::gfx::LinearColor inner_color;
+    kx::gfx::LinearColor outer_color;
+    map_obj::Team team;
+};
+
+/** All the laser bolts in the level, stored as a structure of arrays instead of one
+ *  MapObject each; there can be thousands of them, and they all do the same thing: fly
+ *  in a straight line until they hit something or run out of time.
+ *  Projectiles don't go through the collision engine's resolution; they move after
+ *  collisions are resolved, and the path they cover in the tick is checked against where
+ *  everything ended up with CollisionEngine1::find_swept_shape_overlaps(), so they can't
+ *  tunnel through things however long the tick is. The order of the projectiles is kept,
+ *  so hits are resolved in the same order every time.
+ */
+class ProjectileSystem final
+{
+    static constexpr int NUM_VERTICES = 3;
+
+    std::vector<float> pos_x;
+    std::vector<float> pos_y;
+    std::vector<float> vel_x;
+    std::vector<float> vel_y;
+    std::vector<float> life_left;
+    std::vector<float> damage;
+    std::vector<map_obj::Team> team;
+    //the rotated triangle relative to the position
+    std::array<std::vector<float>, NUM_VERTICES> vert_dx;
+    std::array<std::vector<float>, NUM_VERTICES> vert_dy;
+    std::vector<kx::gfx::LinearColor> inner_color;
+    std::vector<kx::gfx::LinearColor> outer_color;
+
+    //shapes where the projectiles were at the start of the last move() and how far they
+    //moved from there; the pool only grows, so shapes aren't allocated for every projectile
+    std::vector<std::unique_ptr<Polygon>> shape_pool;
+    std::vector<const Polygon*> shapes;
+    std::vector<_MapVec<float>> displacements;
+    float last_tick_len = 0;
+public:
+    ProjectileSystem();
+    ~ProjectileSystem();
+
+    ProjectileSystem(const ProjectileSystem&) = delete;
+    ProjectileSystem &operator = (const ProjectileSystem&) = delete;
+    ProjectileSystem(ProjectileSystem&&) = delete;
+    ProjectileSystem &operator = (ProjectileSystem&&) = delete;
+
+    inline size_t size() const
+    {
+        return pos_x.size();
+    }
+    inline bool is_alive(int i) const
+    {
+        return life_left[i] > 0;
+    }
+    inline double get_damage(int i) const
+    {
+        return damage[i];
+    }
+    inline map_obj::Team get_team(int i) const
+    {
+        return team[i];
+    }
+    inline void kill(int i)
+    {
+        life_left[i] = 0;
+    }
+    ///shapes[i] is projectile i where it started the last move()...
+    inline const std::vector<const Polygon*> &get_shapes() const
+    {
+        return shapes;
+    }
+    ///...and it moved by displacements[i] from there
+    inline const std::vector<_MapVec<float>> &get_displacements() const
+    {
+        return displacements;
+    }
+    static CEng1CollisionFilter get_collision_filter();
+
+    void spawn(const ProjectileSpawnInfo &info);
+    void clear();
+    ///makes the shape pool big enough for everything that was spawned; call this before
+    ///move() because move() can run on several threads
+    void prepare_move(double tick_len);
+    ///moves projectiles [begin, end) forward a tick and updates their shapes and
+    ///displacements; different ranges can be moved in parallel
+    void move(int begin, int end, double tick_len);
+    ///removes the projectiles that were killed or ran out of time, keeping the order
+    void remove_dead();
+
+    void add_render_ops(const map_obj::MapObjRenderArgs &args);
+};
+
+}
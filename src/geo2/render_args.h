@@ -3,6 +3,9 @@
 #include "kx/gfx/renderer.h"
 #include "geo2/game_render_scene_graph.h"
 
+#include <algorithm>
+#include <array>
+
 namespace geo2 {
 
 /** Note that ceng_data can't be accessed in RenderArgs; this is intentional,as
@@ -17,6 +20,8 @@ class RenderArgs
     float cam_h_inv;
     float cam_w_inv_times_render_w;
     float cam_h_inv_times_render_h;
+protected:
+    RenderOpArena *op_arena = nullptr;
 public:
     float pixels_per_tile_len;
     const GameRenderSceneGraph::Shaders *shaders;
@@ -26,6 +31,24 @@ public:
     {
         rdr = renderer;
     }
+    inline void set_op_arena(RenderOpArena *arena)
+    {
+        op_arena = arena;
+    }
+    ///adds an op to the arena's current group; its instance data has to be filled
+    ///in before another op is added
+    inline kx::kx_span<float> add_op(const IShader &shader) const
+    {
+        auto iu = op_arena->add_shader_op(shader);
+        return {(float*)iu.begin(), (float*)iu.end()};
+    }
+    ///same, but copies the instance data from data
+    template<size_t N> inline void add_op(const IShader &shader, const std::array<float, N> &data) const
+    {
+        auto iu = add_op(shader);
+        k_expects(iu.size() == N);
+        std::copy(data.begin(), data.end(), iu.begin());
+    }
     inline void set_camera(kx::gfx::Rect camera_)
     {
         camera = camera_;
@@ -4,21 +4,36 @@
 
 #include "kx/gfx/renderer.h"
 #include "kx/gfx/kwindow.h"
+#include "kx/sort.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo2 {
 
 static_assert(std::is_same<kx::gfx::UBIndex, unsigned>::value);
+static_assert(std::is_same<kx::gfx::SSBIndex, unsigned>::value);
 
+/** Where the ops' uniform data goes. If persistent mapping is supported, that's a BufferRing,
+ *  which the data is put together in directly. Otherwise, it's a few UBOs that are used in
+ *  turn and uploaded to every time.
+ */
 class UBO_Allocator
 {
+    //a frame takes about 1 MB, so this holds a few frames
+    static constexpr uint32_t RING_SIZE = 1<<22;
+
+    std::unique_ptr<kx::gfx::BufferRing> ring;
     std::vector<std::unique_ptr<kx::gfx::UBO>> UBOs;
     size_t idx;
 public:
     UBO_Allocator(kx::gfx::Renderer *rdr)
     {
         idx = 0;
+        ring = rdr->make_buffer_ring(RING_SIZE, MAX_RO_UBO_SIZE);
+        if(ring != nullptr)
+            return;
+
         UBOs.clear();
         for(int i=0; i<MAX_RO_NUM_UBOS; i++) {
             auto ubo = rdr->make_UBO();
@@ -27,24 +42,42 @@ public:
             UBOs.emplace_back(std::move(ubo));
         }
     }
+    ///nullptr if the UBOs are used instead
+    kx::gfx::BufferRing *get_ring()
+    {
+        return ring.get();
+    }
     kx::gfx::UBO *get_UBO()
     {
+        k_expects(ring == nullptr);
         idx++;
         if(idx == UBOs.size())
             idx = 0;
 
         return UBOs[idx].get();
     }
+    ///call this after the draw calls that read the data
+    void fence()
+    {
+        if(ring != nullptr)
+            ring->fence();
+    }
 };
 
 IShader::IShader(const std::shared_ptr<kx::gfx::ShaderProgram> &program_,
+                 int id_,
                  int max_instances_,
                  const kx::gfx::DrawMode draw_mode_,
-                 int count_):
+                 int count_,
+                 const std::shared_ptr<kx::gfx::ShaderProgram> &ssbo_program_):
     program(program_),
+    ssbo_program(ssbo_program_),
+    id(id_),
     max_instances(max_instances_),
+    max_ssbo_instances(std::numeric_limits<int>::max()),
     draw_mode(draw_mode_),
-    count(count_)
+    count(count_),
+    instance_data_size(0)
 {}
 void IShader::add_UB(std::string_view name, int global_data_sz, int instance_data_sz)
 {
@@ -52,10 +85,17 @@ void IShader::add_UB(std::string_view name, int global_data_sz, int instance_dat
     k_expects(UBs.size() < MAX_RO_NUM_UBOS);
 
     UB ub;
-    ub.index = program->get_UB_index(name.data());
+    ub.index = program != nullptr? program->get_UB_index(name.data()): 0;
+    ub.ssb_index = ssbo_program != nullptr? ssbo_program->get_SSB_index(name.data()): 0;
     ub.global_data_size = global_data_sz;
     ub.instance_data_size = instance_data_sz;
+    ub.instance_data_offset = instance_data_size;
     UBs.push_back(std::move(ub));
+    instance_data_size += instance_data_sz;
+    if(instance_data_sz > 0) {
+        max_ssbo_instances = std::min(max_ssbo_instances,
+                                      (MAX_RO_SSBO_SIZE - global_data_sz) / instance_data_sz);
+    }
 }
 size_t IShader::get_num_UBs() const
 {
@@ -65,50 +105,127 @@ int IShader::get_instance_uniform_size_bytes(size_t idx) const
 {
     return UBs[idx].instance_data_size;
 }
+int IShader::get_instance_data_size() const
+{
+    return instance_data_size;
+}
+int IShader::get_id() const
+{
+    return id;
+}
 int IShader::get_max_instances() const
 {
+    if(ssbo_program != nullptr)
+        return std::max(max_instances, max_ssbo_instances);
     return max_instances;
 }
 
-using ByteFSA2D = kx::FixedSizeArray<kx::FixedSizeArray<uint8_t>>;
-
 template<class T> kx::kx_span<T> to_span(const kx::FixedSizeArray<uint8_t> &data)
 {
     return {(T*)data.begin(), (T*)data.end()};
 }
-void IShader::render(UBO_Allocator *ubo_allocator,
-                     kx::kx_span<const ByteFSA2D*> instance_uniform_data,
-                     kx::gfx::Renderer *rdr,
-                     kx::Passkey<class RenderSceneGraph>) const
+void IShader::gather_UB(size_t i,
+                        const uint8_t *instance_data,
+                        kx::kx_span<const uint32_t> data_offsets,
+                        uint8_t *dst) const
+{
+    auto usize = get_instance_uniform_size_bytes(i);
+    for(size_t j=0; j<data_offsets.size(); j++) {
+        auto src = instance_data + data_offsets[j] + UBs[i].instance_data_offset;
+        std::copy_n(src, usize, dst + j*usize);
+    }
+}
+void IShader::render_UBOs(UBO_Allocator *ubo_allocator,
+                          const uint8_t *instance_data,
+                          kx::kx_span<const uint32_t> data_offsets,
+                          std::vector<uint8_t> *buffer,
+                          kx::gfx::Renderer *rdr) const
 {
     rdr->use_shader_program(*program);
 
-    size_t num_instances = instance_uniform_data.size();
+    size_t num_instances = data_offsets.size();
     size_t num_instance_uniforms = UBs.size();
 
     k_expects(num_instance_uniforms <= MAX_RO_NUM_UBOS);
+    k_expects(num_instances <= (size_t)max_instances);
 
+    auto ring = ubo_allocator->get_ring();
     for(size_t i=0; i<num_instance_uniforms; i++) {
         auto usize = get_instance_uniform_size_bytes(i);
-        auto ubo = ubo_allocator->get_UBO();
-        rdr->bind_UBO(*ubo);
-        ubo->invalidate();
-
-        kx::FixedSizeArray<uint8_t> data(usize*num_instances);
-        for(size_t j=0; j<instance_uniform_data.size(); j++) {
-            k_expects((*instance_uniform_data[j])[i].size() == (size_t)usize);
-            std::copy_n((*instance_uniform_data[j])[i].begin(), usize, data.begin() + j*usize);
-        }
+        if(ring != nullptr) {
+            //the whole block is bound, but only the instances that are drawn are written
+            uint32_t offset;
+            auto dst = ring->alloc(UBs[i].global_data_size + usize*num_instances, &offset);
+            gather_UB(i, instance_data, data_offsets, dst + UBs[i].global_data_size);
+            rdr->bind_UB_range(i, *ring, offset, MAX_RO_UBO_SIZE);
+        } else {
+            auto ubo = ubo_allocator->get_UBO();
+            rdr->bind_UBO(*ubo);
+            ubo->invalidate();
 
-        ubo->buffer_sub_data(UBs[i].global_data_size, data.begin(), usize*num_instances);
-        rdr->bind_UB_base(i, *ubo);
+            buffer->resize(usize*num_instances);
+            gather_UB(i, instance_data, data_offsets, buffer->data());
+            ubo->buffer_sub_data(UBs[i].global_data_size, buffer->data(), usize*num_instances);
+            rdr->bind_UB_base(i, *ubo);
+        }
         program->bind_UB(UBs[i].index, i);
     }
 
     rdr->draw_arrays_instanced(draw_mode, 0, count, num_instances);
 }
+void IShader::render_SSBOs(kx::gfx::BufferRing *ring,
+                           const uint8_t *instance_data,
+                           kx::kx_span<const uint32_t> data_offsets,
+                           kx::gfx::Renderer *rdr) const
+{
+    rdr->use_shader_program(*ssbo_program);
+
+    size_t num_instances = data_offsets.size();
+    k_expects(num_instances <= (size_t)max_ssbo_instances);
+
+    for(size_t i=0; i<UBs.size(); i++) {
+        //unlike a UB, only the instances that are drawn have to be bound
+        uint32_t size = UBs[i].global_data_size + get_instance_uniform_size_bytes(i)*num_instances;
+        uint32_t offset;
+        auto dst = ring->alloc(size, &offset);
+        gather_UB(i, instance_data, data_offsets, dst + UBs[i].global_data_size);
+        rdr->bind_SSB_range(i, *ring, offset, size);
+        ssbo_program->bind_SSB(UBs[i].ssb_index, i);
+    }
+
+    rdr->draw_arrays_instanced(draw_mode, 0, count, num_instances);
+}
+void IShader::render(UBO_Allocator *ubo_allocator,
+                     const uint8_t *instance_data,
+                     kx::kx_span<const uint32_t> data_offsets,
+                     std::vector<uint8_t> *buffer,
+                     kx::gfx::Renderer *rdr,
+                     kx::Passkey<class RenderSceneGraph>) const
+{
+    auto ring = ubo_allocator->get_ring();
+    if(ssbo_program != nullptr && ring != nullptr) {
+        render_SSBOs(ring, instance_data, data_offsets, rdr);
+        return;
+    }
+
+    //the batch can be bigger than a UB if it was made for the SSBO program
+    for(size_t begin=0; begin<data_offsets.size(); begin+=max_instances) {
+        auto end = std::min(data_offsets.size(), begin + max_instances);
+        kx::kx_span<const uint32_t> spn(data_offsets.begin() + begin, data_offsets.begin() + end);
+        render_UBOs(ubo_allocator, instance_data, spn, buffer, rdr);
+    }
+}
+
+RenderOp::RenderOp(Type type_):
+    type(type_)
+{}
+RenderOp::Type RenderOp::get_type() const
+{
+    return type;
+}
 
 RenderOpShader::RenderOpShader(const IShader &shader_):
+    RenderOp(Type::Shader),
     shader(&shader_),
     instance_uniform_data(shader->get_num_UBs())
 {
@@ -127,11 +244,13 @@ kx::kx_span<uint8_t> RenderOpShader::map_instance_uniform(size_t uniform_id)
     return to_span<uint8_t>(instance_uniform_data[uniform_id]);
 }
 
-FontAtlas::FontAtlas(kx::gfx::Renderer *rdr, kx::gfx::Font *font):
-    atlas(rdr->make_ascii_atlas(font, kx::gfx::Font::MAX_FONT_SIZE))
+FontAtlas::FontAtlas(kx::gfx::Renderer *rdr, kx::gfx::Font *font, int id_):
+    atlas(rdr->make_ascii_atlas(font, kx::gfx::Font::MAX_FONT_SIZE)),
+    id(id_)
 {}
 
 RenderOpText::RenderOpText():
+    RenderOp(Type::Text),
     font(nullptr),
     color(kx::gfx::Color::BLACK),
     font_size(std::numeric_limits<decltype(font_size)>::quiet_NaN()),
@@ -262,17 +381,17 @@ void RenderOpText::add_iu_data(std::vector<float> *iu_data,
 }
 
 RenderOpGroup::RenderOpGroup(float priority_):
-    priority(priority_)
+    priority(priority_),
+    seq(0)
 {}
 void RenderOpGroup::add_op(const std::shared_ptr<RenderOp> &op)
 {
-    if(empty()) {
-        if(auto shader_op = dynamic_cast<RenderOpShader*>(op.get()))
-            op_cmp = shader_op->shader;
-        else op_cmp = nullptr;
-    }
     ops.push_back(op);
 }
+void RenderOpGroup::set_seq(uint64_t seq_)
+{
+    seq = seq_;
+}
 void RenderOpGroup::clear()
 {
     ops.clear();
@@ -282,16 +401,85 @@ bool RenderOpGroup::empty() const
     return ops.empty();
 }
 
+RenderOpArena::RenderOpArena():
+    data_size(0),
+    group_priority(0),
+    group_seq(0),
+    group_shader(0),
+    group_font(0),
+    group_begin(0)
+{}
+RenderOpRecord &RenderOpArena::add_record()
+{
+    RenderOpRecord rec;
+    rec.priority = group_priority;
+    rec.group_shader = group_shader;
+    rec.group_font = group_font;
+    rec.data_offset = data_size;
+    rec.seq = group_seq;
+    rec.shader = nullptr;
+    rec.text = nullptr;
+    records.push_back(rec);
+    return records.back();
+}
+void RenderOpArena::begin_group(float priority, uint64_t seq)
+{
+    group_priority = priority;
+    group_seq = seq;
+    group_begin = records.size();
+}
+kx::kx_span<uint8_t> RenderOpArena::add_shader_op(const IShader &shader)
+{
+    if(records.size() == group_begin) {
+        k_expects(shader.get_id() >= 0 && shader.get_id() < 0xfff);
+        group_shader = shader.get_id() + 1;
+        group_font = 0;
+    }
+    auto &rec = add_record();
+    rec.shader = &shader;
+
+    size_t size = shader.get_instance_data_size();
+    if(data_size + size > instance_data.size())
+        instance_data.resize(std::max(2 * instance_data.size(), data_size + size));
+    data_size += size;
+    return {instance_data.data() + rec.data_offset, instance_data.data() + data_size};
+}
+void RenderOpArena::add_text_op(const RenderOpText &op)
+{
+    if(records.size() == group_begin) {
+        k_expects(op.font->id >= 0 && op.font->id < 0xff);
+        group_shader = 0;
+        group_font = op.font->id + 1;
+    }
+    add_record().text = &op;
+}
+void RenderOpArena::clear()
+{
+    records.clear();
+    data_size = 0;
+    group_begin = 0;
+}
+bool RenderOpArena::empty() const
+{
+    return records.empty();
+}
+
 RenderSceneGraph::RenderSceneGraph():
     cur_renderer(nullptr)
 {}
 RenderSceneGraph::~RenderSceneGraph()
 {}
+RenderOpArena *RenderSceneGraph::get_op_arena()
+{
+    return &op_arena;
+}
 
 //these values should correspond to uniform block's properties in the text shader
 constexpr size_t TEXT_IU_FLOATS_PER_INSTANCE = 3*4;
 constexpr size_t TEXT_MAX_INSTANCES = 341;
 constexpr auto TEXT_MAX_FLOATS_PER_BATCH = TEXT_IU_FLOATS_PER_INSTANCE * TEXT_MAX_INSTANCES;
+constexpr auto TEXT_MAX_FLOATS_PER_SSBO_BATCH = TEXT_IU_FLOATS_PER_INSTANCE *
+                                                (MAX_RO_SSBO_SIZE / (TEXT_IU_FLOATS_PER_INSTANCE * sizeof(float)));
 
 void RenderSceneGraph::render_text(kx::gfx::Renderer *rdr,
                                const FontAtlas *font,
@@ -299,33 +487,140 @@ void RenderSceneGraph::render_text(kx::gfx::Renderer *rdr,
 {
     k_expects(font != nullptr);
 
-    rdr->use_shader_program(*text_ascii);
+    //text_ascii_ssbo is only loaded if there's a ring
+    auto ring = ubo_allocator->get_ring();
+    bool use_ssbo = text_ascii_ssbo != nullptr;
+    auto program = use_ssbo? text_ascii_ssbo.get(): text_ascii.get();
+    auto max_floats = use_ssbo? TEXT_MAX_FLOATS_PER_SSBO_BATCH: TEXT_MAX_FLOATS_PER_BATCH;
+
+    rdr->use_shader_program(*program);
     rdr->set_active_texture(0);
     rdr->bind_texture(*font->atlas->texture);
-    text_ascii->set_uniform1i(text_ascii_atlas_loc, 0);
-
-    for(size_t start_idx=0; start_idx < text_iu_data.size(); start_idx += TEXT_MAX_FLOATS_PER_BATCH) {
-        auto end_idx = std::min(text_iu_data.size(), start_idx + TEXT_MAX_FLOATS_PER_BATCH);
-        auto num_instances = end_idx / TEXT_IU_FLOATS_PER_INSTANCE;
-
-        auto ubo = ubo_allocator->get_UBO();
-        rdr->bind_UBO(*ubo);
-        ubo->invalidate();
-        ubo->buffer_sub_data(0, text_iu_data.data() + start_idx, (end_idx - start_idx) * sizeof(float));
-        rdr->bind_UB_base(0, *ubo);
-        text_ascii->bind_UB(text_ascii_characters_ub_index, 0);
+    program->set_uniform1i(use_ssbo? text_ascii_ssbo_atlas_loc: text_ascii_atlas_loc, 0);
+
+    for(size_t start_idx=0; start_idx < text_iu_data.size(); start_idx += max_floats) {
+        auto end_idx = std::min(text_iu_data.size(), start_idx + max_floats);
+        auto num_instances = (end_idx - start_idx) / TEXT_IU_FLOATS_PER_INSTANCE;
+
+        auto src = text_iu_data.data() + start_idx;
+        auto n = (end_idx - start_idx) * sizeof(float);
+        if(use_ssbo) {
+            uint32_t offset;
+            std::copy_n((const uint8_t*)src, n, ring->alloc(n, &offset));
+            rdr->bind_SSB_range(0, *ring, offset, n);
+            program->bind_SSB(text_ascii_ssbo_characters_ssb_index, 0);
+        } else {
+            if(ring != nullptr) {
+                uint32_t offset;
+                std::copy_n((const uint8_t*)src, n, ring->alloc(n, &offset));
+                rdr->bind_UB_range(0, *ring, offset, MAX_RO_UBO_SIZE);
+            } else {
+                auto ubo = ubo_allocator->get_UBO();
+                rdr->bind_UBO(*ubo);
+                ubo->invalidate();
+                ubo->buffer_sub_data(0, src, n);
+                rdr->bind_UB_base(0, *ubo);
+            }
+            program->bind_UB(text_ascii_characters_ub_index, 0);
+        }
         rdr->draw_arrays_instanced(kx::gfx::DrawMode::TriangleStrip, 0, 4, num_instances);
     }
 }
 
-void RenderSceneGraph::render_and_clear_vec(std::vector<std::shared_ptr<RenderOpGroup>> *op_groups_vec,
-                                        kx::gfx::KWindowRunning *kwin_r,
+uint64_t RenderSceneGraph::make_sort_key(const RenderOpRecord &rec, int priority_rank)
+{
+    //bits 52-63 are the priority's rank, 40-51 the group's first shader, 32-39 its first
+    //font and 0-31 the seq (which only wraps after 2^32 map objects). The shader order is
+    //flipped for every other priority, so the last shader of one priority is the first of
+    //the next one, and can keep batching.
+    uint64_t shader = rec.group_shader;
+    if(priority_rank & 1)
+        shader = 0xfff - shader;
+    return ((uint64_t)priority_rank << 52) |
+           (shader << 40) |
+           ((uint64_t)rec.group_font << 32) |
+           (uint32_t)rec.seq;
+}
+void RenderSceneGraph::sort_records()
+{
+    const auto &records = op_arena.records;
+
+    //there are only a few different priorities, so they fit in a few bits once
+    //they're replaced by their rank
+    priorities.clear();
+    for(const auto &rec: records) {
+        if(priorities.empty() || priorities.back() != rec.priority)
+            priorities.push_back(rec.priority);
+    }
+    std::sort(priorities.begin(), priorities.end());
+    priorities.erase(std::unique(priorities.begin(), priorities.end()), priorities.end());
+    k_expects(priorities.size() <= 0xfff);
+
+    sort_keys.clear();
+    sorted_records.clear();
+    int priority_rank = 0;
+    for(uint32_t i=0; i<records.size(); i++) {
+        if(i==0 || records[i].priority != records[i-1].priority) {
+            priority_rank = std::lower_bound(priorities.begin(), priorities.end(), records[i].priority) -
+                            priorities.begin();
+        }
+        sort_keys.push_back(make_sort_key(records[i], priority_rank));
+        sorted_records.push_back(i);
+    }
+
+    //the sort is stable, so each group stays together and in order
+    lsd_radix_sort64_u_kv(sort_keys.data(), sorted_records.data(), sort_keys.size(),
+                          &sort_key_buf, &sorted_records_buf);
+}
+void RenderSceneGraph::make_batches()
+{
+    const auto &records = op_arena.records;
+    sort_records();
+
+    batches.clear();
+    batch_data_offsets.clear();
+    batch_text_ops.clear();
+    for(auto rec_idx: sorted_records) {
+        const auto &rec = records[rec_idx];
+        if(rec.shader != nullptr) {
+            if(batches.empty() || batches.back().shader != rec.shader ||
+               batches.back().end - batches.back().begin == (uint32_t)rec.shader->get_max_instances())
+            {
+                uint32_t begin = batch_data_offsets.size();
+                batches.push_back(Batch{rec.shader, nullptr, begin, begin});
+            }
+            batch_data_offsets.push_back(rec.data_offset);
+        } else {
+            if(batches.empty() || batches.back().shader != nullptr || batches.back().font != rec.text->font) {
+                uint32_t begin = batch_text_ops.size();
+                batches.push_back(Batch{nullptr, rec.text->font, begin, begin});
+            }
+            batch_text_ops.push_back(rec.text);
+        }
+        batches.back().end++;
+    }
+}
+void RenderSceneGraph::render_batches(kx::gfx::Renderer *rdr)
+{
+    const uint8_t *instance_data = op_arena.instance_data.data();
+    for(const auto &batch: batches) {
+        if(batch.shader != nullptr) {
+            kx::kx_span<const uint32_t> spn(batch_data_offsets.data() + batch.begin,
+                                            batch_data_offsets.data() + batch.end);
+            batch.shader->render(ubo_allocator.get(), instance_data, spn, &shader_ub_buffer, rdr, {});
+        } else {
+            text_iu_data.clear();
+            for(uint32_t i=batch.begin; i<batch.end; i++)
+                batch_text_ops[i]->add_iu_data(&text_iu_data, rdr, {});
+            if(!text_iu_data.empty())
+                render_text(rdr, batch.font, text_iu_data);
+        }
+    }
+}
+void RenderSceneGraph::render_and_clear(kx::gfx::KWindowRunning *kwin_r,
                                         [[maybe_unused]] int render_w,
                                         [[maybe_unused]] int render_h)
 {
-    //mutable reference!
-    auto &op_groups = *op_groups_vec;
-
     auto rdr = kwin_r->rdr();
 
     if(cur_renderer != rdr) {
@@ -337,73 +632,51 @@ void RenderSceneGraph::render_and_clear_vec(std::vector<std::shared_ptr<RenderOp
         text_ascii = rdr->make_shader_program(*vert, *frag);
         text_ascii_characters_ub_index = text_ascii->get_UB_index("characters");
         text_ascii_atlas_loc = text_ascii->get_uniform_loc("atlas");
+
+        text_ascii_ssbo = nullptr;
+        if(rdr->supports_SSBOs() && ubo_allocator->get_ring() != nullptr) {
+            auto vert_ssbo = rdr->make_vert_shader("geo2_data/shaders/text_ascii_1_ssbo.vert");
+            auto frag_ssbo = rdr->make_frag_shader("geo2_data/shaders/text_ascii_1_ssbo.frag");
+            text_ascii_ssbo = rdr->make_shader_program(*vert_ssbo, *frag_ssbo);
+            text_ascii_ssbo_characters_ssb_index = text_ascii_ssbo->get_SSB_index("characters");
+            text_ascii_ssbo_atlas_loc = text_ascii_ssbo->get_uniform_loc("atlas");
+        }
     }
 
-    auto cmp_op_group = [](const std::shared_ptr<RenderOpGroup> &a,
-                           const std::shared_ptr<RenderOpGroup> &b) ->
-                                bool
-                           {
-                               //sort by priority, then by op/
-                               //this could be further optimized by alternating
-                               //between using "<" and ">" for op; this requires us
-                               //to know the priority rank beforehand.
-                               if(a->priority != b->priority)
-                                    return a->priority < b->priority;
-                               return a->op_cmp < b->op_cmp;
-                           };
-    //sort groups by priority
-    std::sort(op_groups.begin(), op_groups.end(), cmp_op_group);
-
-    const IShader *cur_shader = nullptr;
-    std::vector<const ByteFSA2D*> shader_iu_data;
-
-    const FontAtlas *cur_font = nullptr;
-    std::vector<float> text_iu_data;
-
-    for(size_t i=0; i<op_groups.size(); i++) {
-        for(const auto &op: op_groups[i]->ops) {
-            if(auto shader_op = dynamic_cast<RenderOpShader*>(op.get())) {
-                if(cur_shader!=nullptr) {
-                   if(shader_iu_data.size()==(size_t)shader_op->shader->get_max_instances() ||
-                    cur_shader!=shader_op->shader)
-                    {
-                        kx::kx_span<const ByteFSA2D*> spn(shader_iu_data.begin(), shader_iu_data.end());
-                        cur_shader->render(ubo_allocator.get(), spn, rdr, {});
-                        shader_iu_data.clear();
-                    }
-                } else if(!text_iu_data.empty()) {
-                    render_text(rdr, cur_font, text_iu_data);
-                    text_iu_data.clear();
-                    cur_font = nullptr;
-                }
-                cur_shader = shader_op->shader;
-                shader_iu_data.push_back(&shader_op->instance_uniform_data);
-            } else if(auto text_op = dynamic_cast<RenderOpText*>(op.get())) {
-                if(cur_shader != nullptr) {
-                    kx::kx_span<const ByteFSA2D*> spn(shader_iu_data.begin(), shader_iu_data.end());
-                    cur_shader->render(ubo_allocator.get(), spn, rdr, {});
-                    cur_shader = nullptr;
-                    shader_iu_data.clear();
-                }
-                if(!text_iu_data.empty() && cur_font!=text_op->font) {
-                    render_text(rdr, cur_font, text_iu_data);
-                    text_iu_data.clear();
-                }
-                cur_font = text_op->font;
-                text_op->add_iu_data(&text_iu_data, rdr, {});
-            } else {
-                kx::log_error("unknown RenderOp type");
+    make_batches();
+    render_batches(rdr);
+    ubo_allocator->fence();
+    op_arena.clear();
+}
+void RenderSceneGraph::render_and_clear_vec(std::vector<std::shared_ptr<RenderOpGroup>> *op_groups_vec,
+                                            kx::gfx::KWindowRunning *kwin_r,
+                                            int render_w,
+                                            int render_h)
+{
+    //mutable reference!
+    auto &op_groups = *op_groups_vec;
+
+    for(const auto &op_group: op_groups) {
+        op_arena.begin_group(op_group->priority, op_group->seq);
+        for(const auto &op: op_group->ops) {
+            switch(op->get_type()) {
+            case RenderOp::Type::Shader: {
+                auto shader_op = static_cast<const RenderOpShader*>(op.get());
+                auto iu = op_arena.add_shader_op(*shader_op->shader);
+                auto dst = iu.begin();
+                for(const auto &ub_data: shader_op->instance_uniform_data)
+                    dst = std::copy(ub_data.begin(), ub_data.end(), dst);
+                break;
+            }
+            case RenderOp::Type::Text:
+                op_arena.add_text_op(*static_cast<const RenderOpText*>(op.get()));
+                break;
             }
         }
     }
 
-    //render any buffered data
-    if(cur_shader != nullptr) {
-        kx::kx_span<const ByteFSA2D*> spn(shader_iu_data.begin(), shader_iu_data.end());
-        cur_shader->render(ubo_allocator.get(), spn, rdr, {});
-    } else if(!text_iu_data.empty()) {
-        render_text(rdr, cur_font, text_iu_data);
-    }
+    //the text ops are only referenced by the arena, so op_groups has to live until here
+    render_and_clear(kwin_r, render_w, render_h);
     op_groups.clear();
 }
 
@@ -14,48 +14,84 @@
 namespace kx { namespace gfx {
     class Renderer;
     class ShaderProgram;
+    class BufferRing;
     class KWindowRunning;
     struct ASCII_Atlas;
     using UBIndex = unsigned; //this is static asserted in the cpp file.
+    using SSBIndex = unsigned; //so is this
 }}
 
 namespace geo2 {
 
 constexpr int MAX_RO_NUM_UBOS = 16;
 constexpr int MAX_RO_UBO_SIZE = 1<<14;
+///a batch's data for one SSBO; batches are only split this finely so they fit in the BufferRing
+constexpr int MAX_RO_SSBO_SIZE = 1<<20;
 
 class UBO_Allocator;
 
 class IShader final
 {
 private:
-    template<class T> using FSA = kx::FixedSizeArray<T>;
     //Each UB has some global data at the beginning, then up to
-    //MAX_INSTANCES blocks of instance data
+    //MAX_INSTANCES blocks of instance data. In the SSBO variant of the program, it's an SSB
+    //with the same name and layout, except the instance data array is unsized.
     struct UB
     {
         kx::gfx::UBIndex index;
+        kx::gfx::SSBIndex ssb_index;
         int global_data_size; //bytes
         int instance_data_size; //bytes
+        int instance_data_offset; //bytes into an op's instance data
     };
 
     std::shared_ptr<kx::gfx::ShaderProgram> program;
-    int max_instances;
+    std::shared_ptr<kx::gfx::ShaderProgram> ssbo_program;
+    int id;
+    int max_instances; //in the UBO program
+    int max_ssbo_instances; //what fits in MAX_RO_SSBO_SIZE
     kx::gfx::DrawMode draw_mode;
     int count;
     std::vector<UB> UBs;
+    int instance_data_size; //bytes; all UBs' instance data, one after the other
+
+    ///copies UB i's part of each op's instance data to dst, one after the other
+    void gather_UB(size_t i, const uint8_t *instance_data, kx::kx_span<const uint32_t> data_offsets,
+                   uint8_t *dst) const;
+    void render_UBOs(UBO_Allocator *ubo_allocator,
+                     const uint8_t *instance_data,
+                     kx::kx_span<const uint32_t> data_offsets,
+                     std::vector<uint8_t> *buffer,
+                     kx::gfx::Renderer *rdr) const;
+    void render_SSBOs(kx::gfx::BufferRing *ring,
+                      const uint8_t *instance_data,
+                      kx::kx_span<const uint32_t> data_offsets,
+                      kx::gfx::Renderer *rdr) const;
 public:
+    ///id is what groups of ops are sorted by, so it should be unique among the shaders;
+    ///program can be null if the shader is never rendered (e.g. in CPU-side benchmarks).
+    ///If there's an ssbo_program, it's used instead whenever there's a BufferRing, so
+    ///batches aren't limited to max_instances
     IShader(const std::shared_ptr<kx::gfx::ShaderProgram> &program_,
+            int id_,
             int max_instances_,
             const kx::gfx::DrawMode draw_mode_,
-            int count_);
+            int count_,
+            const std::shared_ptr<kx::gfx::ShaderProgram> &ssbo_program_ = nullptr);
 
     void add_UB(std::string_view name, int global_data_sz, int instance_data_sz);
     size_t get_num_UBs() const;
     int get_instance_uniform_size_bytes(size_t idx) const;
+    int get_instance_data_size() const;
+    int get_id() const;
+    ///the most ops a batch can have
     int get_max_instances() const;
+    ///renders the ops whose instance data is at data_offsets (bytes) in instance_data;
+    ///buffer is where each UB's data is put together, so it doesn't have to be allocated
     void render(UBO_Allocator *ubo_allocator,
-                kx::kx_span<const FSA<FSA<uint8_t>>*> instance_uniform_data,
+                const uint8_t *instance_data,
+                kx::kx_span<const uint32_t> data_offsets,
+                std::vector<uint8_t> *buffer,
                 kx::gfx::Renderer *rdr,
                 kx::Passkey<class RenderSceneGraph>) const;
 
@@ -66,8 +102,18 @@ public:
 
 class RenderOp
 {
+public:
+    ///so ops can be told apart without RTTI
+    enum class Type: uint8_t {
+        Shader, Text
+    };
+private:
+    Type type;
+protected:
+    RenderOp(Type type_);
 public:
     virtual ~RenderOp() = default;
+    Type get_type() const;
 };
 
 /** note we have a non-owning pointer here (IShader *shader); it's assumed that while
@@ -91,13 +137,15 @@ public:
 struct FontAtlas
 {
     std::unique_ptr<kx::gfx::ASCII_Atlas> atlas;
+    int id; //like IShader's
 
-    FontAtlas(kx::gfx::Renderer *rdr, kx::gfx::Font *font_);
+    FontAtlas(kx::gfx::Renderer *rdr, kx::gfx::Font *font_, int id_);
 };
 
 class RenderOpText final: public RenderOp
 {
     friend class RenderSceneGraph;
+    friend class RenderOpArena;
 public:
     enum class HorizontalAlign: uint8_t {
         Left, Center, Right
@@ -136,30 +184,125 @@ class RenderOpGroup final
     friend class RenderSceneGraph;
 
     float priority;
-    const IShader *op_cmp;
+    uint64_t seq; //breaks ties between groups with the same priority and first op
     std::vector<std::shared_ptr<RenderOp>> ops;
 public:
     RenderOpGroup(float priority_);
     void add_op(const std::shared_ptr<RenderOp> &op);
+    void set_seq(uint64_t seq_);
+    void clear();
+    bool empty() const;
+};
+
+/** An op in a RenderOpArena. It's POD, so adding one is just a write and sorting them
+ *  doesn't touch anything else.
+ */
+struct RenderOpRecord
+{
+    float priority;
+    //the first op in the group: its shader's id + 1 and 0 if it's text, or its font's id + 1
+    //and 0 if it's not
+    uint16_t group_shader;
+    uint16_t group_font;
+    uint32_t data_offset; //bytes into the arena's instance data
+    uint64_t seq;
+    const IShader *shader; //nullptr for text ops
+    const RenderOpText *text;
+};
+
+/** The ops for one call to RenderSceneGraph::render_and_clear(). Ops are added in groups,
+ *  which work like RenderOpGroups: a group's ops are rendered one after another, in the
+ *  order they were added, and groups are sorted by priority, their first op and seq
+ *  (see RenderSceneGraph::make_sort_key()).
+ *  Instance data is written straight into one contiguous buffer, and the arena is reset
+ *  (keeping its memory) once it's rendered, so adding ops doesn't allocate once it has
+ *  grown to the size of a frame.
+ */
+class RenderOpArena final
+{
+    friend class RenderSceneGraph;
+
+    std::vector<RenderOpRecord> records;
+    std::vector<uint8_t> instance_data;
+    size_t data_size; //bytes of instance_data that are used
+
+    float group_priority;
+    uint64_t group_seq;
+    uint16_t group_shader;
+    uint16_t group_font;
+    size_t group_begin; //the first record of the group
+
+    RenderOpRecord &add_record();
+public:
+    RenderOpArena();
+
+    void begin_group(float priority, uint64_t seq);
+    ///returns the op's instance data (each UB's, one after the other), which has to be
+    ///filled in before another op is added, since the span is invalidated then
+    kx::kx_span<uint8_t> add_shader_op(const IShader &shader);
+    ///the op isn't copied, so it has to live until the arena is rendered
+    void add_text_op(const RenderOpText &op);
     void clear();
     bool empty() const;
 };
 
 class RenderSceneGraph
 {
+    friend class GameBenchmark;
+
+    ///ops that are drawn together; text batches can still take several draw calls
+    struct Batch
+    {
+        const IShader *shader; //nullptr for text
+        const FontAtlas *font;
+        uint32_t begin; //into batch_data_offsets, or batch_text_ops for text
+        uint32_t end;
+    };
+
     kx::gfx::UBIndex text_ascii_characters_ub_index;
     int text_ascii_atlas_loc;
     std::unique_ptr<kx::gfx::ShaderProgram> text_ascii;
+    //used instead if it's there, which is when there's a BufferRing and SSBOs are supported
+    kx::gfx::SSBIndex text_ascii_ssbo_characters_ssb_index;
+    int text_ascii_ssbo_atlas_loc;
+    std::unique_ptr<kx::gfx::ShaderProgram> text_ascii_ssbo;
 
     kx::gfx::Renderer *cur_renderer;
 
     std::unique_ptr<UBO_Allocator> ubo_allocator;
 
+    RenderOpArena op_arena;
+    //these persist across frames to save memory allocations
+    std::vector<float> priorities;
+    std::vector<uint64_t> sort_keys;
+    std::vector<uint32_t> sorted_records;
+    std::vector<uint64_t> sort_key_buf;
+    std::vector<uint32_t> sorted_records_buf;
+    std::vector<Batch> batches;
+    std::vector<uint32_t> batch_data_offsets;
+    std::vector<const RenderOpText*> batch_text_ops;
+    std::vector<uint8_t> shader_ub_buffer;
+    std::vector<float> text_iu_data;
+
+    ///priority_rank is the rank of rec's priority among the priorities in the arena
+    static uint64_t make_sort_key(const RenderOpRecord &rec, int priority_rank);
+    ///sorts the arena's records into sorted_records (indices)
+    void sort_records();
+    ///sorts the arena's ops into batches; this is everything that doesn't need a renderer
+    void make_batches();
+    void render_batches(kx::gfx::Renderer *rdr);
     void render_text(kx::gfx::Renderer *rdr, const FontAtlas *font, const std::vector<float> &text_iu_data);
 public:
     RenderSceneGraph();
     virtual ~RenderSceneGraph();
 
+    ///ops added here are rendered by the next call to render_and_clear()
+    RenderOpArena *get_op_arena();
+    ///renders the ops in the arena, then clears it
+    void render_and_clear(kx::gfx::KWindowRunning *kwin_r,
+                          int render_w,
+                          int render_h);
+    ///adds the ops in op_groups_vec to the arena, then calls render_and_clear()
     void render_and_clear_vec(std::vector<std::shared_ptr<RenderOpGroup>> *op_groups_vec,
                               kx::gfx::KWindowRunning *kwin_r,
                               int render_w,
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <profileapi.h>
 
 namespace geo2 {
@@ -1,5 +1,4 @@
 #include "geo2/weapon/laser_1.h"
-#include "geo2/map_obj/projectile_type1/laser_proj_1.h"
 
 #include <random>
 
@@ -54,7 +53,7 @@ void TestLaser1::run(const WeaponRunArgs &args)
 
     if(args.primary_attack()) {
         while(reload_counter <= 0) {
-            auto mobj = std::dynamic_pointer_cast<map_obj::MapObject>(owner_shared_ptr);
+            auto mobj = dynamic_cast<const map_obj::MapObject*>(owner_shared_ptr.get());
             k_expects(mobj != nullptr);
 
             auto dx = std::cos(args.angle);
@@ -65,29 +64,25 @@ void TestLaser1::run(const WeaponRunArgs &args)
             kx::gfx::LinearColor inner_color = get_supercharge_color(supercharge_counter);
             kx::gfx::LinearColor outer_color(0.5*inner_color.r, 0.5*inner_color.g, 0.5*inner_color.b, 0.9);
 
-            auto proj = std::make_unique<map_obj::LaserProj_1>
-                            (mobj,
-                             damage,
-                             LIFESPAN,
-                             owner_info.position + MapVec(dx, dy) * (owner_info.offset_from_center + 0.35),
-                             MapVec(dx, dy) * PROJ_SPEED,
-                             inner_color,
-                             outer_color,
-                             std::uniform_real_distribution<double>(0, 2*M_PI)(*args.get_rng()));
-
-            args.add_map_obj(std::move(proj));
+            ProjectileSpawnInfo proj;
+            proj.pos = owner_info.position + MapVec(dx, dy) * (owner_info.offset_from_center + 0.35);
+            proj.velocity = MapVec(dx, dy) * PROJ_SPEED;
+            proj.damage = damage;
+            proj.lifespan = LIFESPAN;
+            proj.rot = std::uniform_real_distribution<double>(0, 2*M_PI)(*args.get_rng());
+            proj.inner_color = inner_color;
+            proj.outer_color = outer_color;
+            proj.team = mobj->get_team();
+
+            args.add_projectile(proj);
             reload_counter += FIRE_INTERVAL;
         }
     }
 }
 void TestLaser1::render(const WeaponRenderArgs &args)
 {
-    if(ops[0] == nullptr) {
-        for(int i=0; i<2; i++) {
-            ops[i] = std::make_shared<RenderOpShader>(*args.shaders->get("laser_1"));
-            auto iu_map = ops[i]->map_instance_uniform(0);
-            op_ius[i] = {(float*)iu_map.begin(), (float*)iu_map.end()};
-        }
+    if(shader == nullptr) {
+        shader = args.shaders->get("laser_1");
 
         //op 1
         //color 1
@@ -124,9 +119,9 @@ void TestLaser1::render(const WeaponRenderArgs &args)
     MapVec offset[]{{owner_info.offset_from_center, 0.0f}, {owner_info.offset_from_center + 0.35f, 0.0f}};
 
     for(int i=0; i<2; i++) {
-        auto v0_rot = owner_info.position + rot_mat * (v0[i] + offset[i]);
-        auto v1_rot = owner_info.position + rot_mat * (v1[i] + offset[i]);
-        auto v2_rot = owner_info.position + rot_mat * (v2[i] + offset[i]);
+        auto v0_rot = args.owner_position + rot_mat * (v0[i] + offset[i]);
+        auto v1_rot = args.owner_position + rot_mat * (v1[i] + offset[i]);
+        auto v2_rot = args.owner_position + rot_mat * (v2[i] + offset[i]);
 
         op_ius[i][0] = args.x_to_ndc(v0_rot.x);
         op_ius[i][1] = args.y_to_ndc(v0_rot.y);
@@ -135,7 +130,7 @@ void TestLaser1::render(const WeaponRenderArgs &args)
         op_ius[i][4] = args.x_to_ndc(v2_rot.x);
         op_ius[i][5] = args.y_to_ndc(v2_rot.y);
 
-        args.add_render_op(ops[i]);
+        args.add_op(*shader, op_ius[i]);
     }
 }
 void TestLaser1::start_new_level([[maybe_unused]] const WeaponStartNewLevelArgs &args)
@@ -12,8 +12,8 @@ class TestLaser1 final: public Weapon
     int ammo;
     double supercharge_counter;
 
-    std::array<std::shared_ptr<RenderOpShader>, 2> ops;
-    std::array<kx::kx_span<float>, 2> op_ius;
+    const IShader *shader = nullptr;
+    std::array<std::array<float, 16>, 2> op_ius{};
 public:
     TestLaser1(const std::shared_ptr<WeaponOwner> &owner_z);
     void run(const WeaponRunArgs &args) override;
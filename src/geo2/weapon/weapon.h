@@ -3,6 +3,7 @@
 #include "kx/gfx/gfx.h"
 #include "geo2/geometry.h"
 #include "geo2/map_obj/map_object.h"
+#include "geo2/projectile_system.h"
 #include "geo2/game_render_scene_graph.h"
 #include "geo2/render_args.h"
 #include "geo2/rng_args.h"
@@ -63,6 +64,7 @@ public:
 class WeaponRunArgs final: public RNG_Args
 {
     std::vector<std::shared_ptr<map_obj::MapObject>> *map_objs_to_add;
+    ProjectileSystem *projectiles;
 public:
     MapCoord cursor_pos;
     double angle;
@@ -86,26 +88,26 @@ public:
     {
         map_objs_to_add->push_back(obj);
     }
+    inline void set_projectiles(ProjectileSystem *projectiles_)
+    {
+        projectiles = projectiles_;
+    }
+    inline void add_projectile(const ProjectileSpawnInfo &info) const
+    {
+        projectiles->spawn(info);
+    }
 };
 
-/** Take care when rendering a weapon; the parent has to clear RenderOpGroup every
- *  time! This is because Weapon modifies the RenderOpGroups you give it, so the
- *  parent (e.g. Player_Type1) can't just cache the RenderOpGroup and keep reusing it.
+/** The weapon's ops are added to the op group the parent (e.g. Player_Type1) has begun,
+ *  so they're rendered right after the parent's own ops.
  */
 class WeaponRenderArgs final: public RenderArgs
 {
-    RenderOpGroup *op_group;
 public:
     double angle;
     float render_priority;
-    inline void set_op_group(RenderOpGroup *group)
-    {
-        op_group = group;
-    }
-    inline void add_render_op(const std::shared_ptr<RenderOpShader> &op) const
-    {
-        op_group->add_op(op);
-    }
+    ///interpolated like the owner's own render ops, so the weapon doesn't lag behind it
+    MapCoord owner_position;
     inline void set_render_args(const RenderArgs &args)
     {
         *static_cast<RenderArgs*>(this) = args;
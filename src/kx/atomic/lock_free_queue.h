@@ -0,0 +1,155 @@
+#pragma once
+
+#include "kx/multithread/spinlock_wait_strategy.h"
+#include "kx/debug.h"
+#include "kx/util.h"
+
+#include <xmmintrin.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <cstdint>
+
+namespace kx {
+
+/** A bounded multi-producer multi-consumer queue that doesn't take any locks (Dmitry
+ *  Vyukov's ring buffer): every slot has a sequence number that says whether it's ready to
+ *  be written or read in the current lap, so producers and consumers only contend on their
+ *  own position counter.
+ *  It has the same interface as AtomicQueue, but the capacity is fixed: push() spins while
+ *  the queue is full, and poll_blocking() spins while it's empty, so use AtomicQueue if a
+ *  thread might have to wait for a long time. T has to be default constructible.
+ */
+template<class T, SpinlockWaitStrategy wait_strategy = SpinlockWaitStrategy::mm_pause>
+class LockFreeQueue final
+{
+    static constexpr size_t CACHE_LINE_LEN = 64;
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T val;
+    };
+    std::unique_ptr<Slot[]> slots;
+    size_t mask;
+
+    alignas(CACHE_LINE_LEN) std::atomic<size_t> push_pos;
+    alignas(CACHE_LINE_LEN) std::atomic<size_t> pop_pos;
+
+    inline void spin_wait()
+    {
+        if constexpr(wait_strategy == SpinlockWaitStrategy::mm_pause)
+            _mm_pause();
+        if constexpr(wait_strategy == SpinlockWaitStrategy::Yield)
+            std::this_thread::yield();
+    }
+    template<class U> bool try_emplace(U &&val)
+    {
+        size_t pos = push_pos.load(std::memory_order_relaxed);
+        while(true) {
+            auto &slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            auto diff = (intptr_t)seq - (intptr_t)pos;
+            if(diff == 0) {
+                //the slot is free in this lap; try to claim it
+                if(push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.val = std::forward<U>(val);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(diff < 0) {
+                //the slot still holds a value from the previous lap, so the queue is full
+                return false;
+            } else {
+                pos = push_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+public:
+    ///capacity is rounded up to a power of 2
+    LockFreeQueue(size_t capacity = 1024):
+        push_pos(0),
+        pop_pos(0)
+    {
+        k_expects(capacity >= 1);
+        size_t len = 1;
+        while(len < capacity)
+            len *= 2;
+        mask = len - 1;
+        slots = std::make_unique<Slot[]>(len);
+        for(size_t i=0; i<len; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue &operator = (const LockFreeQueue&) = delete;
+    LockFreeQueue(LockFreeQueue&&) = delete;
+    LockFreeQueue &operator = (LockFreeQueue&&) = delete;
+
+    ///returns false (and leaves val alone) if the queue is full
+    bool try_push(const T &val)
+    {
+        return try_emplace(val);
+    }
+    bool try_push(T &&val)
+    {
+        return try_emplace(std::move(val));
+    }
+    void push(const T &val)
+    {
+        while(!try_emplace(val))
+            spin_wait();
+    }
+    void push(T &&val)
+    {
+        while(!try_emplace(std::move(val)))
+            spin_wait();
+    }
+    bool poll_if_nonempty(T *return_holder)
+    {
+        size_t pos = pop_pos.load(std::memory_order_relaxed);
+        while(true) {
+            auto &slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            auto diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if(diff == 0) {
+                if(pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    *return_holder = std::move(slot.val);
+                    //free the slot for the next lap
+                    slot.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(diff < 0) {
+                //nothing has been pushed into this slot yet
+                return false;
+            } else {
+                pos = pop_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    T poll_blocking()
+    {
+        T ret;
+        while(!poll_if_nonempty(&ret))
+            spin_wait();
+        return ret;
+    }
+    ///only a snapshot; another thread can change it right away
+    bool empty() const
+    {
+        return size() == 0;
+    }
+    size_t size() const
+    {
+        size_t pop = pop_pos.load(std::memory_order_acquire);
+        size_t push = push_pos.load(std::memory_order_acquire);
+        return push > pop? push - pop: 0;
+    }
+    size_t capacity() const
+    {
+        return mask + 1;
+    }
+};
+
+}
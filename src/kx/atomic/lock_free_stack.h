@@ -0,0 +1,172 @@
+#pragma once
+
+#include "kx/multithread/spinlock_wait_strategy.h"
+#include "kx/debug.h"
+#include "kx/util.h"
+
+#include <xmmintrin.h>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <cstdint>
+
+namespace kx {
+
+/** A bounded stack that doesn't take any locks (a Treiber stack).
+ *  The nodes live in one array and are never freed; unused ones are kept in a second
+ *  Treiber stack. The heads of both stacks are a node index plus a tag that's incremented
+ *  on every change, packed into 64 bits, so a compare-exchange fails if the head was
+ *  popped and pushed back in the meantime (the ABA problem).
+ *  It has the same interface as AtomicStack, but the capacity is fixed and push() spins
+ *  while the stack is full. T has to be default constructible.
+ */
+template<class T, SpinlockWaitStrategy wait_strategy = SpinlockWaitStrategy::mm_pause>
+class LockFreeStack final
+{
+    static constexpr size_t CACHE_LINE_LEN = 64;
+    static constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+    struct Node
+    {
+        std::atomic<uint32_t> next;
+        T val;
+    };
+    std::unique_ptr<Node[]> nodes;
+    uint32_t num_nodes;
+
+    //(tag << 32) | index of the first node
+    alignas(CACHE_LINE_LEN) std::atomic<uint64_t> head;
+    alignas(CACHE_LINE_LEN) std::atomic<uint64_t> free_head;
+    std::atomic<size_t> num_elems;
+
+    static inline uint64_t make_head(uint32_t idx, uint64_t prev_head)
+    {
+        uint64_t tag = (prev_head >> 32) + 1;
+        return (tag << 32) | idx;
+    }
+    inline void spin_wait()
+    {
+        if constexpr(wait_strategy == SpinlockWaitStrategy::mm_pause)
+            _mm_pause();
+        if constexpr(wait_strategy == SpinlockWaitStrategy::Yield)
+            std::this_thread::yield();
+    }
+    bool pop_node(std::atomic<uint64_t> *list, uint32_t *idx)
+    {
+        uint64_t old_head = list->load(std::memory_order_acquire);
+        while(true) {
+            uint32_t first = (uint32_t)old_head;
+            if(first == NO_NODE)
+                return false;
+            //this can be stale if someone else pops first, but then the tag has changed
+            //and the compare-exchange fails
+            uint32_t next = nodes[first].next.load(std::memory_order_relaxed);
+            if(list->compare_exchange_weak(old_head, make_head(next, old_head),
+                                           std::memory_order_acquire,
+                                           std::memory_order_acquire))
+            {
+                *idx = first;
+                return true;
+            }
+        }
+    }
+    void push_node(std::atomic<uint64_t> *list, uint32_t idx)
+    {
+        uint64_t old_head = list->load(std::memory_order_relaxed);
+        do {
+            nodes[idx].next.store((uint32_t)old_head, std::memory_order_relaxed);
+        } while(!list->compare_exchange_weak(old_head, make_head(idx, old_head),
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+    }
+    template<class U> bool try_emplace(U &&val)
+    {
+        uint32_t idx;
+        if(!pop_node(&free_head, &idx))
+            return false;
+        nodes[idx].val = std::forward<U>(val);
+        //count it before anyone can pop it, so num_elems never goes below 0
+        num_elems.fetch_add(1, std::memory_order_relaxed);
+        push_node(&head, idx);
+        return true;
+    }
+public:
+    LockFreeStack(size_t capacity = 1024):
+        num_nodes(capacity),
+        head(NO_NODE),
+        free_head(NO_NODE),
+        num_elems(0)
+    {
+        k_expects(capacity >= 1 && capacity < NO_NODE);
+        nodes = std::make_unique<Node[]>(num_nodes);
+        for(uint32_t i=0; i<num_nodes; i++)
+            nodes[i].next.store(i+1 == num_nodes? NO_NODE: i+1, std::memory_order_relaxed);
+        free_head.store(0, std::memory_order_relaxed);
+    }
+
+    LockFreeStack(const LockFreeStack&) = delete;
+    LockFreeStack &operator = (const LockFreeStack&) = delete;
+    LockFreeStack(LockFreeStack&&) = delete;
+    LockFreeStack &operator = (LockFreeStack&&) = delete;
+
+    ///returns false (and leaves val alone) if the stack is full
+    bool try_push(const T &val)
+    {
+        return try_emplace(val);
+    }
+    bool try_push(T &&val)
+    {
+        return try_emplace(std::move(val));
+    }
+    void push(const T &val)
+    {
+        while(!try_emplace(val))
+            spin_wait();
+    }
+    void push(T &&val)
+    {
+        while(!try_emplace(std::move(val)))
+            spin_wait();
+    }
+    ///this is the thread safe way to pop; top() followed by pop() is only ok if nobody
+    ///else pops in between (just like with AtomicStack)
+    bool try_pop(T *return_holder)
+    {
+        uint32_t idx;
+        if(!pop_node(&head, &idx))
+            return false;
+        num_elems.fetch_sub(1, std::memory_order_relaxed);
+        *return_holder = std::move(nodes[idx].val);
+        push_node(&free_head, idx);
+        return true;
+    }
+    void pop()
+    {
+        [[maybe_unused]] T popped;
+        [[maybe_unused]] bool was_nonempty = try_pop(&popped);
+        k_expects(was_nonempty);
+    }
+    T &top()
+    {
+        uint32_t first = (uint32_t)head.load(std::memory_order_acquire);
+        k_expects(first != NO_NODE);
+        return nodes[first].val;
+    }
+    ///only a snapshot; another thread can change it right away
+    bool empty() const
+    {
+        return (uint32_t)head.load(std::memory_order_acquire) == NO_NODE;
+    }
+    size_t size() const
+    {
+        return num_elems.load(std::memory_order_relaxed);
+    }
+    size_t capacity() const
+    {
+        return num_nodes;
+    }
+};
+
+}
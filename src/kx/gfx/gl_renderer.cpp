@@ -506,6 +506,16 @@ void ShaderProgram::bind_UB(UBIndex ub_index, GLuint binding)
     glUniformBlockBinding(program.id, ub_index, binding);
 }
 
+SSBIndex ShaderProgram::get_SSB_index(const GLchar *name)
+{
+    return glGetProgramResourceIndex(program.id, GL_SHADER_STORAGE_BLOCK, name);
+}
+
+void ShaderProgram::bind_SSB(SSBIndex ssb_index, GLuint binding)
+{
+    glShaderStorageBlockBinding(program.id, ssb_index, binding);
+}
+
 template<_BufferType T> Buffer<T>::Buffer(Renderer *owner_):
     owner(owner_)
 {
@@ -538,6 +548,81 @@ template<_BufferType T> void Buffer<T>::invalidate()
     glInvalidateBufferData(buffer.id);
 }
 
+BufferRing::BufferRing(GLuint size_, GLuint max_range_size_):
+    mapped(nullptr),
+    size(size_),
+    max_range_size(max_range_size_),
+    head(0),
+    unfenced_begin(0)
+{
+    GLint ubo_align, ssbo_align = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubo_align);
+    if(GLAD_GL_VERSION_4_3)
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ssbo_align);
+    //both are powers of 2
+    alignment = std::max({ubo_align, ssbo_align, 1});
+
+    //coherent, so writes don't have to be flushed before the draw calls that read them
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &buffer.id);
+    glNamedBufferStorage(buffer.id, size + max_range_size, nullptr, flags);
+    mapped = (uint8_t*)glMapNamedBufferRange(buffer.id, 0, size + max_range_size, flags);
+}
+BufferRing::~BufferRing()
+{
+    for(const auto &fence: fences)
+        glDeleteSync((GLsync)fence.sync);
+    if(mapped != nullptr)
+        glUnmapNamedBuffer(buffer.id);
+}
+bool BufferRing::overlaps_live_data(GLuint begin, GLuint n) const
+{
+    //the live data is [tail, head), wrapping around the end
+    if(fences.empty() && unfenced_begin == head)
+        return false;
+    auto tail = fences.empty()? unfenced_begin: fences.front().begin;
+    auto end = begin + n;
+    if(tail < head)
+        return end > tail && begin < head;
+    else
+        return end > tail || begin < head; //if tail == head, everything is live
+}
+void BufferRing::wait_oldest()
+{
+    //if nothing's fenced, the data in the way was written since the last fence()
+    if(fences.empty())
+        fence();
+
+    auto sync = (GLsync)fences.front().sync;
+    //the timeout is 1s, but this only gives up if the wait fails (e.g. the context is lost)
+    while(glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+        {}
+    glDeleteSync(sync);
+    fences.pop_front();
+}
+uint8_t *BufferRing::alloc(GLuint n, GLuint *offset)
+{
+    k_expects(n <= size);
+
+    auto begin = (head + alignment - 1) / alignment * alignment;
+    if(begin + n > size)
+        begin = 0;
+    while(overlaps_live_data(begin, n))
+        wait_oldest();
+    head = begin + n;
+
+    *offset = begin;
+    return mapped + begin;
+}
+void BufferRing::fence()
+{
+    if(unfenced_begin == head)
+        return;
+    auto sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    fences.push_back(Fence{sync, unfenced_begin});
+    unfenced_begin = head;
+}
+
 VAO::VAO(Renderer *owner_):
     owner(owner_)
 {
@@ -1092,6 +1177,17 @@ GLuint Renderer::get_active_UBO_id(Passkey<UBO>)
 {
     return Shaders.active_UBO_id;
 }
+std::unique_ptr<BufferRing> Renderer::make_buffer_ring(GLuint size, GLuint max_range_size)
+{
+    if(!GLAD_GL_VERSION_4_4)
+        return nullptr;
+    auto ring = std::unique_ptr<BufferRing>(new BufferRing(size, max_range_size));
+    if(ring->mapped == nullptr) {
+        log_error("couldn't map a BufferRing");
+        return nullptr;
+    }
+    return ring;
+}
 
 void Renderer::bind_VAO(const VAO &vao)
 {
@@ -1116,6 +1212,22 @@ void Renderer::bind_UB_base(GLuint index, const UBO &ubo)
 {
     glBindBufferBase(GL_UNIFORM_BUFFER, index, ubo.buffer.id);
 }
+void Renderer::bind_UB_range(GLuint index, const BufferRing &ring, GLuint offset, GLuint size)
+{
+    k_expects(offset % ring.alignment == 0);
+    k_expects(offset <= ring.size && size <= ring.max_range_size);
+    glBindBufferRange(GL_UNIFORM_BUFFER, index, ring.buffer.id, offset, size);
+}
+void Renderer::bind_SSB_range(GLuint index, const BufferRing &ring, GLuint offset, GLuint size)
+{
+    k_expects(offset % ring.alignment == 0);
+    k_expects(offset + size <= ring.size + ring.max_range_size);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, ring.buffer.id, offset, size);
+}
+bool Renderer::supports_SSBOs() const
+{
+    return GLAD_GL_VERSION_4_3;
+}
 void Renderer::use_shader_program(const ShaderProgram &program)
 {
     if(program.program.id != Shaders.cur_program) {
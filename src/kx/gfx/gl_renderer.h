@@ -164,6 +164,7 @@ class FragShader final: public Shader
 
 using UniformLoc = int;
 using UBIndex = uint32_t;
+using SSBIndex = uint32_t;
 
 class ShaderProgram
 {
@@ -191,6 +192,10 @@ public:
     UBIndex get_UB_index(const char *name);
 
     void bind_UB(UBIndex ub_index, uint32_t binding);
+
+    SSBIndex get_SSB_index(const char *name);
+
+    void bind_SSB(SSBIndex ssb_index, uint32_t binding);
 };
 
 template<_BufferType T> class Buffer final
@@ -217,6 +222,46 @@ using VBO = Buffer<_BufferType::VBO>;
 using EBO = Buffer<_BufferType::EBO>;
 using UBO = Buffer<_BufferType::UBO>;
 
+/** A buffer that stays mapped, for shader data that's rewritten every frame. Data is written
+ *  straight into the mapping, at ranges that are handed out like a ring buffer, so there's
+ *  no copy through the driver and no orphaning. A range is only handed out again once the
+ *  GPU is done with the draw calls that read it, which is tracked with fences.
+ *  Bind ranges of it with Renderer::bind_UB_range() or Renderer::bind_SSB_range().
+ */
+class BufferRing final
+{
+    friend class Renderer;
+
+    struct Fence
+    {
+        void *sync; //actually a GLsync
+        uint32_t begin; //the data it covers goes from here to the next fence's begin
+    };
+
+    _GLUniqueObj<_GLDeleteBuffer> buffer;
+    uint8_t *mapped;
+    uint32_t size; //what alloc() hands out; the buffer has max_range_size more at the end
+    uint32_t max_range_size;
+    uint32_t alignment; //enough for both UBO and SSBO ranges
+    uint32_t head; //the end of the last allocation
+    uint32_t unfenced_begin; //the start of the data that no fence covers yet
+    std::deque<Fence> fences; //oldest first
+
+    BufferRing(uint32_t size_, uint32_t max_range_size_);
+    bool overlaps_live_data(uint32_t begin, uint32_t n) const;
+    void wait_oldest();
+public:
+    ~BufferRing();
+    BufferRing(const BufferRing&) = delete;
+    BufferRing &operator = (const BufferRing&) = delete;
+
+    ///returns where to write n bytes, which are at offset in the buffer; this blocks if
+    ///the GPU hasn't finished reading that part of the buffer yet
+    uint8_t *alloc(uint32_t n, uint32_t *offset);
+    ///call this after the draw calls that read what was allocated so far
+    void fence();
+};
+
 class VAO final
 {
     friend class Renderer;
@@ -466,6 +511,10 @@ public:
         {return std::unique_ptr<EBO>(new EBO(this, std::forward<Args>(args)...));}
     template<class ...Args> std::unique_ptr<UBO> make_UBO(Args &&...args)
         {return std::unique_ptr<UBO>(new UBO(this, std::forward<Args>(args)...));}
+    /** Ranges of up to max_range_size bytes can be bound as UBOs, starting anywhere in the
+     *  first size bytes. Returns nullptr if persistent mapping isn't supported (before GL 4.4).
+     */
+    std::unique_ptr<BufferRing> make_buffer_ring(uint32_t size, uint32_t max_range_size);
 
     template<class ...Args> std::unique_ptr<VertShader> make_vert_shader(Args &&...args)
         {return std::unique_ptr<VertShader>(new VertShader(std::forward<Args>(args)...));}
@@ -484,6 +533,10 @@ public:
     void bind_EBO(const EBO&);
     void bind_UBO(const UBO&);
     void bind_UB_base(uint32_t index, const UBO&);
+    void bind_UB_range(uint32_t index, const BufferRing&, uint32_t offset, uint32_t size);
+    void bind_SSB_range(uint32_t index, const BufferRing&, uint32_t offset, uint32_t size);
+    ///SSBOs (GL 4.3) can hold much more than UBOs, and their last array can be unsized
+    bool supports_SSBOs() const;
     void use_shader_program(const ShaderProgram&);
     void draw_arrays(DrawMode mode, int first, int count);
     void draw_arrays_instanced(DrawMode mode, int first, int count, int instance_cnt);
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <vector>
 
 /** These are fast radix sorts that probably work on both ints and doubles.
  *  If you use them, you should double check their correctness to be sure.
@@ -31,6 +32,51 @@ void lsd_radix_sort64_u(T *aIn, int n)
     delete[] cnt;
     delete[] t;
 }
+/** Sorts keys like lsd_radix_sort64_u, and moves vals along with them. It's stable, so
+ *  equal keys keep their order. key_buf and val_buf are only used as scratch space, so it
+ *  doesn't allocate if they're kept around. Bytes that are the same in every key are
+ *  skipped, which is often most of them.
+ */
+template<class V>
+void lsd_radix_sort64_u_kv(uint64_t *keys, V *vals, int n,
+                           std::vector<uint64_t> *key_buf, std::vector<V> *val_buf)
+{
+    if(n <= 1)
+        return;
+    if((int)key_buf->size() < n)
+        key_buf->resize(n);
+    if((int)val_buf->size() < n)
+        val_buf->resize(n);
+
+    uint64_t *a = keys;
+    uint64_t *t = key_buf->data();
+    V *av = vals;
+    V *tv = val_buf->data();
+    int cnt[256];
+    for(int f=0; f<64; f+=8)
+    {
+        std::fill(cnt, cnt+256, 0);
+        for(int i=0; i<n; i++)
+            cnt[(a[i] >> f) & 0xff]++;
+        if(cnt[(a[0] >> f) & 0xff] == n)
+            continue;
+        for(int i=1; i<=0xff; i++)
+            cnt[i] += cnt[i-1];
+        for(int i=n-1; i>=0; i--)
+        {
+            int j = --cnt[(a[i] >> f) & 0xff];
+            t[j] = a[i];
+            tv[j] = av[i];
+        }
+        std::swap(a, t);
+        std::swap(av, tv);
+    }
+    if(a != keys)
+    {
+        std::copy(a, a+n, keys);
+        std::copy(av, av+n, vals);
+    }
+}
 template<class T>
 void lsd_radix_sort64(T *aIn, int n)
 {
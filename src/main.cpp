@@ -1,4 +1,5 @@
 #include "geo2/test.h"
+#include "geo2/benchmark.h"
 #include "geo2/master_instance.h"
 
 #include "kx/gfx/gfx.h"
@@ -11,9 +12,19 @@
 
 static_assert(sizeof(int) == 4);
 
-int main()
+int main(int argc, char **argv)
 {
     using namespace kx;
+
+    if(argc == 3 && std::string(argv[1]) == "--bench") {
+        std::ios::sync_with_stdio(false);
+        if(!geo2::run_benchmark(argv[2])) {
+            log_error("unknown benchmark " + std::string(argv[2]));
+            return 1;
+        }
+        return 0;
+    }
+
     gfx::GfxLibrary gfx_library;
     gfx::FontLibrary font_library;
     sfx::SfxLibrary sfx_library;
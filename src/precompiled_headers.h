@@ -3,6 +3,8 @@
 
 #ifdef __cplusplus
 
+#include "kx/atomic/lock_free_queue.h"
+#include "kx/atomic/lock_free_stack.h"
 #include "kx/atomic/queue.h"
 #include "kx/atomic/stack.h"
 #include "kx/atomic/string.h"